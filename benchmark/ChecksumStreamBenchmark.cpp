@@ -0,0 +1,44 @@
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "AntilatencySerialization/ChecksumStream.h"
+
+using namespace Antilatency::Serialization;
+
+template<typename Function>
+double measure(Function function, size_t iterations) {
+	auto start = std::chrono::high_resolution_clock::now();
+	for (size_t i = 0; i < iterations; ++i) {
+		function();
+	}
+	auto end = std::chrono::high_resolution_clock::now();
+	return std::chrono::duration<double, std::milli>(end - start).count() / iterations;
+}
+
+template<typename Function>
+void run(const char* name, const std::vector<uint8_t>& data, size_t iterations, Function function) {
+	uint32_t crc = Crc32c::Initial;
+	auto time = measure([&]() {
+		crc = function(crc, data.data(), data.size());
+	}, iterations);
+	auto megabytes = static_cast<double>(data.size()) / (1 << 20);
+	std::cout << name << ": " << megabytes / time * 1000 << " MB/s (" << crc << ")" << std::endl;
+}
+
+int main() {
+	static constexpr size_t Size = 1 << 20;
+	static constexpr size_t Iterations = 200;
+
+	std::mt19937 random(42);
+	std::vector<uint8_t> data(Size);
+	for (auto& item : data) {
+		item = static_cast<uint8_t>(random());
+	}
+
+	run("table", data, Iterations, Crc32c::updateTable);
+	run("instructions", data, Iterations, Crc32c::update);
+
+	return 0;
+}
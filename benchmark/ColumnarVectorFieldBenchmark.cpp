@@ -0,0 +1,84 @@
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "AntilatencySerialization/Fields.h"
+#include "AntilatencySerialization/Structures.h"
+#include "AntilatencySerialization/BinarySerialization.h"
+#include "AntilatencySerialization/ColumnarVectorField.h"
+#include "AntilatencySerialization/GrowableMemoryStream.h"
+
+using namespace Antilatency::Serialization;
+
+SERIALIZATION_MAKE_FIELD_NAME(PositionX);
+SERIALIZATION_MAKE_FIELD_NAME(PositionY);
+SERIALIZATION_MAKE_FIELD_NAME(Direction);
+SERIALIZATION_MAKE_FIELD_NAME(Bars);
+
+using Bar = Structure<Int32Field<PositionX>, Int32Field<PositionY>, Int32Field<Direction>>;
+
+using RowWise = Structure<VectorField<Bar, Bars>>;
+using Columnar = Structure<ColumnarVectorField<Bar, Bars>>;
+
+template<typename Function>
+double measure(Function function, size_t iterations) {
+	auto start = std::chrono::high_resolution_clock::now();
+	for (size_t i = 0; i < iterations; ++i) {
+		function();
+	}
+	auto end = std::chrono::high_resolution_clock::now();
+	return std::chrono::duration<double, std::milli>(end - start).count() / iterations;
+}
+
+template<typename T>
+void run(const char* name, const T& source, size_t iterations) {
+	GrowableMemoryStreamWriter growable;
+	BasicBinarySerializer<GrowableMemoryStreamWriter> growableSerializer(&growable);
+	growableSerializer.serialize(source);
+	std::vector<uint8_t> buffer(growable.size());
+
+	auto encodeTime = measure([&]() {
+		MemoryStreamWriter writer(buffer.data(), buffer.size());
+		BasicBinarySerializer<MemoryStreamWriter> serializer(&writer);
+		serializer.serialize(source);
+	}, iterations);
+
+	T dest;
+	bool isOk = true;
+	auto decodeTime = measure([&]() {
+		MemoryStreamReader reader(buffer.data(), buffer.size());
+		BasicBinaryDeserializer<MemoryStreamReader> deserializer(&reader);
+		isOk &= deserializer.deserialize(dest);
+	}, iterations);
+
+	std::cout << name << ": size = " << buffer.size()
+		<< " bytes, encode = " << encodeTime << " ms, decode = " << decodeTime << " ms"
+		<< (isOk ? "" : " FAILED") << std::endl;
+}
+
+int main() {
+	static constexpr size_t Count = 1 << 18;
+	static constexpr size_t Iterations = 20;
+
+	std::mt19937 random(42);
+
+	//Sorted positions, a shared row and random directions: one column of each encoding
+	std::vector<Bar> bars(Count);
+	for (size_t i = 0; i < Count; ++i) {
+		bars[i].get<PositionX>().setValue(static_cast<int32_t>(i * 16 + random() % 16));
+		bars[i].get<PositionY>().setValue(100);
+		bars[i].get<Direction>().setValue(static_cast<int32_t>(random()));
+	}
+
+	RowWise rowWise;
+	rowWise.get<Bars>().setValue(bars);
+	Columnar columnar;
+	columnar.get<Bars>().setValue(bars);
+
+	std::cout << Count << " structures" << std::endl;
+	run("row wise", rowWise, Iterations);
+	run("columnar", columnar, Iterations);
+
+	return 0;
+}
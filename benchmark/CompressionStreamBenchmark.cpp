@@ -0,0 +1,85 @@
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "AntilatencySerialization/Fields.h"
+#include "AntilatencySerialization/Structures.h"
+#include "AntilatencySerialization/BinarySerialization.h"
+#include "AntilatencySerialization/CompressionStream.h"
+#include "AntilatencySerialization/GrowableMemoryStream.h"
+
+using namespace Antilatency::Serialization;
+
+SERIALIZATION_MAKE_FIELD_NAME(Time);
+SERIALIZATION_MAKE_FIELD_NAME(Id);
+SERIALIZATION_MAKE_FIELD_NAME(X);
+SERIALIZATION_MAKE_FIELD_NAME(Y);
+SERIALIZATION_MAKE_FIELD_NAME(Z);
+SERIALIZATION_MAKE_FIELD_NAME(Samples);
+
+using Sample = Structure<SingleField<uint32_t, Time>, SingleField<uint8_t, Id>, SingleField<float, X>, SingleField<float, Y>, SingleField<float, Z>>;
+using Log = Structure<VectorField<Sample, Samples>>;
+
+template<typename Function>
+double measure(Function function, size_t iterations) {
+	auto start = std::chrono::high_resolution_clock::now();
+	for (size_t i = 0; i < iterations; ++i) {
+		function();
+	}
+	auto end = std::chrono::high_resolution_clock::now();
+	return std::chrono::duration<double, std::milli>(end - start).count() / iterations;
+}
+
+int main() {
+	static constexpr size_t Count = 1 << 16;
+	static constexpr size_t Iterations = 20;
+
+	std::mt19937 random(42);
+
+	//Tracking log: increasing time, a handful of ids and slowly moving positions
+	Log log;
+	auto& samples = log.get<Samples>().getValue();
+	samples.resize(Count);
+	float position[3] = {};
+	for (size_t i = 0; i < Count; ++i) {
+		samples[i].get<Time>().setValue(static_cast<uint32_t>(i * 10));
+		samples[i].get<Id>().setValue(static_cast<uint8_t>(i % 4));
+		for (auto& axis : position) {
+			axis += static_cast<float>(static_cast<int>(random() % 3) - 1) * 0.001f;
+		}
+		samples[i].get<X>().setValue(position[0]);
+		samples[i].get<Y>().setValue(position[1]);
+		samples[i].get<Z>().setValue(position[2]);
+	}
+
+	GrowableMemoryStreamWriter plain;
+	BinarySerializer plainSerializer(&plain);
+	plainSerializer.serialize(log);
+
+	GrowableMemoryStreamWriter compressed;
+	auto encodeTime = measure([&]() {
+		compressed.reset();
+		CompressingStreamWriter compressor(&compressed);
+		BinarySerializer serializer(&compressor);
+		serializer.serialize(log);
+		compressor.flush();
+	}, Iterations);
+
+	Log dest;
+	bool isOk = true;
+	auto decodeTime = measure([&]() {
+		MemoryStreamReader reader(compressed.data(), compressed.size());
+		DecompressingStreamReader decompressor(&reader);
+		BinaryDeserializer deserializer(&decompressor);
+		isOk &= deserializer.deserialize(dest);
+	}, Iterations);
+
+	auto megabytes = static_cast<double>(plain.size()) / (1 << 20);
+	std::cout << Count << " samples, " << plain.size() << " -> " << compressed.size() << " bytes" << std::endl;
+	std::cout << "compress = " << encodeTime << " ms (" << megabytes / encodeTime * 1000 << " MB/s), "
+		<< "decompress = " << decodeTime << " ms (" << megabytes / decodeTime * 1000 << " MB/s)"
+		<< (isOk ? "" : " FAILED") << std::endl;
+
+	return 0;
+}
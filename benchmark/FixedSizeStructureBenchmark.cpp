@@ -0,0 +1,78 @@
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "AntilatencySerialization/Fields.h"
+#include "AntilatencySerialization/Structures.h"
+#include "AntilatencySerialization/BinarySerialization.h"
+#include "AntilatencySerialization/GrowableMemoryStream.h"
+
+using namespace Antilatency::Serialization;
+
+SERIALIZATION_MAKE_FIELD_NAME(PositionX);
+SERIALIZATION_MAKE_FIELD_NAME(PositionY);
+SERIALIZATION_MAKE_FIELD_NAME(Direction);
+
+using Bar = Structure<Int32Field<PositionX>, Int32Field<PositionY>, Int32Field<Direction>>;
+
+//Derived type is not matched by the fixed-size path, every field is written separately
+class PerFieldBar : public Bar {};
+
+template<typename Function>
+double measure(Function function, size_t iterations) {
+	auto start = std::chrono::high_resolution_clock::now();
+	for (size_t i = 0; i < iterations; ++i) {
+		function();
+	}
+	auto end = std::chrono::high_resolution_clock::now();
+	return std::chrono::duration<double, std::milli>(end - start).count() / iterations;
+}
+
+template<typename T>
+void run(const char* name, const T& source, size_t iterations) {
+	GrowableMemoryStreamWriter growable;
+	BasicBinarySerializer<GrowableMemoryStreamWriter> growableSerializer(&growable);
+	growableSerializer.serialize(source);
+	std::vector<uint8_t> buffer(growable.size());
+
+	auto encodeTime = measure([&]() {
+		MemoryStreamWriter writer(buffer.data(), buffer.size());
+		BasicBinarySerializer<MemoryStreamWriter> serializer(&writer);
+		serializer.serialize(source);
+	}, iterations);
+
+	T dest;
+	bool isOk = true;
+	auto decodeTime = measure([&]() {
+		MemoryStreamReader reader(buffer.data(), buffer.size());
+		BasicBinaryDeserializer<MemoryStreamReader> deserializer(&reader);
+		isOk &= deserializer.deserialize(dest);
+	}, iterations);
+
+	std::cout << name << ": size = " << buffer.size()
+		<< " bytes, encode = " << encodeTime << " ms, decode = " << decodeTime << " ms"
+		<< (isOk ? "" : " FAILED") << std::endl;
+}
+
+int main() {
+	static constexpr size_t Count = 1 << 18;
+	static constexpr size_t Iterations = 20;
+
+	std::mt19937 random(42);
+
+	std::vector<Bar> bars(Count);
+	std::vector<PerFieldBar> perFieldBars(Count);
+	for (size_t i = 0; i < Count; ++i) {
+		bars[i].get<PositionX>().setValue(static_cast<int32_t>(random()));
+		bars[i].get<PositionY>().setValue(static_cast<int32_t>(random()));
+		bars[i].get<Direction>().setValue(static_cast<int32_t>(random()));
+		static_cast<Bar&>(perFieldBars[i]) = bars[i];
+	}
+
+	std::cout << Count << " structures" << std::endl;
+	run("per field", perFieldBars, Iterations);
+	run("fixed size", bars, Iterations);
+
+	return 0;
+}
@@ -0,0 +1,65 @@
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "AntilatencySerialization/BinarySerialization.h"
+#include "AntilatencySerialization/GrowableMemoryStream.h"
+#include "AntilatencySerialization/PackedIntegerVector.h"
+
+using namespace Antilatency::Serialization;
+
+template<typename Function>
+double measure(Function function, size_t iterations) {
+	auto start = std::chrono::high_resolution_clock::now();
+	for (size_t i = 0; i < iterations; ++i) {
+		function();
+	}
+	auto end = std::chrono::high_resolution_clock::now();
+	return std::chrono::duration<double, std::milli>(end - start).count() / iterations;
+}
+
+template<typename T>
+void run(const char* name, const T& source, size_t iterations) {
+	GrowableMemoryStreamWriter writer;
+	BasicBinarySerializer<GrowableMemoryStreamWriter> serializer(&writer);
+
+	auto encodeTime = measure([&]() {
+		writer.reset();
+		serializer.serialize(source);
+	}, iterations);
+
+	T dest;
+	bool isOk = true;
+	auto decodeTime = measure([&]() {
+		MemoryStreamReader reader(writer.data(), writer.size());
+		BasicBinaryDeserializer<MemoryStreamReader> deserializer(&reader);
+		isOk &= deserializer.deserialize(dest);
+	}, iterations);
+
+	std::cout << name << ": size = " << writer.size()
+		<< " bytes, encode = " << encodeTime << " ms, decode = " << decodeTime << " ms"
+		<< (isOk ? "" : " FAILED") << std::endl;
+}
+
+int main() {
+	static constexpr size_t Count = 1 << 20;
+	static constexpr size_t Iterations = 20;
+
+	std::mt19937 random(42);
+	std::geometric_distribution<uint32_t> distribution(0.001);
+
+	std::vector<Varint32> varints;
+	PackedIntegerVector<uint32_t> packed;
+	for (size_t i = 0; i < Count; ++i) {
+		auto value = distribution(random);
+		varints.push_back(Varint32(value));
+		packed.push_back(value);
+	}
+
+	std::cout << Count << " integers" << std::endl;
+	run("std::vector<Varint32>", varints, Iterations);
+	run("PackedIntegerVector<uint32_t>", packed, Iterations);
+
+	return 0;
+}
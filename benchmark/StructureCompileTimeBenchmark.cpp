@@ -0,0 +1,64 @@
+//Compile-time benchmark: the build time of this file is the measurement,
+//e.g. "time cmake --build . --target StructureCompileTimeBenchmark".
+//It declares a 128-field structure, looks up every field by name and serializes it.
+#include <iostream>
+
+#include "AntilatencySerialization/Fields.h"
+#include "AntilatencySerialization/Structures.h"
+#include "AntilatencySerialization/BinarySerialization.h"
+
+using namespace Antilatency::Serialization;
+
+#define BENCHMARK_NAMES_8(prefix) \
+	SERIALIZATION_MAKE_FIELD_NAME(prefix##0); SERIALIZATION_MAKE_FIELD_NAME(prefix##1); \
+	SERIALIZATION_MAKE_FIELD_NAME(prefix##2); SERIALIZATION_MAKE_FIELD_NAME(prefix##3); \
+	SERIALIZATION_MAKE_FIELD_NAME(prefix##4); SERIALIZATION_MAKE_FIELD_NAME(prefix##5); \
+	SERIALIZATION_MAKE_FIELD_NAME(prefix##6); SERIALIZATION_MAKE_FIELD_NAME(prefix##7)
+
+#define BENCHMARK_FIELDS_8(prefix) \
+	Int32Field<prefix##0>, SingleField<Varint32, prefix##1>, Int32Field<prefix##2>, SingleField<float, prefix##3>, \
+	Int32Field<prefix##4>, SingleField<Varint32, prefix##5>, Int32Field<prefix##6>, SingleField<float, prefix##7>
+
+#define BENCHMARK_SET_8(value, prefix, base) \
+	value.get<prefix##0>().setValue(base + 0); value.get<prefix##1>().setValue(Varint32(base + 1)); \
+	value.get<prefix##2>().setValue(base + 2); value.get<prefix##3>().setValue(base + 3.0f); \
+	value.get<prefix##4>().setValue(base + 4); value.get<prefix##5>().setValue(Varint32(base + 5)); \
+	value.get<prefix##6>().setValue(base + 6); value.get<prefix##7>().setValue(base + 7.0f)
+
+BENCHMARK_NAMES_8(A); BENCHMARK_NAMES_8(B); BENCHMARK_NAMES_8(C); BENCHMARK_NAMES_8(D);
+BENCHMARK_NAMES_8(E); BENCHMARK_NAMES_8(F); BENCHMARK_NAMES_8(G); BENCHMARK_NAMES_8(H);
+BENCHMARK_NAMES_8(I); BENCHMARK_NAMES_8(J); BENCHMARK_NAMES_8(K); BENCHMARK_NAMES_8(L);
+BENCHMARK_NAMES_8(M); BENCHMARK_NAMES_8(N); BENCHMARK_NAMES_8(O); BENCHMARK_NAMES_8(P);
+
+using Telemetry = Structure<
+	BENCHMARK_FIELDS_8(A), BENCHMARK_FIELDS_8(B), BENCHMARK_FIELDS_8(C), BENCHMARK_FIELDS_8(D),
+	BENCHMARK_FIELDS_8(E), BENCHMARK_FIELDS_8(F), BENCHMARK_FIELDS_8(G), BENCHMARK_FIELDS_8(H),
+	BENCHMARK_FIELDS_8(I), BENCHMARK_FIELDS_8(J), BENCHMARK_FIELDS_8(K), BENCHMARK_FIELDS_8(L),
+	BENCHMARK_FIELDS_8(M), BENCHMARK_FIELDS_8(N), BENCHMARK_FIELDS_8(O), BENCHMARK_FIELDS_8(P)
+>;
+
+static_assert(Telemetry::FieldCount == 128, "Wrong field count");
+
+int main() {
+	Telemetry value;
+	BENCHMARK_SET_8(value, A, 0); BENCHMARK_SET_8(value, B, 8); BENCHMARK_SET_8(value, C, 16); BENCHMARK_SET_8(value, D, 24);
+	BENCHMARK_SET_8(value, E, 32); BENCHMARK_SET_8(value, F, 40); BENCHMARK_SET_8(value, G, 48); BENCHMARK_SET_8(value, H, 56);
+	BENCHMARK_SET_8(value, I, 64); BENCHMARK_SET_8(value, J, 72); BENCHMARK_SET_8(value, K, 80); BENCHMARK_SET_8(value, L, 88);
+	BENCHMARK_SET_8(value, M, 96); BENCHMARK_SET_8(value, N, 104); BENCHMARK_SET_8(value, O, 112); BENCHMARK_SET_8(value, P, 120);
+
+	MemorySizeCounterStream counterStream;
+	BasicBinarySerializer<MemorySizeCounterStream> serializer(&counterStream);
+	serializer.serialize(value);
+
+	Telemetry dest;
+	uint8_t buffer[1024];
+	MemoryStreamWriter writer(buffer, sizeof(buffer));
+	BasicBinarySerializer<MemoryStreamWriter> bufferSerializer(&writer);
+	MemoryStreamReader reader(buffer, sizeof(buffer));
+	BasicBinaryDeserializer<MemoryStreamReader> deserializer(&reader);
+	bool isOk = bufferSerializer.serialize(value) && deserializer.deserialize(dest) &&
+		dest.get<P7>().getValue() == value.get<P7>().getValue();
+
+	std::cout << Telemetry::FieldCount << " fields, " << counterStream.getActualSize() << " bytes" << (isOk ? "" : " FAILED") << std::endl;
+	return isOk ? 0 : 1;
+}
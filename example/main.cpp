@@ -9,6 +9,7 @@
 #include "AntilatencySerialization/OstreamSerialization.h"
 
 #include "AntilatencySerialization/UserStream.h"
+#include "AntilatencySerialization/GrowableMemoryStream.h"
 
 namespace Bar {
 	SERIALIZATION_MAKE_FIELD_NAME(PositionX);
@@ -188,6 +189,26 @@ size_t testUserStream(const Environment0::Environment& env0) {
 	return 0;
 }
 
+size_t testGrowableStream(const Environment0::Environment& env0) {
+	Antilatency::Serialization::OstreamSerializer ioSerializer(std::cout);
+	ioSerializer.serialize(env0);
+	std::cout << std::endl;
+
+	Antilatency::Serialization::GrowableMemoryStreamWriter growableWriter;
+	Antilatency::Serialization::BinarySerializer binSerializer(&growableWriter);
+	if (binSerializer.serialize(env0)) {
+		Antilatency::Serialization::MemoryStreamReader memoryStreamReader(growableWriter.data(), growableWriter.size());
+		Antilatency::Serialization::BinaryDeserializer binDeserializer(&memoryStreamReader);
+		Environment1::Environment env1;
+		if (binDeserializer.deserialize(env1)) {
+			ioSerializer.serialize(env1);
+			std::cout << std::endl;
+			return growableWriter.size();
+		}
+	}
+	return 0;
+}
+
 void testConst(const Environment0::Environment environment) {
 	using namespace Environment0;
 	auto& name = environment.get<Name>().getValue();
@@ -215,6 +236,7 @@ int main()
 	std::cout << "Binary size = " << testBinarySerialization(environment) << std::endl << std::endl;
 	std::cout << "Base64 size = " << testBase64Serialization(environment) << std::endl << std::endl;
 	std::cout << "User stream size = " << testUserStream(environment) << std::endl << std::endl;
+	std::cout << "Growable stream size = " << testGrowableStream(environment) << std::endl << std::endl;
 
 	testConst(environment);
 
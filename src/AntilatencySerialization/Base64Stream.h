@@ -4,8 +4,13 @@
 #include <stdint.h>
 #include <stddef.h>
 
+#include "BaseTypes.h"
 #include "StreamSerialization.h"
 
+#if defined(ANTILATENCY_SERIALIZATION_SSSE3)
+	#include <tmmintrin.h>
+#endif
+
 namespace Antilatency {
 	namespace Serialization {
 
@@ -37,6 +42,139 @@ namespace Antilatency {
 				isOk = false;
 				return 0;
 			}
+
+			static constexpr uint8_t InvalidSymbol = 0xFF;
+
+			struct Alphabet {
+				uint8_t toChar[64];
+				uint8_t fromChar[256];
+			};
+
+			constexpr Alphabet makeAlphabet(const char (&symbols)[65]) {
+				Alphabet alphabet{};
+				for (size_t i = 0; i < 256; ++i) {
+					alphabet.fromChar[i] = InvalidSymbol;
+				}
+				for (size_t i = 0; i < 64; ++i) {
+					alphabet.toChar[i] = static_cast<uint8_t>(symbols[i]);
+					alphabet.fromChar[static_cast<uint8_t>(symbols[i])] = static_cast<uint8_t>(i);
+				}
+				return alphabet;
+			}
+
+			static constexpr Alphabet StandardAlphabet = makeAlphabet(LookupTableToChar);
+			static constexpr Alphabet UrlAlphabet = makeAlphabet("ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_");
+
+			//Every 3 bytes become 4 symbols
+			inline void encodeGroup(const Alphabet& alphabet, const uint8_t* data, uint8_t* symbols) {
+				uint32_t value = (static_cast<uint32_t>(data[0]) << 16) | (static_cast<uint32_t>(data[1]) << 8) | data[2];
+				symbols[0] = alphabet.toChar[(value >> 18) & Mask];
+				symbols[1] = alphabet.toChar[(value >> 12) & Mask];
+				symbols[2] = alphabet.toChar[(value >> 6) & Mask];
+				symbols[3] = alphabet.toChar[value & Mask];
+			}
+
+			inline bool decodeGroup(const Alphabet& alphabet, const uint8_t* symbols, uint8_t* data) {
+				uint8_t a = alphabet.fromChar[symbols[0]];
+				uint8_t b = alphabet.fromChar[symbols[1]];
+				uint8_t c = alphabet.fromChar[symbols[2]];
+				uint8_t d = alphabet.fromChar[symbols[3]];
+				if ((a | b | c | d) & 0xC0) {
+					return false;
+				}
+				uint32_t value = (static_cast<uint32_t>(a) << 18) | (static_cast<uint32_t>(b) << 12) | (static_cast<uint32_t>(c) << 6) | d;
+				data[0] = static_cast<uint8_t>(value >> 16);
+				data[1] = static_cast<uint8_t>(value >> 8);
+				data[2] = static_cast<uint8_t>(value);
+				return true;
+			}
+
+		#if defined(ANTILATENCY_SERIALIZATION_SSSE3)
+			//12 bytes from a 16 byte load to 16 symbols
+			inline __m128i encodeSimd(__m128i data, char symbol62, char symbol63) {
+				data = _mm_shuffle_epi8(data, _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+				__m128i t0 = _mm_and_si128(data, _mm_set1_epi32(0x0fc0fc00));
+				__m128i t1 = _mm_mulhi_epu16(t0, _mm_set1_epi32(0x04000040));
+				__m128i t2 = _mm_and_si128(data, _mm_set1_epi32(0x003f03f0));
+				__m128i t3 = _mm_mullo_epi16(t2, _mm_set1_epi32(0x01000010));
+				__m128i indices = _mm_or_si128(t1, t3);
+
+				//0..25 -> 13, 26..51 -> 0, 52..61 -> 1..10, 62 -> 11, 63 -> 12
+				__m128i shiftIndices = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+				__m128i isUpper = _mm_cmpgt_epi8(_mm_set1_epi8(26), indices);
+				shiftIndices = _mm_or_si128(shiftIndices, _mm_and_si128(isUpper, _mm_set1_epi8(13)));
+				__m128i shifts = _mm_setr_epi8(
+					'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+					'0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, static_cast<char>(symbol62 - 62),
+					static_cast<char>(symbol63 - 63), 'A', 0, 0);
+				return _mm_add_epi8(_mm_shuffle_epi8(shifts, shiftIndices), indices);
+			}
+
+			//16 symbols to 12 bytes in the low part, false if any symbol is invalid
+			inline bool decodeSimd(__m128i symbols, char symbol62, char symbol63, __m128i& data) {
+				auto inRange = [&symbols](char first, char last) {
+					return _mm_and_si128(_mm_cmpgt_epi8(symbols, _mm_set1_epi8(first - 1)), _mm_cmplt_epi8(symbols, _mm_set1_epi8(last + 1)));
+				};
+				__m128i isUpper = inRange('A', 'Z');
+				__m128i isLower = inRange('a', 'z');
+				__m128i isDigit = inRange('0', '9');
+				__m128i is62 = _mm_cmpeq_epi8(symbols, _mm_set1_epi8(symbol62));
+				__m128i is63 = _mm_cmpeq_epi8(symbols, _mm_set1_epi8(symbol63));
+				__m128i isValid = _mm_or_si128(_mm_or_si128(isUpper, isLower), _mm_or_si128(isDigit, _mm_or_si128(is62, is63)));
+				if (_mm_movemask_epi8(isValid) != 0xFFFF) {
+					return false;
+				}
+				__m128i shifts = _mm_and_si128(isUpper, _mm_set1_epi8(-'A'));
+				shifts = _mm_or_si128(shifts, _mm_and_si128(isLower, _mm_set1_epi8(26 - 'a')));
+				shifts = _mm_or_si128(shifts, _mm_and_si128(isDigit, _mm_set1_epi8(52 - '0')));
+				shifts = _mm_or_si128(shifts, _mm_and_si128(is62, _mm_set1_epi8(static_cast<char>(62 - symbol62))));
+				shifts = _mm_or_si128(shifts, _mm_and_si128(is63, _mm_set1_epi8(static_cast<char>(63 - symbol63))));
+				__m128i values = _mm_add_epi8(symbols, shifts);
+
+				__m128i pairs = _mm_maddubs_epi16(values, _mm_set1_epi32(0x01400140));
+				__m128i words = _mm_madd_epi16(pairs, _mm_set1_epi32(0x00011000));
+				data = _mm_shuffle_epi8(words, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+				return true;
+			}
+		#endif
+
+			//Encodes groups * 3 bytes to groups * 4 symbols
+			inline void encodeBlock(const Alphabet& alphabet, const uint8_t* data, size_t groups, uint8_t* symbols) {
+				size_t i = 0;
+		#if defined(ANTILATENCY_SERIALIZATION_SSSE3)
+				//16 byte loads must stay inside the data
+				for (; i + 6 <= groups; i += 4) {
+					__m128i encoded = encodeSimd(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 3 * i)), alphabet.toChar[62], alphabet.toChar[63]);
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(symbols + 4 * i), encoded);
+				}
+		#endif
+				for (; i < groups; ++i) {
+					encodeGroup(alphabet, data + 3 * i, symbols + 4 * i);
+				}
+			}
+
+			//Decodes groups * 4 symbols to groups * 3 bytes, false if any symbol is invalid
+			inline bool decodeBlock(const Alphabet& alphabet, const uint8_t* symbols, size_t groups, uint8_t* data) {
+				size_t i = 0;
+		#if defined(ANTILATENCY_SERIALIZATION_SSSE3)
+				//16 byte stores must stay inside the data
+				for (; i + 6 <= groups; i += 4) {
+					__m128i decoded;
+					if (!decodeSimd(_mm_loadu_si128(reinterpret_cast<const __m128i*>(symbols + 4 * i)), alphabet.toChar[62], alphabet.toChar[63], decoded)) {
+						return false;
+					}
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(data + 3 * i), decoded);
+				}
+		#endif
+				for (; i < groups; ++i) {
+					if (!decodeGroup(alphabet, symbols + 4 * i, data + 3 * i)) {
+						return false;
+					}
+				}
+				return true;
+			}
+
+			static constexpr size_t ChunkGroups = 128;
 		}
 
         namespace Base64UrlConverterSymbols {
@@ -48,221 +186,232 @@ namespace Antilatency {
 
 		class Base64StreamReader final : public IStreamReader {
 		public:
-            explicit Base64StreamReader(IStreamReader* reader) : _reader(reader){
+			//Padding is never read, so padded and unpadded input are both accepted
+			explicit Base64StreamReader(IStreamReader* reader, const Base64::Alphabet& alphabet = Base64::StandardAlphabet) :
+				_reader(reader),
+				_alphabet(alphabet)
+			{
+
+			}
+
+			bool read(uint8_t* buffer, size_t size) override{
+				if (_stopStream) {
+					return false;
+				}
+				size_t i = 0;
+				for (; i < size && _currentPosition % 3 != 0; ++i) {
+					if (!getSym(buffer[i])) {
+						return false;
+					}
+				}
 
-            }
+				//Whole groups are read and decoded in blocks
+				uint8_t symbols[4 * Base64::ChunkGroups];
+				while (size - i >= 3) {
+					auto groups = (size - i) / 3;
+					if (groups > Base64::ChunkGroups) {
+						groups = Base64::ChunkGroups;
+					}
+					if (!_reader->read(symbols, 4 * groups) || !Base64::decodeBlock(_alphabet, symbols, groups, buffer + i)) {
+						_stopStream = true;
+						return false;
+					}
+					i += 3 * groups;
+					_currentPosition += 3 * groups;
+				}
+
+				for (; i < size; ++i) {
+					if (!getSym(buffer[i])) {
+						return false;
+					}
+				}
+				return true;
+			}
 
 		private:
-            bool read(uint8_t* buffer, size_t size) override{
-                for(size_t i = 0; i < size; ++i) {
-                    uint8_t sym;
-                    getSym(sym);
-                    buffer[i] = sym;
-
-                    if (_stopStream) {
-                        return false;
-                    }
-                }
-                return true;
-            }
-		
-            void getSym(uint8_t& sym){
-                uint8_t firstSym;
-                uint8_t nextSym;
-
-                switch (_currentPosition % 3) {
-                case 0:
-                    getRealByte(firstSym);
-                    getRealByte(nextSym);
-                    _savedValue = nextSym;
-                    sym = (firstSym << 2) | ((nextSym >> 4) & 0x3);
-                    break;
-                case 1:
-                    getRealByte(firstSym);
-                    sym = (_savedValue << 4) | ((firstSym >> 2) & 0x0F);
-                    _savedValue = firstSym;
-                    break;
-                case 2:
-                    getRealByte(firstSym);
-                    sym = (_savedValue << 6) | (firstSym);
-                    _savedValue = 0;
-                    break;
-                default:
-                    assert(false);
-                }
-                if (!_stopStream) {
-                    ++_currentPosition;
-                }
-            }
-
-            void getRealByte(uint8_t& byte){
-                if (_reader->read(&byte, sizeof(uint8_t))) {
-                    bool isOk;
-                    byte = Base64::getPositionFromChar(byte, isOk);
-                    if(!isOk) {
-                        _stopStream = true;
-                    }
-                } else {
-                    _stopStream = true;
-                }
-            }
+			bool getSym(uint8_t& sym){
+				uint8_t firstSym;
+				uint8_t nextSym;
+
+				switch (_currentPosition % 3) {
+				case 0:
+					if (!getRealByte(firstSym) || !getRealByte(nextSym)) {
+						return false;
+					}
+					_savedValue = nextSym;
+					sym = (firstSym << 2) | ((nextSym >> 4) & 0x3);
+					break;
+				case 1:
+					if (!getRealByte(firstSym)) {
+						return false;
+					}
+					sym = (_savedValue << 4) | ((firstSym >> 2) & 0x0F);
+					_savedValue = firstSym;
+					break;
+				case 2:
+					if (!getRealByte(firstSym)) {
+						return false;
+					}
+					sym = (_savedValue << 6) | (firstSym);
+					_savedValue = 0;
+					break;
+				default:
+					assert(false);
+				}
+				++_currentPosition;
+				return true;
+			}
+
+			bool getRealByte(uint8_t& byte){
+				if (_reader->read(&byte, sizeof(uint8_t))) {
+					byte = _alphabet.fromChar[byte];
+					if (byte != Base64::InvalidSymbol) {
+						return true;
+					}
+				}
+				_stopStream = true;
+				return false;
+			}
 
 		private:
 			uint8_t _savedValue = 0;
 			size_t _currentPosition = 0;
 			bool _stopStream = false;
 			IStreamReader* _reader;
+			const Base64::Alphabet& _alphabet;
 		};
 
 
 		class Base64StreamWriter final : public IStreamWriter {
 		public:
-			explicit Base64StreamWriter(IStreamWriter* writer) :
-				_writer(writer)
+			explicit Base64StreamWriter(IStreamWriter* writer, const Base64::Alphabet& alphabet = Base64::StandardAlphabet, bool usePadding = true) :
+				_writer(writer),
+				_alphabet(alphabet),
+				_usePadding(usePadding)
 			{
 
 			}
-		
+
 			bool flush() {
-				if(_isSaved) {
-					if(!processStage(0, true)) {
+				if (_savedSize == 0) {
+					return true;
+				}
+				uint8_t symbols[4];
+				_saved[2] = 0;
+				if (_savedSize == 1) {
+					_saved[1] = 0;
+				}
+				Base64::encodeGroup(_alphabet, _saved, symbols);
+				for (size_t i = _savedSize + 1; i < 4; ++i) {
+					symbols[i] = Base64::PaddingSymbol;
+				}
+				auto symbolsSize = _usePadding ? sizeof(symbols) : _savedSize + 1;
+				_savedSize = 0;
+				return _writer->write(symbols, symbolsSize);
+			}
+
+			bool write(const uint8_t* buffer, size_t size) override {
+				if (_savedSize != 0) {
+					while (_savedSize < 3 && size > 0) {
+						_saved[_savedSize++] = *buffer++;
+						--size;
+					}
+					if (_savedSize < 3) {
+						return true;
+					}
+					_savedSize = 0;
+					uint8_t symbols[4];
+					Base64::encodeGroup(_alphabet, _saved, symbols);
+					if (!_writer->write(symbols, sizeof(symbols))) {
 						return false;
 					}
 				}
-				while (_currentPosition % 3 != 0) {
-					if(!_writer->write(reinterpret_cast<const uint8_t*>(&Base64::PaddingSymbol), sizeof(char))) {
+
+				//Whole groups are encoded in blocks and written at once
+				uint8_t symbols[4 * Base64::ChunkGroups];
+				while (size >= 3) {
+					auto groups = size / 3;
+					if (groups > Base64::ChunkGroups) {
+						groups = Base64::ChunkGroups;
+					}
+					Base64::encodeBlock(_alphabet, buffer, groups, symbols);
+					if (!_writer->write(symbols, 4 * groups)) {
 						return false;
 					}
-					++_currentPosition;
+					buffer += 3 * groups;
+					size -= 3 * groups;
+				}
+
+				for (size_t i = 0; i < size; ++i) {
+					_saved[_savedSize++] = buffer[i];
 				}
 				return true;
 			}
-			
+
 		private:
-			bool write(const uint8_t* buffer, size_t size) override {
+			uint8_t _saved[3] = {};
+			size_t _savedSize = 0;
+			IStreamWriter* _writer;
+			const Base64::Alphabet& _alphabet;
+			bool _usePadding;
+		};
+
+		//Kept for compatibility, Base64StreamReader/Base64StreamWriter with Base64::UrlAlphabet do the same in one pass
+		class Base64UrlConverterReader final : public IStreamReader {
+		public:
+			explicit Base64UrlConverterReader(IStreamReader* reader) :
+				_reader(reader)
+			{
+
+			}
+
+			bool read(uint8_t* buffer, size_t size) override {
+				if (!_reader->read(buffer, size)) {
+					return false;
+				}
 				for (size_t i = 0; i < size; ++i) {
-					if(!processStage(buffer[i])) {
-						return false;
+					auto position = Base64::UrlAlphabet.fromChar[buffer[i]];
+					if (position >= 62 && position != Base64::InvalidSymbol) {
+						buffer[i] = Base64::StandardAlphabet.toChar[position];
 					}
 				}
 				return true;
 			}
 
-			bool processStage(uint8_t value, bool isFlush = false) {
-				uint8_t index;
-				switch (_currentPosition % 3) {
-				case 0:
-					index = (value & 0xfc) >> 2;
-					if(!_writer->write(reinterpret_cast<const uint8_t*>(&Base64::LookupTableToChar[index]), sizeof(uint8_t))) {
-						return false;
-					}
-					_savedValue = value;
-					_isSaved = true;
-					break;
-				case 1:
-					index = ((_savedValue & 0x03) << 4) + ((value & 0xf0) >> 4);
-					if(!_writer->write(reinterpret_cast<const uint8_t*>(&Base64::LookupTableToChar[index]), sizeof(uint8_t))) {
-						return false;
-					}
-					_savedValue = value;
-					_isSaved = true;
-					break;
-				case 2:
-					index = ((_savedValue & 0x0f) << 2) + ((value & 0xc0) >> 6);
-					if(!_writer->write(reinterpret_cast<const uint8_t*>(&Base64::LookupTableToChar[index]), sizeof(uint8_t))) {
-						return false;
+		private:
+			IStreamReader* _reader;
+		};
+
+		class Base64UrlConverterWriter final : public IStreamWriter {
+		public:
+			explicit Base64UrlConverterWriter(IStreamWriter* writer) :
+				_writer(writer)
+			{
+
+			}
+
+			bool write(const uint8_t* buffer, size_t size) override {
+				uint8_t converted[4 * Base64::ChunkGroups];
+				size_t convertedSize = 0;
+				for (size_t i = 0; i < size; ++i) {
+					if (buffer[i] == Base64::PaddingSymbol) {
+						continue;
 					}
-					if (!isFlush) {
-						index = value & 0x3f;
-						if(!_writer->write(reinterpret_cast<const uint8_t*>(&Base64::LookupTableToChar[index]), sizeof(uint8_t))) {
+					auto position = Base64::StandardAlphabet.fromChar[buffer[i]];
+					converted[convertedSize++] = position >= 62 && position != Base64::InvalidSymbol ? Base64::UrlAlphabet.toChar[position] : buffer[i];
+					if (convertedSize == sizeof(converted)) {
+						if (!_writer->write(converted, convertedSize)) {
 							return false;
 						}
+						convertedSize = 0;
 					}
-					_savedValue = 0;
-					_isSaved = false;
-					break;
-				default:
-					assert(false);
-				}
-				if (!isFlush) {
-					++_currentPosition;
 				}
-				return true;
+				return convertedSize == 0 || _writer->write(converted, convertedSize);
 			}
 
 		private:
-			size_t _currentPosition = 0;
-			uint8_t _savedValue = 0;
-			bool _isSaved = 0;
 			IStreamWriter* _writer;
 		};
-
-        class Base64UrlConverterReader final : public IStreamReader {
-        public:
-            explicit Base64UrlConverterReader(IStreamReader* reader) :
-                    _reader(reader)
-            {
-
-            }
-        private:
-            bool read(uint8_t* buffer, size_t size) override {
-                for(size_t i = 0; i < size; ++i) {
-
-                    uint8_t val;
-                    auto result = _reader->read(&val, sizeof(uint8_t));
-                    if(!result){
-                        return false;
-                    }
-
-                    auto convertStatus = false;
-                    for(size_t j = 0; j < Base64UrlConverterSymbols::SymbolsCount; j++) {
-                        if(val == static_cast<uint8_t>(Base64UrlConverterSymbols::PermittedSymbols[j])){
-                            buffer[i] = static_cast<uint8_t>(Base64UrlConverterSymbols::ProhibitedSymbols[j]);
-                            convertStatus = true;
-                        }
-                    }
-                    if(!convertStatus) {
-                        buffer[i] = val;
-                    }
-                }
-                return true;
-            }
-
-            IStreamReader* _reader;
-        };
-
-        class Base64UrlConverterWriter final : public IStreamWriter {
-        public:
-            explicit Base64UrlConverterWriter(IStreamWriter* writer) :
-                    _writer(writer)
-            {
-
-            }
-        private:
-            bool write(const uint8_t* buffer, size_t size) override {
-
-                for (size_t i = 0; i < size; ++i) {
-                    if(buffer[i] != '=') {
-                        auto result = false;
-                        auto convertStatus = false;
-                        for(size_t j = 0; j < Base64UrlConverterSymbols::SymbolsCount; j++){
-                            if(buffer[i] == static_cast<uint8_t>(Base64UrlConverterSymbols::ProhibitedSymbols[j])){
-                                result = _writer->write(reinterpret_cast<const uint8_t*>(&Base64UrlConverterSymbols::PermittedSymbols[j]), sizeof(uint8_t));
-                                convertStatus = true;
-                            }
-                        }
-                        if(!convertStatus){
-                            result = _writer->write(reinterpret_cast<const uint8_t*>(&buffer[i]), sizeof(uint8_t));
-                        }
-                        if(!result){
-                            return result;
-                        }
-                    }
-                }
-                return true;
-            }
-            IStreamWriter* _writer;
-        };
     }
 }
 
@@ -16,6 +16,34 @@
 
 #include <stdint.h>
 #include <stddef.h>
+#include <string.h>
+
+#include <assert.h>
+
+#if defined(_MSC_VER)
+	#include <stdlib.h>
+	#if !defined(__clang__)
+		#include <intrin.h>
+	#endif
+#endif
+
+#if defined(__SSSE3__) || defined(__AVX__)
+	#define ANTILATENCY_SERIALIZATION_SSSE3
+#endif
+
+//MSVC has no F16C macro, every AVX2 CPU has F16C
+#if defined(__F16C__) || (defined(_MSC_VER) && defined(__AVX2__))
+	#define ANTILATENCY_SERIALIZATION_F16C
+#endif
+
+//MSVC has no SSE4.2 macro, every AVX CPU has SSE4.2
+#if defined(__SSE4_2__) || (defined(_MSC_VER) && defined(__AVX__))
+	#define ANTILATENCY_SERIALIZATION_SSE42
+#endif
+
+#if defined(__ARM_FEATURE_CRC32)
+	#define ANTILATENCY_SERIALIZATION_ARM_CRC32
+#endif
 
 #if defined(ARDUINO)
 	#include "BasicVector.h"
@@ -28,24 +56,129 @@
 namespace Antilatency {
 	namespace Serialization {
 
-	template<typename T>
-	T swapBytes(const T& value) {
-		union {
-			T convertedValue;
-			uint8_t bytes[sizeof(T)];
+	namespace detail {
+		template<typename T, size_t Size = sizeof(T)>
+		struct ByteSwapper {
+			static T swap(const T& value) {
+				union {
+					T convertedValue;
+					uint8_t bytes[sizeof(T)];
+				};
+				convertedValue = value;
+
+				for(size_t i = 0; i < sizeof(T) / 2; ++i) {
+					//std::swap is not accesable
+					uint8_t temp = bytes[i];
+					bytes[i] = bytes[sizeof(T) - i - 1];
+					bytes[sizeof(T) - i - 1] = temp;
+				}
+				return convertedValue;
+			}
+		};
+
+		template<typename T>
+		struct ByteSwapper<T, 1> {
+			static T swap(const T& value) {
+				return value;
+			}
+		};
+
+	#if defined(__GNUC__) || defined(__clang__) || defined(_MSC_VER)
+		inline uint16_t byteSwap(uint16_t value) {
+		#if defined(_MSC_VER) && !defined(__clang__)
+			return _byteswap_ushort(value);
+		#else
+			return __builtin_bswap16(value);
+		#endif
+		}
+
+		inline uint32_t byteSwap(uint32_t value) {
+		#if defined(_MSC_VER) && !defined(__clang__)
+			return _byteswap_ulong(value);
+		#else
+			return __builtin_bswap32(value);
+		#endif
+		}
+
+		inline uint64_t byteSwap(uint64_t value) {
+		#if defined(_MSC_VER) && !defined(__clang__)
+			return _byteswap_uint64(value);
+		#else
+			return __builtin_bswap64(value);
+		#endif
+		}
+
+		template<typename T, typename UnsignedType>
+		struct IntrinsicByteSwapper {
+			static T swap(const T& value) {
+				UnsignedType temp;
+				memcpy(&temp, &value, sizeof(T));
+				temp = byteSwap(temp);
+				T result;
+				memcpy(&result, &temp, sizeof(T));
+				return result;
+			}
 		};
-		convertedValue = value;
 
-		for(size_t i = 0; i < sizeof(T); ++i) {
-			//std::swap is not accesable
-			uint8_t temp = bytes[i];
-			bytes[i] = bytes[sizeof(T) - i - 1];
-			bytes[sizeof(T) - i - 1] = temp;
+		template<typename T>
+		struct ByteSwapper<T, 2> : IntrinsicByteSwapper<T, uint16_t> {};
+
+		template<typename T>
+		struct ByteSwapper<T, 4> : IntrinsicByteSwapper<T, uint32_t> {};
+
+		template<typename T>
+		struct ByteSwapper<T, 8> : IntrinsicByteSwapper<T, uint64_t> {};
+	#endif
+	}
+
+	inline size_t countTrailingZeros(uint64_t value) {
+		assert(value != 0);
+	#if defined(__GNUC__) || defined(__clang__)
+		return static_cast<size_t>(__builtin_ctzll(value));
+	#elif defined(_MSC_VER) && defined(_M_X64)
+		unsigned long index;
+		_BitScanForward64(&index, value);
+		return index;
+	#else
+		size_t result = 0;
+		while ((value & 1) == 0) {
+			value >>= 1;
+			++result;
 		}
-		return convertedValue;
+		return result;
+	#endif
 	}
 
-	//Todo Specialization for base types: uint16_t, int16_t, uint32_t ...
+	inline size_t countLeadingZeros(uint64_t value) {
+		assert(value != 0);
+	#if defined(__GNUC__) || defined(__clang__)
+		return static_cast<size_t>(__builtin_clzll(value));
+	#elif defined(_MSC_VER) && defined(_M_X64)
+		unsigned long index;
+		_BitScanReverse64(&index, value);
+		return 63 - index;
+	#else
+		size_t result = 0;
+		while ((value & (static_cast<uint64_t>(1) << 63)) == 0) {
+			value <<= 1;
+			++result;
+		}
+		return result;
+	#endif
+	}
+
+	template<typename T>
+	T swapBytes(const T& value) {
+		return detail::ByteSwapper<T>::swap(value);
+	}
+
+	//Plain loop over bswap, vectorized by the compiler
+	template<typename T>
+	void swapBytes(T* values, size_t count) {
+		for (size_t i = 0; i < count; ++i) {
+			values[i] = swapBytes(values[i]);
+		}
+	}
 
 	#if defined(ARDUINO)
 		template<typename T>
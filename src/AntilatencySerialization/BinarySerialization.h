@@ -8,53 +8,54 @@
 #include <string.h>
 #include "Varint.h"
 #include "BaseTypes.h"
+#include "Span.h"
+#include "PackedIntegerVector.h"
+#include "Structures.h"
+#include "FixedSizeStructure.h"
 
 #include "StreamSerialization.h"
 
 namespace Antilatency {
 	namespace Serialization {
 
-#define SERIALIZATION_SERIALIZE_BASE_TYPE(type)  template<> inline bool BinarySerializer::serialize<type>(const type& value) { return write(value); }
-#define SERIALIZATION_DESERIALIZE_BASE_TYPE(type)  template<> inline bool BinaryDeserializer::deserialize<type>(type& value) { return read(value); }
+#define SERIALIZATION_SERIALIZE_BASE_TYPE(type) bool serialize(const type& value) { return write(value); }
+#define SERIALIZATION_DESERIALIZE_BASE_TYPE(type) bool deserialize(type& value) { return read(value); }
 
-#define SERIALIZATION_SERIALIZE_CONTAINER_BASE_TYPE(type) template<> inline bool BinarySerializer::serialize<type>(const BaseVectorType<type>& value) { return serializeNativeContainer<BaseVectorType<type>,type>(value, value.size()); }
+#define SERIALIZATION_SERIALIZE_CONTAINER_BASE_TYPE(type) bool serialize(const BaseVectorType<type>& value) { return serializeNativeContainer<BaseVectorType<type>,type>(value, value.size()); }
+#define SERIALIZATION_DESERIALIZE_CONTAINER_BASE_TYPE(type) bool deserialize(BaseVectorType<type>& value) { return deserializeNativeContainer<BaseVectorType<type>,type>(value); }
 
-#define SERIALIZATION_SERIALIZE_SIGNED_VARINT(type) template<> inline bool BinarySerializer::serialize<type>(const Varint<type>& value) { \
-			auto temp = value.getValue();\
-			if (temp < 0) {\
-				temp = (-temp << 1) - 1;\
-			}\
-			else {\
-				temp <<= 1;\
-			}\
-			return serialize(Varint<u##type>(temp));\
+#define SERIALIZATION_SERIALIZE_SIGNED_VARINT(type) bool serialize(const Varint<type>& value) { \
+			return serialize(Varint<u##type>(detail::zigzagEncode(value.getValue())));\
 		}
-#define SERIALIZATION_DESERIALIZE_SIGNED_VARINT(type) template<> inline bool BinaryDeserializer::deserialize<type>(Varint<type>& value) { \
+#define SERIALIZATION_DESERIALIZE_SIGNED_VARINT(type) bool deserialize(Varint<type>& value) { \
 			Varint<u##type> temp;\
 			if(deserialize(temp)) {\
 				u##type unsignedValue = temp.getValue();\
 				if (unsignedValue & 1) {\
-					value.setValue(-(static_cast<type>(((unsignedValue) >> 1) + 1))); \
+					value.setValue(static_cast<type>(~(unsignedValue >> 1))); \
 				}\
 				else {\
-					value.setValue(unsignedValue >> 1);\
+					value.setValue(static_cast<type>(unsignedValue >> 1));\
 				}\
 				return true;\
 			}\
 			return false;\
 		}
 
-		class BinarySerializer {
+		//StreamWriter is IStreamWriter or any class derived from it.
+		//With a concrete final stream (MemoryStreamWriter, MemorySizeCounterStream...) all writes are resolved statically and can be inlined.
+		template<typename StreamWriter>
+		class BasicBinarySerializer {
 		public:
 
-			BinarySerializer(IStreamWriter* writer) : _writer(writer) {
+			BasicBinarySerializer(StreamWriter* writer) : _writer(writer) {
 				assert(writer != nullptr);
 			}
 
-			~BinarySerializer() {
+			~BasicBinarySerializer() {
 			}
 
-			void setStreamWriter(IStreamWriter* writer) {
+			void setStreamWriter(StreamWriter* writer) {
 				assert(writer != nullptr);
 				_writer = writer;
 			}
@@ -72,6 +73,11 @@ namespace Antilatency {
 				return value.serialize(*this);
 			}			
 
+			//Existence bitmap of the optional fields of a structure, written with a single call
+			bool serializePresence(const uint8_t* bitmap, size_t size) {
+				return _writer->write(bitmap, size);
+			}
+
 			template <typename T>
 			bool serialize(const Varint<T>& value) {
 				using VariantType = Varint<T>;
@@ -80,22 +86,81 @@ namespace Antilatency {
 	#if SERIALIZATION_BYTE_ORDER == SERIALIZATION_BIG_ENDIAN
 				temp = swapBytes(temp);
 	#endif
-				size_t i = 0;
+				uint8_t buffer[VariantType::maxSize];
+				size_t size = 0;
 				while (temp >= VariantType::base) {
-					if(!serialize<uint8_t>((1 << VariantType::usedBits) | (temp & VariantType::mask))) {
-						return false;
-					}
+					buffer[size++] = static_cast<uint8_t>(VariantType::base | (temp & VariantType::mask));
 					temp >>= VariantType::usedBits;
-					++i;
 				}
-				return serialize<uint8_t>(temp & VariantType::mask);
+				buffer[size++] = static_cast<uint8_t>(temp & VariantType::mask);
+				return _writer->write(buffer, size);
+			}
+
+			//Structures of fixed-width fields are packed into a stack buffer and written at once
+			template <typename ... Fields>
+			bool serialize(const Structure<Fields...>& value) {
+				return serializeStructure(value, detail::UseFixedSizePath<StreamWriter, Structure<Fields...>>{});
 			}
 
 			template <typename T>
 			bool serialize(const BaseVectorType<T>& value) {
+				return serializeVector(value, detail::UseFixedSizePath<StreamWriter, T>{});
+			}
+
+			template <typename T>
+			bool serialize(const Span<T>& value) {
+	#if SERIALIZATION_BYTE_ORDER == SERIALIZATION_LITTLE_ENDIAN
+				return serializeNativeContainer<Span<T>, T>(value, value.size());
+	#else
 				return serializeContainer(value, value.size());
+	#endif
+			}
+
+			template <typename T>
+			bool serialize(const PackedIntegerVector<T>& value) {
+				if (!serialize(Varint64(value.size()))) {
+					return false;
+				}
+				return StreamVByte::write(_writer, value.data(), value.size());
+			}
+
+			SERIALIZATION_SERIALIZE_BASE_TYPE(char)
+			SERIALIZATION_SERIALIZE_BASE_TYPE(uint8_t)
+			SERIALIZATION_SERIALIZE_BASE_TYPE(int8_t)
+			SERIALIZATION_SERIALIZE_BASE_TYPE(uint16_t)
+			SERIALIZATION_SERIALIZE_BASE_TYPE(int16_t)
+			SERIALIZATION_SERIALIZE_BASE_TYPE(uint32_t)
+			SERIALIZATION_SERIALIZE_BASE_TYPE(int32_t)
+			SERIALIZATION_SERIALIZE_BASE_TYPE(uint64_t)
+			SERIALIZATION_SERIALIZE_BASE_TYPE(int64_t)
+			SERIALIZATION_SERIALIZE_BASE_TYPE(float)
+			SERIALIZATION_SERIALIZE_BASE_TYPE(double)
+
+	#if SERIALIZATION_BYTE_ORDER == SERIALIZATION_LITTLE_ENDIAN
+			SERIALIZATION_SERIALIZE_CONTAINER_BASE_TYPE(uint8_t)
+			SERIALIZATION_SERIALIZE_CONTAINER_BASE_TYPE(int8_t)
+			SERIALIZATION_SERIALIZE_CONTAINER_BASE_TYPE(uint16_t)
+			SERIALIZATION_SERIALIZE_CONTAINER_BASE_TYPE(int16_t)
+			SERIALIZATION_SERIALIZE_CONTAINER_BASE_TYPE(uint32_t)
+			SERIALIZATION_SERIALIZE_CONTAINER_BASE_TYPE(int32_t)
+			SERIALIZATION_SERIALIZE_CONTAINER_BASE_TYPE(uint64_t)
+			SERIALIZATION_SERIALIZE_CONTAINER_BASE_TYPE(int64_t)
+			SERIALIZATION_SERIALIZE_CONTAINER_BASE_TYPE(float)
+			SERIALIZATION_SERIALIZE_CONTAINER_BASE_TYPE(double)
+	#endif
+
+			bool serialize(const bool& value) {
+				return serialize(static_cast<uint8_t>(value));
+			}
+
+			bool serialize(const BaseStringType& value) {
+				return serializeContainer(value, value.length());
 			}
 
+			SERIALIZATION_SERIALIZE_SIGNED_VARINT(int16_t)
+			SERIALIZATION_SERIALIZE_SIGNED_VARINT(int32_t)
+			SERIALIZATION_SERIALIZE_SIGNED_VARINT(int64_t)
+
 		private:
 			template<typename T>
 			bool write(const T& value) {
@@ -107,6 +172,65 @@ namespace Antilatency {
 				return _writer->write(reinterpret_cast<const uint8_t*>(&temp), sizeof(T));
 			}
 
+			template<typename T>
+			bool serializeStructure(const T& value, detail::BoolConstant<false>) {
+				return value.serialize(*this);
+			}
+
+			template<typename T>
+			bool serializeStructure(const T& value, detail::BoolConstant<true>) {
+				constexpr size_t size = detail::FixedSize<T>::value;
+				auto data = _writer->allocate(size);
+				if (data != nullptr) {
+					pack(&value, 1, data);
+					return true;
+				}
+				uint8_t buffer[size];
+				pack(&value, 1, buffer);
+				return _writer->write(buffer, size);
+			}
+
+			template<typename T>
+			bool serializeVector(const BaseVectorType<T>& value, detail::BoolConstant<false>) {
+				return serializeContainer(value, value.size());
+			}
+
+			template<typename T>
+			bool serializeVector(const BaseVectorType<T>& value, detail::BoolConstant<true>) {
+				using Chunk = detail::FixedSizeChunk<T>;
+				constexpr size_t itemSize = detail::FixedSize<T>::value;
+				if (!serialize(Varint64(value.size()))) {
+					return false;
+				}
+				if (value.size() == 0) {
+					return true;
+				}
+				auto data = _writer->allocate(value.size() * itemSize);
+				if (data != nullptr) {
+					pack(value.data(), value.size(), data);
+					return true;
+				}
+				uint8_t buffer[Chunk::size];
+				for (size_t offset = 0; offset < value.size(); offset += Chunk::count) {
+					auto count = value.size() - offset < Chunk::count ? value.size() - offset : Chunk::count;
+					pack(value.data() + offset, count, buffer);
+					if (!_writer->write(buffer, count * itemSize)) {
+						return false;
+					}
+				}
+				return true;
+			}
+
+			//Data is already checked to have room for count items
+			template<typename T>
+			static void pack(const T* items, size_t count, uint8_t* data) {
+				detail::UncheckedMemoryStreamWriter writer(data);
+				BasicBinarySerializer<detail::UncheckedMemoryStreamWriter> serializer(&writer);
+				for (size_t i = 0; i < count; ++i) {
+					serializer.serialize(items[i]);
+				}
+			}
+
 			template<typename T>
 			bool serializeContainer(const T &value, size_t containerSize) {
 				if(!serialize(Varint64(containerSize))) {
@@ -137,57 +261,65 @@ namespace Antilatency {
 			}
 		#endif
 		private:
-			IStreamWriter* _writer;
+			StreamWriter* _writer;
 		};
+		
+		//Type-erased serializer, works with any IStreamWriter through virtual calls
+		using BinarySerializer = BasicBinarySerializer<IStreamWriter>;
 
-		SERIALIZATION_SERIALIZE_BASE_TYPE(char)
-		SERIALIZATION_SERIALIZE_BASE_TYPE(uint8_t)
-		SERIALIZATION_SERIALIZE_BASE_TYPE(int8_t)
-		SERIALIZATION_SERIALIZE_BASE_TYPE(uint16_t)
-		SERIALIZATION_SERIALIZE_BASE_TYPE(int16_t)
-		SERIALIZATION_SERIALIZE_BASE_TYPE(uint32_t)
-		SERIALIZATION_SERIALIZE_BASE_TYPE(int32_t)
-		SERIALIZATION_SERIALIZE_BASE_TYPE(uint64_t)
-		SERIALIZATION_SERIALIZE_BASE_TYPE(int64_t)
-		SERIALIZATION_SERIALIZE_BASE_TYPE(float)
-
-#if SERIALIZATION_BYTE_ORDER == SERIALIZATION_LITTLE_ENDIAN
-		SERIALIZATION_SERIALIZE_CONTAINER_BASE_TYPE(uint8_t)
-		SERIALIZATION_SERIALIZE_CONTAINER_BASE_TYPE(int8_t)
-		SERIALIZATION_SERIALIZE_CONTAINER_BASE_TYPE(uint16_t)
-		SERIALIZATION_SERIALIZE_CONTAINER_BASE_TYPE(int16_t)
-		SERIALIZATION_SERIALIZE_CONTAINER_BASE_TYPE(uint32_t)
-		SERIALIZATION_SERIALIZE_CONTAINER_BASE_TYPE(int32_t)
-		SERIALIZATION_SERIALIZE_CONTAINER_BASE_TYPE(uint64_t)
-		SERIALIZATION_SERIALIZE_CONTAINER_BASE_TYPE(int64_t)
-		SERIALIZATION_SERIALIZE_CONTAINER_BASE_TYPE(float)
-#endif
-
-		template<>
-		inline bool BinarySerializer::serialize<bool>(const bool& value) {
-			return serialize(static_cast<uint8_t>(value));
-		}
 
-		template <>
-		inline bool BinarySerializer::serialize<BaseStringType>(const BaseStringType& value) {
-			return serializeContainer(value, value.length());
-		}
-		
-		SERIALIZATION_SERIALIZE_SIGNED_VARINT(int16_t)
-		SERIALIZATION_SERIALIZE_SIGNED_VARINT(int32_t)
-		SERIALIZATION_SERIALIZE_SIGNED_VARINT(int64_t)
-		
+		template<typename T>
+		class LazyField;
 
+		namespace detail {
+			//Copies everything read from the inner stream to storage
+			class RecordingStreamReader final : public IStreamReader {
+			public:
+				RecordingStreamReader(IStreamReader* reader, BaseVectorType<uint8_t>* storage) :
+					_reader(reader),
+					_storage(storage)
+				{
+				}
 
-		class BinaryDeserializer {
+				bool read(uint8_t* buffer, size_t size) override {
+					if (!_reader->read(buffer, size)) {
+						return false;
+					}
+					record(buffer, size);
+					return true;
+				}
+
+				size_t readSome(uint8_t* buffer, size_t maxSize) override {
+					auto size = _reader->readSome(buffer, maxSize);
+					record(buffer, size);
+					return size;
+				}
+
+			private:
+				void record(const uint8_t* buffer, size_t size) {
+					if (size != 0) {
+						auto offset = _storage->size();
+						_storage->resize(offset + size);
+						memcpy(_storage->data() + offset, buffer, size);
+					}
+				}
+
+				IStreamReader* _reader;
+				BaseVectorType<uint8_t>* _storage;
+			};
+		}
+
+		//StreamReader is IStreamReader or any class derived from it.
+		template<typename StreamReader>
+		class BasicBinaryDeserializer {
 		public:
-			BinaryDeserializer(IStreamReader* reader) :
+			BasicBinaryDeserializer(StreamReader* reader) :
 				_reader(reader)
 			{
 				assert(_reader != nullptr);
 			}
 
-			void setStreamReader(IStreamReader* reader) {
+			void setStreamReader(StreamReader* reader) {
 				assert(reader != nullptr);
 				_reader = reader;
 			}
@@ -197,21 +329,70 @@ namespace Antilatency {
 				return value.deserialize(*this);
 			}
 
+			//Existence bitmap of the optional fields of a structure
+			bool deserializePresence(uint8_t* bitmap, size_t size) {
+				return _reader->read(bitmap, size);
+			}
+
+			//Advances past a value of type T without building it.
+			//Containers of fixed-size items are skipped by their length prefix, a VersionedStructure of an older version is fully decoded.
+			template<typename T>
+			bool skip() {
+				return skipValue(static_cast<const T*>(nullptr));
+			}
+
+			//Skips a value of type T and reports its bytes. data points into the stream when it is backed by memory,
+			//otherwise data is nullptr and the bytes are copied to storage.
+			template<typename T>
+			bool capture(const uint8_t*& data, size_t& size, BaseVectorType<uint8_t>& storage) {
+				size_t availableSize;
+				auto begin = _reader->peek(availableSize);
+				if (begin != nullptr) {
+					if (!skip<T>()) {
+						return false;
+					}
+					size_t remainingSize;
+					_reader->peek(remainingSize);
+					data = begin;
+					size = availableSize - remainingSize;
+					return true;
+				}
+				storage.clear();
+				detail::RecordingStreamReader recorder(_reader, &storage);
+				BasicBinaryDeserializer<detail::RecordingStreamReader> recordingDeserializer(&recorder);
+				if (!recordingDeserializer.template skip<T>()) {
+					return false;
+				}
+				data = nullptr;
+				size = storage.size();
+				return true;
+			}
+
 			template <typename T>
 			bool deserialize(Varint<T>& value) {
 				using VariantType = Varint<T>;
 				T temp = 0;
-				size_t i = 0;
-				while (true) {
-					uint8_t sym;
-					if(!deserialize<uint8_t>(sym)) {
+				size_t availableSize;
+				auto data = _reader->peek(availableSize);
+				if (data != nullptr) {
+					auto size = detail::decodeVarint(data, availableSize, temp);
+					if (size == 0 || !_reader->skip(size)) {
 						return false;
 					}
-					temp |= static_cast<T>(sym & VariantType::mask) << (VariantType::usedBits * i);
-					if ((sym & (~VariantType::mask)) == 0) {
-						break;
+				}
+				else {
+					size_t i = 0;
+					while (true) {
+						uint8_t sym;
+						if (i == VariantType::maxSize || !deserialize(sym)) {
+							return false;
+						}
+						temp |= static_cast<T>(sym & VariantType::mask) << (VariantType::usedBits * i);
+						if ((sym & (~VariantType::mask)) == 0) {
+							break;
+						}
+						++i;
 					}
-					++i;
 				}
 	#if SERIALIZATION_BYTE_ORDER == SERIALIZATION_BIG_ENDIAN
 				temp = swapBytes(temp);
@@ -220,10 +401,96 @@ namespace Antilatency {
 				return true;
 			}
 
+			//Structures of fixed-width fields are read at once and unpacked from memory
+			template <typename ... Fields>
+			bool deserialize(Structure<Fields...>& value) {
+				return deserializeStructure(value, detail::UseFixedSizePath<StreamReader, Structure<Fields...>>{});
+			}
+
 			template <typename T>
 			bool deserialize(BaseVectorType<T>& value) {
+				return deserializeVector(value, detail::UseFixedSizePath<StreamReader, T>{});
+			}
+
+			//Zero-copy, the stream must be backed by memory (see IStreamReader::peek).
+			template <typename T>
+			bool deserialize(Span<T>& value) {
+				Varint64 containerSize;
+				if (!deserialize(containerSize)) {
+					return false;
+				}
+				size_t availableSize;
+				auto data = _reader->peek(availableSize);
+				if (data == nullptr || containerSize.getValue() > availableSize) {
+					return false;
+				}
+				auto size = static_cast<size_t>(containerSize.getValue());
+				if (!_reader->skip(size)) {
+					return false;
+				}
+				value = Span<T>(reinterpret_cast<const T*>(data), size);
+				return true;
+			}
+
+			template <typename T>
+			bool deserialize(PackedIntegerVector<T>& value) {
+				Varint64 containerSize;
+				if (!deserialize(containerSize)) {
+					return false;
+				}
+				//Every value takes at least one byte
+				size_t availableSize;
+				if (_reader->peek(availableSize) != nullptr && containerSize.getValue() > availableSize) {
+					return false;
+				}
+				auto size = static_cast<size_t>(containerSize.getValue());
+				#if defined(ARDUINO)
+					value.reserve(size);
+				#else
+					value.resize(size);
+				#endif
+				return StreamVByte::read(_reader, value.data(), size);
+			}
+
+			SERIALIZATION_DESERIALIZE_BASE_TYPE(char)
+			SERIALIZATION_DESERIALIZE_BASE_TYPE(uint8_t)
+			SERIALIZATION_DESERIALIZE_BASE_TYPE(int8_t)
+			SERIALIZATION_DESERIALIZE_BASE_TYPE(uint16_t)
+			SERIALIZATION_DESERIALIZE_BASE_TYPE(int16_t)
+			SERIALIZATION_DESERIALIZE_BASE_TYPE(uint32_t)
+			SERIALIZATION_DESERIALIZE_BASE_TYPE(int32_t)
+			SERIALIZATION_DESERIALIZE_BASE_TYPE(uint64_t)
+			SERIALIZATION_DESERIALIZE_BASE_TYPE(int64_t)
+			SERIALIZATION_DESERIALIZE_BASE_TYPE(float)
+			SERIALIZATION_DESERIALIZE_BASE_TYPE(double)
+
+			SERIALIZATION_DESERIALIZE_CONTAINER_BASE_TYPE(uint8_t)
+			SERIALIZATION_DESERIALIZE_CONTAINER_BASE_TYPE(int8_t)
+			SERIALIZATION_DESERIALIZE_CONTAINER_BASE_TYPE(uint16_t)
+			SERIALIZATION_DESERIALIZE_CONTAINER_BASE_TYPE(int16_t)
+			SERIALIZATION_DESERIALIZE_CONTAINER_BASE_TYPE(uint32_t)
+			SERIALIZATION_DESERIALIZE_CONTAINER_BASE_TYPE(int32_t)
+			SERIALIZATION_DESERIALIZE_CONTAINER_BASE_TYPE(uint64_t)
+			SERIALIZATION_DESERIALIZE_CONTAINER_BASE_TYPE(int64_t)
+			SERIALIZATION_DESERIALIZE_CONTAINER_BASE_TYPE(float)
+			SERIALIZATION_DESERIALIZE_CONTAINER_BASE_TYPE(double)
+
+			bool deserialize(bool& value) {
+				uint8_t temp;
+				if(!deserialize(temp)) {
+					return false;
+				}
+				value = static_cast<bool>(temp);
+				return true;
+			}
+
+			bool deserialize(BaseStringType& value) {
 				return deserializeContainer(value);
-			}		
+			}
+
+			SERIALIZATION_DESERIALIZE_SIGNED_VARINT(int16_t)
+			SERIALIZATION_DESERIALIZE_SIGNED_VARINT(int32_t)
+			SERIALIZATION_DESERIALIZE_SIGNED_VARINT(int64_t)
 			
 		private:
 			template<typename T>
@@ -240,6 +507,298 @@ namespace Antilatency {
 				return false;
 			}
 
+			template<typename T>
+			bool deserializeStructure(T& value, detail::BoolConstant<false>) {
+				return value.deserialize(*this);
+			}
+
+			template<typename T>
+			bool deserializeStructure(T& value, detail::BoolConstant<true>) {
+				constexpr size_t size = detail::FixedSize<T>::value;
+				size_t availableSize;
+				auto data = _reader->peek(availableSize);
+				if (data != nullptr) {
+					if (size > availableSize) {
+						return false;
+					}
+					unpack(value, data, 1);
+					return _reader->skip(size);
+				}
+				uint8_t buffer[size];
+				if (!_reader->read(buffer, size)) {
+					return false;
+				}
+				unpack(value, buffer, 1);
+				return true;
+			}
+
+			template<typename T>
+			bool deserializeVector(BaseVectorType<T>& value, detail::BoolConstant<false>) {
+				return deserializeContainer(value);
+			}
+
+			template<typename T>
+			bool deserializeVector(BaseVectorType<T>& value, detail::BoolConstant<true>) {
+				using Chunk = detail::FixedSizeChunk<T>;
+				constexpr size_t itemSize = detail::FixedSize<T>::value;
+				Varint64 containerSize;
+				if (!deserialize(containerSize)) {
+					return false;
+				}
+				if (containerSize.getValue() > static_cast<uint64_t>(SIZE_MAX / itemSize)) {
+					return false;
+				}
+				auto size = static_cast<size_t>(containerSize.getValue());
+
+				size_t availableSize;
+				auto data = _reader->peek(availableSize);
+				if (data != nullptr && size * itemSize > availableSize) {
+					return false;
+				}
+
+				#if defined(ARDUINO)
+					value.reserve(size);
+				#else
+					value.resize(size);
+				#endif
+				if (size == 0) {
+					return true;
+				}
+				if (data != nullptr) {
+					unpack(value[0], data, size);
+					return _reader->skip(size * itemSize);
+				}
+				uint8_t buffer[Chunk::size];
+				for (size_t offset = 0; offset < size; offset += Chunk::count) {
+					auto count = size - offset < Chunk::count ? size - offset : Chunk::count;
+					if (!_reader->read(buffer, count * itemSize)) {
+						return false;
+					}
+					unpack(value[offset], buffer, count);
+				}
+				return true;
+			}
+
+#define SERIALIZATION_SKIP_BASE_TYPE(type) bool skipValue(const type*) { return _reader->skip(sizeof(type)); }
+			SERIALIZATION_SKIP_BASE_TYPE(char)
+			SERIALIZATION_SKIP_BASE_TYPE(uint8_t)
+			SERIALIZATION_SKIP_BASE_TYPE(int8_t)
+			SERIALIZATION_SKIP_BASE_TYPE(uint16_t)
+			SERIALIZATION_SKIP_BASE_TYPE(int16_t)
+			SERIALIZATION_SKIP_BASE_TYPE(uint32_t)
+			SERIALIZATION_SKIP_BASE_TYPE(int32_t)
+			SERIALIZATION_SKIP_BASE_TYPE(uint64_t)
+			SERIALIZATION_SKIP_BASE_TYPE(int64_t)
+			SERIALIZATION_SKIP_BASE_TYPE(float)
+			SERIALIZATION_SKIP_BASE_TYPE(double)
+#undef SERIALIZATION_SKIP_BASE_TYPE
+
+			bool skipValue(const bool*) {
+				return _reader->skip(sizeof(uint8_t));
+			}
+
+			template<typename T>
+			bool skipValue(const Varint<T>*) {
+				Varint<T> temp;
+				return deserialize(temp);
+			}
+
+			template<typename T, typename Name>
+			bool skipValue(const SingleField<T, Name>*) {
+				return skipValue(static_cast<const T*>(nullptr));
+			}
+
+			template<typename T, typename Name>
+			bool skipValue(const ContainerField<T, Name>*) {
+				return skipValue(static_cast<const T*>(nullptr));
+			}
+
+			template<typename T>
+			bool skipValue(const LazyField<T>*) {
+				return skipValue(static_cast<const T*>(nullptr));
+			}
+
+			template<typename Codec, typename Name>
+			bool skipValue(const EncodedField<Codec, Name>*) {
+				return skipValue(static_cast<const typename EncodedField<Codec, Name>::WireType*>(nullptr));
+			}
+
+			template<typename Codec, typename Name>
+			bool skipValue(const EncodedVectorField<Codec, Name>*) {
+				return skipValue(static_cast<const BaseVectorType<typename EncodedVectorField<Codec, Name>::WireType>*>(nullptr));
+			}
+
+			template<typename T, typename Name, size_t MaxConstantRows>
+			bool skipValue(const ColumnarVectorField<T, Name, MaxConstantRows>*) {
+				return ColumnarVectorField<T, Name, MaxConstantRows>::skip(*this);
+			}
+
+			template<typename T>
+			bool skipValue(const OptioinalField<T>*) {
+				bool exists;
+				if (!deserialize(exists)) {
+					return false;
+				}
+				return !exists || skipValue(static_cast<const T*>(nullptr));
+			}
+
+			template<typename ... Fields>
+			bool skipValue(const Structure<Fields...>*) {
+				return skipStructure(static_cast<const Structure<Fields...>*>(nullptr), detail::BoolConstant<detail::FixedSize<Structure<Fields...>>::value != 0>{});
+			}
+
+			template<uint64_t Version, typename ChildType, typename ... Fields>
+			bool skipValue(const VersionedStructure<Version, ChildType, Fields...>*) {
+				Varint64 version;
+				if (!deserialize(version)) {
+					return false;
+				}
+				if (version == VersionedStructure<Version, ChildType, Fields...>::Version) {
+					return skipValue(static_cast<const Structure<Fields...>*>(nullptr));
+				}
+				ChildType temp;
+				return temp.deserialize(version, *this);
+			}
+
+			template<typename T>
+			bool skipValue(const BaseVectorType<T>*) {
+				Varint64 containerSize;
+				if (!deserialize(containerSize)) {
+					return false;
+				}
+				return skipItems(static_cast<const T*>(nullptr), containerSize.getValue(), detail::BoolConstant<detail::FixedSize<T>::value != 0>{});
+			}
+
+			template<typename T>
+			bool skipValue(const Span<T>*) {
+				Varint64 containerSize;
+				if (!deserialize(containerSize)) {
+					return false;
+				}
+				return skipBytes(containerSize.getValue(), sizeof(T));
+			}
+
+			bool skipValue(const BaseStringType*) {
+				Varint64 containerSize;
+				if (!deserialize(containerSize)) {
+					return false;
+				}
+				return skipBytes(containerSize.getValue(), sizeof(char));
+			}
+
+			template<typename T>
+			bool skipValue(const PackedIntegerVector<T>*) {
+				size_t availableSize;
+				if (_reader->peek(availableSize) == nullptr) {
+					PackedIntegerVector<T> temp;
+					return deserialize(temp);
+				}
+				Varint64 containerSize;
+				if (!deserialize(containerSize)) {
+					return false;
+				}
+				auto data = _reader->peek(availableSize);
+				if (containerSize.getValue() > availableSize) {
+					return false;
+				}
+				auto count = static_cast<size_t>(containerSize.getValue());
+				auto controlSize = StreamVByte::getControlSize(count);
+				return _reader->skip(controlSize + StreamVByte::getDataSize(data, count));
+			}
+
+			template<typename ... Fields>
+			bool skipStructure(const Structure<Fields...>*, detail::BoolConstant<true>) {
+				return _reader->skip(detail::FixedSize<Structure<Fields...>>::value);
+			}
+
+			template<typename ... Fields>
+			bool skipStructure(const Structure<Fields...>*, detail::BoolConstant<false>) {
+				return skipFields(static_cast<const Structure<Fields...>*>(nullptr), typename detail::MakeIndexSequence<sizeof...(Fields)>::Type{}, detail::BoolConstant<detail::OptionalFields<Fields...>::BitmapSize != 0>{});
+			}
+
+			template<typename ... Fields, size_t ... I>
+			bool skipFields(const Structure<Fields...>*, detail::IndexSequence<I...>, detail::BoolConstant<false>) {
+				bool isOk = true;
+				const int dummy[] = { (isOk = isOk && skipValue(static_cast<const Fields*>(nullptr)), 0)... };
+				static_cast<void>(dummy);
+				return isOk;
+			}
+
+			template<typename ... Fields, size_t ... I>
+			bool skipFields(const Structure<Fields...>*, detail::IndexSequence<I...>, detail::BoolConstant<true>) {
+				using Optionals = detail::OptionalFields<Fields...>;
+				uint8_t bitmap[Optionals::BitmapSize];
+				if (!deserializePresence(bitmap, Optionals::BitmapSize)) {
+					return false;
+				}
+				bool isOk = true;
+				const int dummy[] = { (isOk = isOk && skipField(static_cast<const Fields*>(nullptr), bitmap, Optionals::bit(I)), 0)... };
+				static_cast<void>(dummy);
+				return isOk;
+			}
+
+			template<typename T>
+			bool skipField(const T* field, const uint8_t*, size_t) {
+				return skipValue(field);
+			}
+
+			template<typename T>
+			bool skipField(const OptioinalField<T>*, const uint8_t* bitmap, size_t bit) {
+				return ((bitmap[bit / 8] >> (bit % 8)) & 1) == 0 || skipValue(static_cast<const T*>(nullptr));
+			}
+
+			template<typename T>
+			bool skipItems(const T*, uint64_t count, detail::BoolConstant<true>) {
+				return skipBytes(count, detail::FixedSize<T>::value);
+			}
+
+			//Every item takes at least one byte, so memory streams reject a broken count before walking items
+			template<typename T>
+			bool skipItems(const T* item, uint64_t count, detail::BoolConstant<false>) {
+				size_t availableSize;
+				if (_reader->peek(availableSize) != nullptr && count > availableSize) {
+					return false;
+				}
+				for (uint64_t i = 0; i < count; ++i) {
+					if (!skipValue(item)) {
+						return false;
+					}
+				}
+				return true;
+			}
+
+			template<typename T>
+			bool skipItems(const Varint<T>* item, uint64_t count, detail::BoolConstant<false>) {
+				size_t availableSize;
+				auto data = _reader->peek(availableSize);
+				if (data == nullptr) {
+					return skipItems<Varint<T>>(item, count, detail::BoolConstant<false>{});
+				}
+				if (count > availableSize) {
+					return false;
+				}
+				auto size = detail::skipVarints(data, availableSize, static_cast<size_t>(count), Varint<T>::maxSize);
+				return (size != 0 || count == 0) && _reader->skip(size);
+			}
+
+			bool skipBytes(uint64_t count, size_t itemSize) {
+				if (count > static_cast<uint64_t>(SIZE_MAX / itemSize)) {
+					return false;
+				}
+				return _reader->skip(static_cast<size_t>(count) * itemSize);
+			}
+
+			//Data is already checked to contain count items
+			template<typename T>
+			static void unpack(T& first, const uint8_t* data, size_t count) {
+				detail::UncheckedMemoryStreamReader reader(data);
+				BasicBinaryDeserializer<detail::UncheckedMemoryStreamReader> deserializer(&reader);
+				auto items = &first;
+				for (size_t i = 0; i < count; ++i) {
+					deserializer.deserialize(items[i]);
+				}
+			}
+
 			template<typename T>
 			bool deserializeContainer(T& value) {
 				Varint64 containerSize;
@@ -259,42 +818,46 @@ namespace Antilatency {
 				}
 				return true;
 			}
-		private:
-			IStreamReader* _reader;
-		};
 
+			template<typename T, typename ItemType>
+			bool deserializeNativeContainer(T& value) {
+				Varint64 containerSize;
+				if(!deserialize(containerSize)) {
+					return false;
+				}
+				if (containerSize.getValue() > static_cast<uint64_t>(SIZE_MAX / sizeof(ItemType))) {
+					return false;
+				}
+				auto size = static_cast<size_t>(containerSize.getValue());
+				auto itemsSize = sizeof(ItemType) * size;
 
-		SERIALIZATION_DESERIALIZE_BASE_TYPE(char)
-		SERIALIZATION_DESERIALIZE_BASE_TYPE(uint8_t)
-		SERIALIZATION_DESERIALIZE_BASE_TYPE(int8_t)
-		SERIALIZATION_DESERIALIZE_BASE_TYPE(uint16_t)
-		SERIALIZATION_DESERIALIZE_BASE_TYPE(int16_t)
-		SERIALIZATION_DESERIALIZE_BASE_TYPE(uint32_t)
-		SERIALIZATION_DESERIALIZE_BASE_TYPE(int32_t)
-		SERIALIZATION_DESERIALIZE_BASE_TYPE(uint64_t)
-		SERIALIZATION_DESERIALIZE_BASE_TYPE(int64_t)
-		SERIALIZATION_DESERIALIZE_BASE_TYPE(float)
-		
-		//Todo optimized version for deserializing container with primary types inside
+				//Memory streams know their size, reject broken length before allocating
+				size_t availableSize;
+				if (_reader->peek(availableSize) != nullptr && itemsSize > availableSize) {
+					return false;
+				}
 
-		template<>
-		inline bool BinaryDeserializer::deserialize<bool>(bool& value) {
-			uint8_t temp;
-			if(!deserialize(temp)) {
-				return false;
+				#if defined(ARDUINO)
+					value.reserve(size);
+				#else
+					value.resize(size);
+				#endif
+				if (itemsSize) {
+					if (!_reader->read(reinterpret_cast<uint8_t*>(value.data()), itemsSize)) {
+						return false;
+					}
+				#if SERIALIZATION_BYTE_ORDER == SERIALIZATION_BIG_ENDIAN
+					swapBytes(value.data(), size);
+				#endif
+				}
+				return true;
 			}
-			value = static_cast<bool>(temp);
-			return true;
-		}
-		
-		template <>
-		inline bool BinaryDeserializer::deserialize<BaseStringType>(BaseStringType& value) {
-			return deserializeContainer(value);
-		}
+		private:
+			StreamReader* _reader;
+		};
 
-		SERIALIZATION_DESERIALIZE_SIGNED_VARINT(int16_t)
-		SERIALIZATION_DESERIALIZE_SIGNED_VARINT(int32_t)
-		SERIALIZATION_DESERIALIZE_SIGNED_VARINT(int64_t)
+		//Type-erased deserializer, works with any IStreamReader through virtual calls
+		using BinaryDeserializer = BasicBinaryDeserializer<IStreamReader>;
 	}
 }
 
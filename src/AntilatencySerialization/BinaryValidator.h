@@ -0,0 +1,58 @@
+#ifndef BinaryValidator_H
+#define BinaryValidator_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "StreamSerialization.h"
+#include "BinarySerialization.h"
+
+namespace Antilatency {
+	namespace Serialization {
+
+		//Walks a buffer of concatenated BinarySerializer outputs without building values.
+		//Containers and strings are checked against the remaining size and skipped, nothing is allocated,
+		//except for a VersionedStructure of an older version which is decoded through convertFromPreviousVersion.
+		class BinaryValidator {
+		public:
+			BinaryValidator(const uint8_t* buffer, size_t size) :
+				_buffer(buffer),
+				_size(size),
+				_reader(buffer, size),
+				_deserializer(&_reader)
+			{
+			}
+
+			BinaryValidator(const BinaryValidator&) = delete;
+			BinaryValidator& operator=(const BinaryValidator&) = delete;
+
+			//Returns the encoded length of a T at the current position and moves past it.
+			//Returns 0 and keeps the position if the data is broken or truncated.
+			template<typename T>
+			size_t validate() {
+				auto position = getPosition();
+				if (!_deserializer.template skip<T>()) {
+					_reader = MemoryStreamReader(_buffer, _size);
+					_reader.skip(position);
+					return 0;
+				}
+				return getPosition() - position;
+			}
+
+			size_t getPosition() const {
+				return _reader.getPosition();
+			}
+
+			size_t getRemainingSize() const {
+				return _size - _reader.getPosition();
+			}
+
+		private:
+			const uint8_t* _buffer;
+			size_t _size;
+			MemoryStreamReader _reader;
+			BasicBinaryDeserializer<MemoryStreamReader> _deserializer;
+		};
+	}
+}
+
+#endif // BinaryValidator_H
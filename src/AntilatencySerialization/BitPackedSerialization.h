@@ -0,0 +1,486 @@
+#ifndef BitPackedSerialization_H
+#define BitPackedSerialization_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <assert.h>
+#include <string.h>
+#include "BaseTypes.h"
+#include "Varint.h"
+#include "Fields.h"
+#include "Structures.h"
+#include "StreamSerialization.h"
+
+namespace Antilatency {
+	namespace Serialization {
+
+		namespace detail {
+			constexpr unsigned bitWidth(uint64_t value) {
+				return value == 0 ? 0 : 1 + bitWidth(value >> 1);
+			}
+
+			//Smallest unsigned type holding Bits bits
+			template<unsigned Bits, bool Fits8 = (Bits <= 8), bool Fits16 = (Bits <= 16), bool Fits32 = (Bits <= 32)>
+			struct BitsType {
+				using Type = uint64_t;
+			};
+
+			template<unsigned Bits, bool Fits16, bool Fits32>
+			struct BitsType<Bits, true, Fits16, Fits32> {
+				using Type = uint8_t;
+			};
+
+			template<unsigned Bits, bool Fits32>
+			struct BitsType<Bits, false, true, Fits32> {
+				using Type = uint16_t;
+			};
+
+			template<unsigned Bits>
+			struct BitsType<Bits, false, false, true> {
+				using Type = uint32_t;
+			};
+
+			//Bit-granular serializers provide serializeBits/deserializeBits, byte-granular ones get the field value as is
+			template<typename Serializer>
+			auto hasSerializeBits(Serializer* serializer, int) -> decltype(serializer->serializeBits(uint64_t(), 0u), BoolConstant<true>());
+
+			template<typename Serializer>
+			BoolConstant<false> hasSerializeBits(Serializer*, long);
+
+			template<typename Deserializer>
+			auto hasDeserializeBits(Deserializer* deserializer, int) -> decltype(deserializer->deserializeBits(*static_cast<uint64_t*>(nullptr), 0u), BoolConstant<true>());
+
+			template<typename Deserializer>
+			BoolConstant<false> hasDeserializeBits(Deserializer*, long);
+
+			template<typename Serializer>
+			using SupportsBits = decltype(hasSerializeBits(static_cast<Serializer*>(nullptr), 0));
+
+			template<typename Deserializer>
+			using SupportsBitsOnRead = decltype(hasDeserializeBits(static_cast<Deserializer*>(nullptr), 0));
+		}
+
+		//Unsigned integer of Bits bits. BitPackedSerializer writes exactly Bits bits, other serializers write the value type.
+		template <unsigned Bits, typename Name>
+		class BitsField : public SingleField<typename detail::BitsType<Bits>::Type, Name> {
+			static_assert(Bits != 0 && Bits <= 64, "BitsField width must be 1..64");
+			using Base = SingleField<typename detail::BitsType<Bits>::Type, Name>;
+		public:
+			using Type = typename Base::Type;
+
+			static constexpr unsigned BitCount = Bits;
+			static constexpr Type MaxValue = static_cast<Type>(~static_cast<uint64_t>(0) >> (64 - Bits));
+
+			void setValue(const Type& value) {
+				assert(value <= MaxValue);
+				Base::setValue(value);
+			}
+
+			template<typename Serializer>
+			size_t serialize(Serializer& serializer) const {
+				return serialize(serializer, detail::SupportsBits<Serializer>{});
+			}
+
+			template<typename Deserializer>
+			size_t deserialize(Deserializer& deserializer) {
+				return deserialize(deserializer, detail::SupportsBitsOnRead<Deserializer>{});
+			}
+
+		private:
+			template<typename Serializer>
+			bool serialize(Serializer& serializer, detail::BoolConstant<true>) const {
+				return serializer.serializeBits(this->_value, Bits);
+			}
+
+			template<typename Serializer>
+			bool serialize(Serializer& serializer, detail::BoolConstant<false>) const {
+				return Base::serialize(serializer) != 0;
+			}
+
+			template<typename Deserializer>
+			bool deserialize(Deserializer& deserializer, detail::BoolConstant<true>) {
+				uint64_t value;
+				if (!deserializer.deserializeBits(value, Bits)) {
+					return false;
+				}
+				this->_value = static_cast<Type>(value);
+				return true;
+			}
+
+			template<typename Deserializer>
+			bool deserialize(Deserializer& deserializer, detail::BoolConstant<false>) {
+				return Base::deserialize(deserializer) && this->_value <= MaxValue;
+			}
+		};
+
+		//Integer in [Min, Max]. BitPackedSerializer writes value - Min in the fewest bits covering the range,
+		//other serializers write the value type. Values out of range fail to deserialize.
+		template <typename T, T Min, T Max, typename Name>
+		class RangeField : public SingleField<T, Name> {
+			static_assert(Min <= Max, "Empty range");
+			using Base = SingleField<T, Name>;
+		public:
+			using Type = T;
+
+			static constexpr T MinValue = Min;
+			static constexpr T MaxValue = Max;
+			static constexpr unsigned BitCount = detail::bitWidth(static_cast<uint64_t>(Max) - static_cast<uint64_t>(Min));
+
+			RangeField() {
+				this->_value = Min;
+			}
+
+			void setValue(const Type& value) {
+				assert(value >= Min && value <= Max);
+				Base::setValue(value);
+			}
+
+			template<typename Serializer>
+			size_t serialize(Serializer& serializer) const {
+				return serialize(serializer, detail::SupportsBits<Serializer>{});
+			}
+
+			template<typename Deserializer>
+			size_t deserialize(Deserializer& deserializer) {
+				return deserialize(deserializer, detail::SupportsBitsOnRead<Deserializer>{});
+			}
+
+		private:
+			template<typename Serializer>
+			bool serialize(Serializer& serializer, detail::BoolConstant<true>) const {
+				return BitCount == 0 || serializer.serializeBits(static_cast<uint64_t>(this->_value) - static_cast<uint64_t>(Min), BitCount);
+			}
+
+			template<typename Serializer>
+			bool serialize(Serializer& serializer, detail::BoolConstant<false>) const {
+				return Base::serialize(serializer) != 0;
+			}
+
+			template<typename Deserializer>
+			bool deserialize(Deserializer& deserializer, detail::BoolConstant<true>) {
+				uint64_t offset = 0;
+				if (BitCount != 0 && !deserializer.deserializeBits(offset, BitCount)) {
+					return false;
+				}
+				if (offset > static_cast<uint64_t>(Max) - static_cast<uint64_t>(Min)) {
+					return false;
+				}
+				this->_value = static_cast<T>(static_cast<uint64_t>(Min) + offset);
+				return true;
+			}
+
+			template<typename Deserializer>
+			bool deserialize(Deserializer& deserializer, detail::BoolConstant<false>) {
+				return Base::deserialize(deserializer) && this->_value >= Min && this->_value <= Max;
+			}
+		};
+
+#define SERIALIZATION_BIT_PACKED_SERIALIZE_BASE_TYPE(type, unsignedType) bool serialize(const type& value) { \
+			return serializeBits(static_cast<unsignedType>(value), sizeof(type) * 8); \
+		}
+#define SERIALIZATION_BIT_PACKED_DESERIALIZE_BASE_TYPE(type) bool deserialize(type& value) { \
+			uint64_t temp; \
+			if (!deserializeBits(temp, sizeof(type) * 8)) { \
+				return false; \
+			} \
+			value = static_cast<type>(temp); \
+			return true; \
+		}
+
+		//Writes values as a little-endian bit stream: bool takes 1 bit, BitsField/RangeField take their width,
+		//base types take their full width and are not byte aligned. Bits are collected in a 64-bit register and written by whole words.
+		//Call flush() after the last value, it pads the stream to a whole byte.
+		//Optional fields keep a 1 bit flag each, there is no structure presence bitmap.
+		template<typename StreamWriter>
+		class BasicBitPackedSerializer {
+		public:
+			explicit BasicBitPackedSerializer(StreamWriter* writer) :
+				_writer(writer)
+			{
+				assert(writer != nullptr);
+			}
+
+			void beginStructure() {
+
+			}
+
+			void endStructure() {
+
+			}
+
+			template<typename T>
+			bool serialize(const T& value) {
+				return value.serialize(*this);
+			}
+
+			//Lower count bits of value, count is 0..64
+			bool serializeBits(uint64_t value, unsigned count) {
+				assert(count <= 64);
+				if (count > 32) {
+					return writeBits(value & 0xFFFFFFFF, 32) && writeBits(value >> 32, count - 32);
+				}
+				return count == 0 || writeBits(value & (~static_cast<uint64_t>(0) >> (64 - count)), count);
+			}
+
+			template <typename T>
+			bool serialize(const Varint<T>& value) {
+				uint64_t temp = static_cast<uint64_t>(detail::zigzagEncode(value.getValue()));
+				while (temp >= 0x80) {
+					if (!writeBits((temp & 0x7F) | 0x80, 8)) {
+						return false;
+					}
+					temp >>= 7;
+				}
+				return writeBits(temp, 8);
+			}
+
+			template <typename T>
+			bool serialize(const BaseVectorType<T>& value) {
+				return serializeContainer(value, value.size());
+			}
+
+			bool serialize(const BaseStringType& value) {
+				return serializeContainer(value, value.length());
+			}
+
+			bool serialize(const bool& value) {
+				return writeBits(value ? 1 : 0, 1);
+			}
+
+			bool serialize(const float& value) {
+				uint32_t temp;
+				memcpy(&temp, &value, sizeof(temp));
+				return writeBits(temp, 32);
+			}
+
+			bool serialize(const double& value) {
+				uint64_t temp;
+				memcpy(&temp, &value, sizeof(temp));
+				return serializeBits(temp, 64);
+			}
+
+			SERIALIZATION_BIT_PACKED_SERIALIZE_BASE_TYPE(char, uint8_t)
+			SERIALIZATION_BIT_PACKED_SERIALIZE_BASE_TYPE(uint8_t, uint8_t)
+			SERIALIZATION_BIT_PACKED_SERIALIZE_BASE_TYPE(int8_t, uint8_t)
+			SERIALIZATION_BIT_PACKED_SERIALIZE_BASE_TYPE(uint16_t, uint16_t)
+			SERIALIZATION_BIT_PACKED_SERIALIZE_BASE_TYPE(int16_t, uint16_t)
+			SERIALIZATION_BIT_PACKED_SERIALIZE_BASE_TYPE(uint32_t, uint32_t)
+			SERIALIZATION_BIT_PACKED_SERIALIZE_BASE_TYPE(int32_t, uint32_t)
+			SERIALIZATION_BIT_PACKED_SERIALIZE_BASE_TYPE(uint64_t, uint64_t)
+			SERIALIZATION_BIT_PACKED_SERIALIZE_BASE_TYPE(int64_t, uint64_t)
+
+			//Writes the collected bits padded with zeros to a whole byte
+			bool flush() {
+				auto size = (_bitCount + 7) / 8;
+				uint8_t buffer[sizeof(uint64_t)];
+				for (unsigned i = 0; i < size; ++i) {
+					buffer[i] = static_cast<uint8_t>(_accumulator >> (8 * i));
+				}
+				_accumulator = 0;
+				_bitCount = 0;
+				return size == 0 || _writer->write(buffer, size);
+			}
+
+			//Bits written since the last flush and not yet passed to the stream
+			unsigned getPendingBits() const {
+				return _bitCount;
+			}
+
+		private:
+			//count is 1..32 and value has no bits above count
+			bool writeBits(uint64_t value, unsigned count) {
+				_accumulator |= value << _bitCount;
+				_bitCount += count;
+				if (_bitCount < 64) {
+					return true;
+				}
+				auto word = _accumulator;
+				_bitCount -= 64;
+				_accumulator = _bitCount != 0 ? value >> (count - _bitCount) : 0;
+			#if SERIALIZATION_BYTE_ORDER == SERIALIZATION_BIG_ENDIAN
+				word = swapBytes(word);
+			#endif
+				return _writer->write(reinterpret_cast<const uint8_t*>(&word), sizeof(word));
+			}
+
+			template<typename T>
+			bool serializeContainer(const T& value, size_t size) {
+				if (!serialize(Varint64(size))) {
+					return false;
+				}
+				for (size_t i = 0; i < size; ++i) {
+					if (!serialize(value[i])) {
+						return false;
+					}
+				}
+				return true;
+			}
+
+			StreamWriter* _writer;
+			uint64_t _accumulator = 0;
+			unsigned _bitCount = 0;
+		};
+
+		using BitPackedSerializer = BasicBitPackedSerializer<IStreamWriter>;
+
+		//Reads the bit stream written by BitPackedSerializer. Only the bytes needed for the next value are read from the stream,
+		//call align() after the last value of a message to drop the padding bits.
+		template<typename StreamReader>
+		class BasicBitPackedDeserializer {
+		public:
+			explicit BasicBitPackedDeserializer(StreamReader* reader) :
+				_reader(reader)
+			{
+				assert(reader != nullptr);
+			}
+
+			template<typename T>
+			bool deserialize(T& value) {
+				return value.deserialize(*this);
+			}
+
+			bool deserializeBits(uint64_t& value, unsigned count) {
+				assert(count <= 64);
+				if (count > 32) {
+					uint64_t high;
+					if (!readBits(value, 32) || !readBits(high, count - 32)) {
+						return false;
+					}
+					value |= high << 32;
+					return true;
+				}
+				if (count == 0) {
+					value = 0;
+					return true;
+				}
+				return readBits(value, count);
+			}
+
+			template <typename T>
+			bool deserialize(Varint<T>& value) {
+				uint64_t temp = 0;
+				for (size_t i = 0; ; ++i) {
+					uint64_t sym;
+					if (i == Varint<T>::maxSize || !readBits(sym, 8)) {
+						return false;
+					}
+					temp |= (sym & 0x7F) << (7 * i);
+					if ((sym & 0x80) == 0) {
+						break;
+					}
+				}
+				value.setValue(detail::zigzagDecode<T>(temp));
+				return true;
+			}
+
+			template <typename T>
+			bool deserialize(BaseVectorType<T>& value) {
+				return deserializeContainer(value);
+			}
+
+			bool deserialize(BaseStringType& value) {
+				return deserializeContainer(value);
+			}
+
+			bool deserialize(bool& value) {
+				uint64_t temp;
+				if (!readBits(temp, 1)) {
+					return false;
+				}
+				value = temp != 0;
+				return true;
+			}
+
+			bool deserialize(float& value) {
+				uint64_t temp;
+				if (!readBits(temp, 32)) {
+					return false;
+				}
+				auto bits = static_cast<uint32_t>(temp);
+				memcpy(&value, &bits, sizeof(value));
+				return true;
+			}
+
+			bool deserialize(double& value) {
+				uint64_t temp;
+				if (!deserializeBits(temp, 64)) {
+					return false;
+				}
+				memcpy(&value, &temp, sizeof(value));
+				return true;
+			}
+
+			SERIALIZATION_BIT_PACKED_DESERIALIZE_BASE_TYPE(char)
+			SERIALIZATION_BIT_PACKED_DESERIALIZE_BASE_TYPE(uint8_t)
+			SERIALIZATION_BIT_PACKED_DESERIALIZE_BASE_TYPE(int8_t)
+			SERIALIZATION_BIT_PACKED_DESERIALIZE_BASE_TYPE(uint16_t)
+			SERIALIZATION_BIT_PACKED_DESERIALIZE_BASE_TYPE(int16_t)
+			SERIALIZATION_BIT_PACKED_DESERIALIZE_BASE_TYPE(uint32_t)
+			SERIALIZATION_BIT_PACKED_DESERIALIZE_BASE_TYPE(int32_t)
+			SERIALIZATION_BIT_PACKED_DESERIALIZE_BASE_TYPE(uint64_t)
+			SERIALIZATION_BIT_PACKED_DESERIALIZE_BASE_TYPE(int64_t)
+
+			//Drops the bits left in the last read byte
+			void align() {
+				_accumulator = 0;
+				_bitCount = 0;
+			}
+
+		private:
+			//count is 1..32, reads only the whole bytes missing from the register
+			bool readBits(uint64_t& value, unsigned count) {
+				if (_bitCount < count) {
+					uint8_t buffer[sizeof(uint32_t)];
+					auto size = (count - _bitCount + 7) / 8;
+					if (!_reader->read(buffer, size)) {
+						return false;
+					}
+					for (unsigned i = 0; i < size; ++i) {
+						_accumulator |= static_cast<uint64_t>(buffer[i]) << _bitCount;
+						_bitCount += 8;
+					}
+				}
+				value = _accumulator & (~static_cast<uint64_t>(0) >> (64 - count));
+				_accumulator >>= count;
+				_bitCount -= count;
+				return true;
+			}
+
+			template<typename T>
+			bool deserializeContainer(T& value) {
+				Varint64 containerSize;
+				if (!deserialize(containerSize)) {
+					return false;
+				}
+				//Every item takes at least one bit
+				size_t availableSize;
+				if (_reader->peek(availableSize) != nullptr && containerSize.getValue() > static_cast<uint64_t>(availableSize) * 8 + _bitCount) {
+					return false;
+				}
+
+				#if defined(ARDUINO)
+					value.reserve(static_cast<size_t>(containerSize.getValue()));
+				#else
+					value.resize(static_cast<size_t>(containerSize.getValue()));
+				#endif
+				for (size_t i = 0; i < containerSize.getValue(); ++i) {
+					if (!deserialize(value[i])) {
+						return false;
+					}
+				}
+				return true;
+			}
+
+			StreamReader* _reader;
+			uint64_t _accumulator = 0;
+			unsigned _bitCount = 0;
+		};
+
+		using BitPackedDeserializer = BasicBitPackedDeserializer<IStreamReader>;
+
+	#undef SERIALIZATION_BIT_PACKED_SERIALIZE_BASE_TYPE
+	#undef SERIALIZATION_BIT_PACKED_DESERIALIZE_BASE_TYPE
+	}
+}
+
+#endif // BitPackedSerialization_H
@@ -0,0 +1,171 @@
+#ifndef BufferedStream_H
+#define BufferedStream_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <assert.h>
+
+#include "StreamSerialization.h"
+
+namespace Antilatency {
+	namespace Serialization {
+
+		namespace BufferedStream {
+		#if defined(ARDUINO)
+			static constexpr size_t DefaultBlockSize = 64;
+		#else
+			static constexpr size_t DefaultBlockSize = 4096;
+		#endif
+		}
+
+		//Collects small writes into blocks of blockSize bytes. Call flush() after the last write.
+		class BufferedStreamWriter final : public IStreamWriter {
+		public:
+			explicit BufferedStreamWriter(IStreamWriter* writer, size_t blockSize = BufferedStream::DefaultBlockSize) :
+				_writer(writer),
+				_blockSize(blockSize),
+				_buffer(new uint8_t[blockSize])
+			{
+				assert(writer != nullptr);
+				assert(blockSize != 0);
+			}
+
+			BufferedStreamWriter(const BufferedStreamWriter&) = delete;
+			BufferedStreamWriter& operator=(const BufferedStreamWriter&) = delete;
+
+			~BufferedStreamWriter() {
+				delete[] _buffer;
+			}
+
+			bool write(const uint8_t* buffer, size_t size) override {
+				if (_size + size <= _blockSize) {
+					memcpy(_buffer + _size, buffer, size);
+					_size += size;
+					return true;
+				}
+				if (!flush()) {
+					return false;
+				}
+				if (size >= _blockSize) {
+					return _writer->write(buffer, size);
+				}
+				memcpy(_buffer, buffer, size);
+				_size = size;
+				return true;
+			}
+
+			bool flush() {
+				if (_size == 0) {
+					return true;
+				}
+				auto size = _size;
+				_size = 0;
+				return _writer->write(_buffer, size);
+			}
+
+			size_t getBufferedSize() const {
+				return _size;
+			}
+
+		private:
+			IStreamWriter* _writer;
+			size_t _blockSize;
+			uint8_t* _buffer;
+			size_t _size = 0;
+		};
+
+		//Refills its block with IStreamReader::readSome, so it never waits for more bytes than the caller asked for.
+		//Bytes left in the block after the last read stay in the BufferedStreamReader.
+		class BufferedStreamReader final : public IStreamReader {
+		public:
+			explicit BufferedStreamReader(IStreamReader* reader, size_t blockSize = BufferedStream::DefaultBlockSize) :
+				_reader(reader),
+				_blockSize(blockSize),
+				_buffer(new uint8_t[blockSize])
+			{
+				assert(reader != nullptr);
+				assert(blockSize != 0);
+			}
+
+			BufferedStreamReader(const BufferedStreamReader&) = delete;
+			BufferedStreamReader& operator=(const BufferedStreamReader&) = delete;
+
+			~BufferedStreamReader() {
+				delete[] _buffer;
+			}
+
+			bool read(uint8_t* buffer, size_t size) override {
+				auto buffered = _end - _begin;
+				if (size <= buffered) {
+					memcpy(buffer, _buffer + _begin, size);
+					_begin += size;
+					return true;
+				}
+
+				memcpy(buffer, _buffer + _begin, buffered);
+				buffer += buffered;
+				size -= buffered;
+				_begin = 0;
+				_end = 0;
+
+				if (size >= _blockSize) {
+					return _reader->read(buffer, size);
+				}
+
+				while (_end < size) {
+					auto readSize = _reader->readSome(_buffer + _end, _blockSize - _end);
+					if (readSize == 0) {
+						return false;
+					}
+					_end += readSize;
+				}
+				memcpy(buffer, _buffer, size);
+				_begin = size;
+				return true;
+			}
+
+			size_t readSome(uint8_t* buffer, size_t maxSize) override {
+				if (maxSize == 0) {
+					return 0;
+				}
+				if (_begin == _end) {
+					if (maxSize >= _blockSize) {
+						return _reader->readSome(buffer, maxSize);
+					}
+					_begin = 0;
+					_end = _reader->readSome(_buffer, _blockSize);
+				}
+				auto buffered = _end - _begin;
+				auto size = maxSize < buffered ? maxSize : buffered;
+				memcpy(buffer, _buffer + _begin, size);
+				_begin += size;
+				return size;
+			}
+
+			bool skip(size_t size) override {
+				auto buffered = _end - _begin;
+				if (size <= buffered) {
+					_begin += size;
+					return true;
+				}
+				_begin = 0;
+				_end = 0;
+				return _reader->skip(size - buffered);
+			}
+
+			size_t getBufferedSize() const {
+				return _end - _begin;
+			}
+
+		private:
+			IStreamReader* _reader;
+			size_t _blockSize;
+			uint8_t* _buffer;
+			size_t _begin = 0;
+			size_t _end = 0;
+		};
+	}
+}
+
+#endif // BufferedStream_H
@@ -0,0 +1,244 @@
+#ifndef ChecksumStream_H
+#define ChecksumStream_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <assert.h>
+
+#include "BaseTypes.h"
+#include "StreamSerialization.h"
+
+#if defined(ANTILATENCY_SERIALIZATION_SSE42)
+	#include <nmmintrin.h>
+#elif defined(ANTILATENCY_SERIALIZATION_ARM_CRC32)
+	#include <arm_acle.h>
+#endif
+
+namespace Antilatency {
+	namespace Serialization {
+
+		//CRC32C (Castagnoli), the checksum of iSCSI and ext4. SSE4.2 and ARMv8 compute it with a single instruction per 8 bytes,
+		//other platforms use slicing-by-8 tables (8 KiB), ARDUINO uses a 16 entry table to save memory.
+		namespace Crc32c {
+			static constexpr uint32_t Polynomial = 0x82F63B78;
+			static constexpr uint32_t Initial = 0xFFFFFFFF;
+			static constexpr size_t TrailerSize = sizeof(uint32_t);
+
+		#if defined(ARDUINO)
+			struct LookupTable {
+				uint32_t values[16];
+			};
+
+			constexpr LookupTable makeLookupTable() {
+				LookupTable table{};
+				for (uint32_t i = 0; i < 16; ++i) {
+					uint32_t crc = i;
+					for (int bit = 0; bit < 4; ++bit) {
+						crc = (crc >> 1) ^ ((crc & 1) != 0 ? Polynomial : 0);
+					}
+					table.values[i] = crc;
+				}
+				return table;
+			}
+
+			static constexpr LookupTable Table = makeLookupTable();
+
+			//Continues crc, as returned by previous updates and without the final inversion, over size bytes
+			inline uint32_t updateTable(uint32_t crc, const uint8_t* data, size_t size) {
+				for (size_t i = 0; i < size; ++i) {
+					crc ^= data[i];
+					crc = (crc >> 4) ^ Table.values[crc & 0xF];
+					crc = (crc >> 4) ^ Table.values[crc & 0xF];
+				}
+				return crc;
+			}
+		#else
+			struct LookupTable {
+				uint32_t values[8][256];
+			};
+
+			constexpr LookupTable makeLookupTable() {
+				LookupTable table{};
+				for (uint32_t i = 0; i < 256; ++i) {
+					uint32_t crc = i;
+					for (int bit = 0; bit < 8; ++bit) {
+						crc = (crc >> 1) ^ ((crc & 1) != 0 ? Polynomial : 0);
+					}
+					table.values[0][i] = crc;
+				}
+				//Slice s is the crc of a byte followed by s zero bytes
+				for (size_t s = 1; s < 8; ++s) {
+					for (size_t i = 0; i < 256; ++i) {
+						auto previous = table.values[s - 1][i];
+						table.values[s][i] = (previous >> 8) ^ table.values[0][previous & 0xFF];
+					}
+				}
+				return table;
+			}
+
+			static constexpr LookupTable Table = makeLookupTable();
+
+			//Continues crc, as returned by previous updates and without the final inversion, over size bytes
+			inline uint32_t updateTable(uint32_t crc, const uint8_t* data, size_t size) {
+			#if SERIALIZATION_BYTE_ORDER == SERIALIZATION_LITTLE_ENDIAN
+				for (; size >= 8; size -= 8, data += 8) {
+					uint32_t low;
+					uint32_t high;
+					memcpy(&low, data, sizeof(low));
+					memcpy(&high, data + 4, sizeof(high));
+					low ^= crc;
+					crc = Table.values[7][low & 0xFF] ^ Table.values[6][(low >> 8) & 0xFF] ^
+						Table.values[5][(low >> 16) & 0xFF] ^ Table.values[4][low >> 24] ^
+						Table.values[3][high & 0xFF] ^ Table.values[2][(high >> 8) & 0xFF] ^
+						Table.values[1][(high >> 16) & 0xFF] ^ Table.values[0][high >> 24];
+				}
+			#endif
+				for (size_t i = 0; i < size; ++i) {
+					crc = (crc >> 8) ^ Table.values[0][(crc ^ data[i]) & 0xFF];
+				}
+				return crc;
+			}
+		#endif
+
+			inline uint32_t update(uint32_t crc, const uint8_t* data, size_t size) {
+			#if defined(ANTILATENCY_SERIALIZATION_SSE42) && (defined(__x86_64__) || defined(_M_X64))
+				uint64_t crc64 = crc;
+				for (; size >= 8; size -= 8, data += 8) {
+					uint64_t word;
+					memcpy(&word, data, sizeof(word));
+					crc64 = _mm_crc32_u64(crc64, word);
+				}
+				crc = static_cast<uint32_t>(crc64);
+				for (size_t i = 0; i < size; ++i) {
+					crc = _mm_crc32_u8(crc, data[i]);
+				}
+				return crc;
+			#elif defined(ANTILATENCY_SERIALIZATION_SSE42)
+				for (; size >= 4; size -= 4, data += 4) {
+					uint32_t word;
+					memcpy(&word, data, sizeof(word));
+					crc = _mm_crc32_u32(crc, word);
+				}
+				for (size_t i = 0; i < size; ++i) {
+					crc = _mm_crc32_u8(crc, data[i]);
+				}
+				return crc;
+			#elif defined(ANTILATENCY_SERIALIZATION_ARM_CRC32)
+				for (; size >= 8; size -= 8, data += 8) {
+					uint64_t word;
+					memcpy(&word, data, sizeof(word));
+					crc = __crc32cd(crc, word);
+				}
+				for (size_t i = 0; i < size; ++i) {
+					crc = __crc32cb(crc, data[i]);
+				}
+				return crc;
+			#else
+				return updateTable(crc, data, size);
+			#endif
+			}
+
+			inline uint32_t compute(const uint8_t* data, size_t size) {
+				return ~update(Initial, data, size);
+			}
+		}
+
+		//Passes everything through to writer and keeps the CRC32C of it. finish() appends the checksum
+		//as a 4 byte little-endian trailer and starts the next one. The checksum is computed over whole writes,
+		//put a BufferedStreamWriter in front when the serializer writes field by field.
+		class ChecksumStreamWriter final : public IStreamWriter {
+		public:
+			explicit ChecksumStreamWriter(IStreamWriter* writer) : _writer(writer) {
+				assert(writer != nullptr);
+			}
+
+			bool write(const uint8_t* buffer, size_t size) override {
+				_crc = Crc32c::update(_crc, buffer, size);
+				return _writer->write(buffer, size);
+			}
+
+			uint32_t getChecksum() const {
+				return ~_crc;
+			}
+
+			bool finish() {
+				auto checksum = getChecksum();
+				_crc = Crc32c::Initial;
+				const uint8_t trailer[Crc32c::TrailerSize] = {
+					static_cast<uint8_t>(checksum),
+					static_cast<uint8_t>(checksum >> 8),
+					static_cast<uint8_t>(checksum >> 16),
+					static_cast<uint8_t>(checksum >> 24)
+				};
+				return _writer->write(trailer, sizeof(trailer));
+			}
+
+		private:
+			IStreamWriter* _writer;
+			uint32_t _crc = Crc32c::Initial;
+		};
+
+		//Keeps the CRC32C of everything read, verify() reads the trailer written by ChecksumStreamWriter::finish and starts the next checksum.
+		//Memory backed readers stay zero-copy: peeked bytes are checksummed once they are skipped.
+		class ChecksumStreamReader final : public IStreamReader {
+		public:
+			explicit ChecksumStreamReader(IStreamReader* reader) : _reader(reader) {
+				assert(reader != nullptr);
+			}
+
+			bool read(uint8_t* buffer, size_t size) override {
+				if (!_reader->read(buffer, size)) {
+					return false;
+				}
+				_crc = Crc32c::update(_crc, buffer, size);
+				return true;
+			}
+
+			size_t readSome(uint8_t* buffer, size_t maxSize) override {
+				auto size = _reader->readSome(buffer, maxSize);
+				_crc = Crc32c::update(_crc, buffer, size);
+				return size;
+			}
+
+			const uint8_t* peek(size_t& availableSize) override {
+				return _reader->peek(availableSize);
+			}
+
+			bool skip(size_t size) override {
+				size_t availableSize;
+				auto data = _reader->peek(availableSize);
+				if (data == nullptr) {
+					return IStreamReader::skip(size);
+				}
+				if (size > availableSize || !_reader->skip(size)) {
+					return false;
+				}
+				_crc = Crc32c::update(_crc, data, size);
+				return true;
+			}
+
+			uint32_t getChecksum() const {
+				return ~_crc;
+			}
+
+			bool verify() {
+				auto checksum = getChecksum();
+				_crc = Crc32c::Initial;
+				uint8_t trailer[Crc32c::TrailerSize];
+				if (!_reader->read(trailer, sizeof(trailer))) {
+					return false;
+				}
+				auto expected = static_cast<uint32_t>(trailer[0]) | (static_cast<uint32_t>(trailer[1]) << 8) |
+					(static_cast<uint32_t>(trailer[2]) << 16) | (static_cast<uint32_t>(trailer[3]) << 24);
+				return checksum == expected;
+			}
+
+		private:
+			IStreamReader* _reader;
+			uint32_t _crc = Crc32c::Initial;
+		};
+	}
+}
+
+#endif // ChecksumStream_H
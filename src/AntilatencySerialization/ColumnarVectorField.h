@@ -0,0 +1,434 @@
+#ifndef ColumnarVectorField_H
+#define ColumnarVectorField_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "BaseTypes.h"
+#include "Varint.h"
+#include "Fields.h"
+#include "Structures.h"
+#include "Span.h"
+#include "BinarySerialization.h"
+
+namespace Antilatency {
+	namespace Serialization {
+
+		enum class ColumnEncoding : uint8_t {
+			//Varint64 count followed by count values
+			Raw = 0,
+			//Single value repeated for every row
+			Constant = 1,
+			//Bytes of count zigzag varints, each the difference to the previous row, integer columns only
+			Delta = 2
+		};
+
+		namespace ColumnarVector {
+		#if defined(ARDUINO)
+			static constexpr size_t DefaultMaxConstantRows = 256;
+		#else
+			static constexpr size_t DefaultMaxConstantRows = 1 << 20;
+		#endif
+		}
+
+		namespace detail {
+			//Types a column can hold. bool is left out since BaseVectorType<bool> may be packed.
+			template<typename T>
+			struct ColumnTraits;
+
+		#define SERIALIZATION_INTEGER_COLUMN(type, unsignedType, signedType) template<> struct ColumnTraits<type> { \
+				static constexpr bool IsInteger = true; \
+				using UnsignedType = unsignedType; \
+				using SignedType = signedType; \
+			};
+		#define SERIALIZATION_PLAIN_COLUMN(type) template<> struct ColumnTraits<type> { \
+				static constexpr bool IsInteger = false; \
+			};
+			SERIALIZATION_INTEGER_COLUMN(char, uint8_t, int8_t)
+			SERIALIZATION_INTEGER_COLUMN(uint8_t, uint8_t, int8_t)
+			SERIALIZATION_INTEGER_COLUMN(int8_t, uint8_t, int8_t)
+			SERIALIZATION_INTEGER_COLUMN(uint16_t, uint16_t, int16_t)
+			SERIALIZATION_INTEGER_COLUMN(int16_t, uint16_t, int16_t)
+			SERIALIZATION_INTEGER_COLUMN(uint32_t, uint32_t, int32_t)
+			SERIALIZATION_INTEGER_COLUMN(int32_t, uint32_t, int32_t)
+			SERIALIZATION_INTEGER_COLUMN(uint64_t, uint64_t, int64_t)
+			SERIALIZATION_INTEGER_COLUMN(int64_t, uint64_t, int64_t)
+			SERIALIZATION_PLAIN_COLUMN(float)
+			SERIALIZATION_PLAIN_COLUMN(double)
+		#undef SERIALIZATION_INTEGER_COLUMN
+		#undef SERIALIZATION_PLAIN_COLUMN
+
+			template<typename Field>
+			struct ColumnType {
+				static_assert(sizeof(Field) == 0, "Columnar structures must consist of SingleFields of base types");
+			};
+
+			template<typename T, typename Name>
+			struct ColumnType<SingleField<T, Name>> {
+				using Type = T;
+			};
+
+			//Rows being deserialized. They are allocated by the first Raw or Delta column, whose bytes show the data holds count rows,
+			//values of Constant columns read before it are kept in a prototype row.
+			template<typename Row>
+			class ColumnarRows {
+			public:
+				ColumnarRows(BaseVectorType<Row>& rows, size_t count) :
+					_rows(rows),
+					_count(count)
+				{
+				}
+
+				size_t getCount() const {
+					return _count;
+				}
+
+				BaseVectorType<uint8_t>& getStorage() {
+					return _storage;
+				}
+
+				BaseVectorType<Row>& getRows() {
+					if (!_isAllocated) {
+						_rows.resize(_count);
+						if (_hasConstants) {
+							for (size_t i = 0; i < _count; ++i) {
+								_rows[i] = _prototype;
+							}
+						}
+						_isAllocated = true;
+					}
+					return _rows;
+				}
+
+				template<size_t Index, typename Column>
+				void setConstant(const Column& value) {
+					if (!_isAllocated) {
+						_prototype.template getField<Index>().setValue(value);
+						_hasConstants = true;
+						return;
+					}
+					for (size_t i = 0; i < _count; ++i) {
+						_rows[i].template getField<Index>().setValue(value);
+					}
+				}
+
+				//Nothing bounds the count of Constant columns only
+				bool finish(size_t maxConstantRows) {
+					if (!_isAllocated && _count > maxConstantRows) {
+						return false;
+					}
+					getRows();
+					return true;
+				}
+
+			private:
+				BaseVectorType<Row>& _rows;
+				size_t _count;
+				BaseVectorType<uint8_t> _storage;
+				Row _prototype;
+				bool _hasConstants = false;
+				bool _isAllocated = false;
+			};
+
+			template<typename Row, size_t Index, typename Column>
+			struct ColumnCodec {
+				using Traits = ColumnTraits<Column>;
+
+				//Bitwise, so -0.0 and NaN payloads survive
+				static bool isConstant(const BaseVectorType<Row>& rows) {
+					bool result = rows.size() != 0;
+					for (size_t i = 1; i < rows.size() && result; ++i) {
+						result = memcmp(&getValue(rows[i]), &getValue(rows[0]), sizeof(Column)) == 0;
+					}
+					return result;
+				}
+
+				//scratch is shared by the columns, it only grows
+				template<typename Serializer>
+				static bool serialize(Serializer& serializer, const BaseVectorType<Row>& rows, BaseVectorType<uint8_t>& scratch, bool isConstantAllowed) {
+					auto count = rows.size();
+					if (isConstantAllowed && isConstant(rows)) {
+						return serializer.serialize(static_cast<uint8_t>(ColumnEncoding::Constant)) && serializer.serialize(getValue(rows[0]));
+					}
+
+					auto rawSize = count * sizeof(Column);
+					if (scratch.size() < rawSize + Varint64::maxSize) {
+						scratch.resize(rawSize + Varint64::maxSize);
+					}
+					size_t size;
+					if (encodeDeltas(rows, scratch.data(), size, BoolConstant<Traits::IsInteger>{})) {
+						return serializer.serialize(static_cast<uint8_t>(ColumnEncoding::Delta)) && serializer.serialize(Span<uint8_t>(scratch.data(), size));
+					}
+					//Same bytes as BaseVectorType<Column>
+					if (!serializer.serialize(static_cast<uint8_t>(ColumnEncoding::Raw)) || !serializer.serialize(Varint64(count))) {
+						return false;
+					}
+					for (size_t i = 0; i < count; ++i) {
+						if (!serializer.serialize(getValue(rows[i]))) {
+							return false;
+						}
+					}
+					return true;
+				}
+
+				//Raw and Delta columns are read from the stream memory when it has any, otherwise through the storage of rows
+				template<typename Deserializer>
+				static bool deserialize(Deserializer& deserializer, ColumnarRows<Row>& columnarRows) {
+					uint8_t encoding;
+					if (!deserializer.deserialize(encoding)) {
+						return false;
+					}
+					auto count = columnarRows.getCount();
+					switch (static_cast<ColumnEncoding>(encoding)) {
+					case ColumnEncoding::Raw: {
+						const uint8_t* data;
+						size_t size;
+						//count is at most SIZE_MAX / sizeof(Row)
+						if (!capture<BaseVectorType<Column>>(deserializer, data, size, columnarRows.getStorage()) || size != count * sizeof(Column)) {
+							return false;
+						}
+						auto& rows = columnarRows.getRows();
+						UncheckedMemoryStreamReader reader(data);
+						BasicBinaryDeserializer<UncheckedMemoryStreamReader> values(&reader);
+						for (size_t i = 0; i < count; ++i) {
+							Column value;
+							values.deserialize(value);
+							rows[i].template getField<Index>().setValue(value);
+						}
+						return true;
+					}
+					case ColumnEncoding::Constant: {
+						Column value;
+						if (!deserializer.deserialize(value)) {
+							return false;
+						}
+						columnarRows.template setConstant<Index>(value);
+						return true;
+					}
+					case ColumnEncoding::Delta: {
+						const uint8_t* data;
+						size_t size;
+						//Every row takes at least a byte
+						if (!capture<BaseVectorType<uint8_t>>(deserializer, data, size, columnarRows.getStorage()) || size < count) {
+							return false;
+						}
+						return decodeDeltas(data, size, columnarRows.getRows(), BoolConstant<Traits::IsInteger>{});
+					}
+					}
+					return false;
+				}
+
+				template<typename Deserializer>
+				static bool skip(Deserializer& deserializer) {
+					uint8_t encoding;
+					if (!deserializer.deserialize(encoding)) {
+						return false;
+					}
+					switch (static_cast<ColumnEncoding>(encoding)) {
+					case ColumnEncoding::Raw:
+						return deserializer.template skip<BaseVectorType<Column>>();
+					case ColumnEncoding::Constant:
+						return deserializer.template skip<Column>();
+					case ColumnEncoding::Delta:
+						return deserializer.template skip<BaseVectorType<uint8_t>>();
+					}
+					return false;
+				}
+
+			private:
+				//Returns false when deltas are not smaller than the raw column, random columns are given up after SampleSize rows
+				static constexpr size_t SampleSize = 64;
+
+				static const Column& getValue(const Row& row) {
+					return row.template getField<Index>().getValue();
+				}
+
+				//Skips a container and points data at its items, size is their byte count
+				template<typename Container, typename Deserializer>
+				static bool capture(Deserializer& deserializer, const uint8_t*& data, size_t& size, BaseVectorType<uint8_t>& storage) {
+					if (!deserializer.template capture<Container>(data, size, storage)) {
+						return false;
+					}
+					if (data == nullptr) {
+						data = storage.data();
+					}
+					uint64_t itemCount;
+					auto prefixSize = decodeVarint(data, size, itemCount);
+					if (prefixSize == 0) {
+						return false;
+					}
+					data += prefixSize;
+					size -= prefixSize;
+					return true;
+				}
+
+				static bool encodeDeltas(const BaseVectorType<Row>&, uint8_t*, size_t&, BoolConstant<false>) {
+					return false;
+				}
+
+				//deltas must hold the raw column and a varint
+				static bool encodeDeltas(const BaseVectorType<Row>& rows, uint8_t* deltas, size_t& size, BoolConstant<true>) {
+					using UnsignedType = typename Traits::UnsignedType;
+					using SignedType = typename Traits::SignedType;
+					auto rawSize = rows.size() * sizeof(Column);
+					UnsignedType previous = 0;
+					size = 0;
+					for (size_t i = 0; i < rows.size(); ++i) {
+						auto current = static_cast<UnsignedType>(getValue(rows[i]));
+						auto delta = static_cast<int64_t>(static_cast<SignedType>(static_cast<UnsignedType>(current - previous)));
+						//Small steps between neighbouring rows take a single byte
+						auto encoded = zigzagEncode(delta);
+						if (encoded < 0x80) {
+							deltas[size++] = static_cast<uint8_t>(encoded);
+						}
+						else {
+							size += encodeVarint(encoded, deltas + size);
+						}
+						if (size >= rawSize || (i + 1 == SampleSize && size >= SampleSize * sizeof(Column))) {
+							return false;
+						}
+						previous = current;
+					}
+					return true;
+				}
+
+				static bool decodeDeltas(const uint8_t*, size_t, BaseVectorType<Row>&, BoolConstant<false>) {
+					return false;
+				}
+
+				static bool decodeDeltas(const uint8_t* deltas, size_t size, BaseVectorType<Row>& rows, BoolConstant<true>) {
+					using UnsignedType = typename Traits::UnsignedType;
+					UnsignedType previous = 0;
+					size_t position = 0;
+					for (size_t i = 0; i < rows.size(); ++i) {
+						uint64_t encoded;
+						//Small steps between neighbouring rows take a single byte
+						if (position < size && deltas[position] < 0x80) {
+							encoded = deltas[position++];
+						}
+						else {
+							auto varintSize = decodeVarint(deltas + position, size - position, encoded);
+							if (varintSize == 0) {
+								return false;
+							}
+							position += varintSize;
+						}
+						previous = static_cast<UnsignedType>(previous + static_cast<UnsignedType>(zigzagDecode<int64_t>(encoded)));
+						rows[i].template getField<Index>().setValue(static_cast<Column>(previous));
+					}
+					return position == size;
+				}
+			};
+
+			template<typename Row, typename StructureType>
+			struct ColumnarCodec;
+
+			template<typename Row, typename ... Fields>
+			struct ColumnarCodec<Row, Structure<Fields...>> {
+				using Indices = typename MakeIndexSequence<sizeof...(Fields)>::Type;
+
+				//More rows than maxConstantRows are only read when a column is not Constant, so the first column is written in full then
+				template<typename Serializer>
+				static bool serialize(Serializer& serializer, const BaseVectorType<Row>& rows, size_t maxConstantRows) {
+					BaseVectorType<uint8_t> scratch;
+					auto isConstantAllowed = rows.size() <= maxConstantRows || !isConstant(rows, Indices{});
+					return serialize(serializer, rows, scratch, isConstantAllowed, Indices{});
+				}
+
+				template<typename Deserializer>
+				static bool deserialize(Deserializer& deserializer, BaseVectorType<Row>& rows, size_t count, size_t maxConstantRows) {
+					ColumnarRows<Row> columnarRows(rows, count);
+					return deserialize(deserializer, columnarRows, Indices{}) && columnarRows.finish(maxConstantRows);
+				}
+
+				template<typename Deserializer>
+				static bool skip(Deserializer& deserializer) {
+					return skip(deserializer, Indices{});
+				}
+
+			private:
+				template<size_t ... I>
+				static bool isConstant(const BaseVectorType<Row>& rows, IndexSequence<I...>) {
+					bool result = true;
+					const int dummy[] = { (result = result && ColumnCodec<Row, I, typename ColumnType<Fields>::Type>::isConstant(rows), 0)... };
+					static_cast<void>(dummy);
+					return result;
+				}
+
+				template<typename Serializer, size_t ... I>
+				static bool serialize(Serializer& serializer, const BaseVectorType<Row>& rows, BaseVectorType<uint8_t>& scratch, bool isConstantAllowed, IndexSequence<I...>) {
+					bool isOk = true;
+					const int dummy[] = { (isOk = isOk && ColumnCodec<Row, I, typename ColumnType<Fields>::Type>::serialize(serializer, rows, scratch, I != 0 || isConstantAllowed), 0)... };
+					static_cast<void>(dummy);
+					return isOk;
+				}
+
+				template<typename Deserializer, size_t ... I>
+				static bool deserialize(Deserializer& deserializer, ColumnarRows<Row>& columnarRows, IndexSequence<I...>) {
+					bool isOk = true;
+					const int dummy[] = { (isOk = isOk && ColumnCodec<Row, I, typename ColumnType<Fields>::Type>::deserialize(deserializer, columnarRows), 0)... };
+					static_cast<void>(dummy);
+					return isOk;
+				}
+
+				template<typename Deserializer, size_t ... I>
+				static bool skip(Deserializer& deserializer, IndexSequence<I...>) {
+					bool isOk = true;
+					const int dummy[] = { (isOk = isOk && ColumnCodec<Row, I, typename ColumnType<Fields>::Type>::skip(deserializer), 0)... };
+					static_cast<void>(dummy);
+					return isOk;
+				}
+			};
+		}
+
+		//Vector of structures written column by column: Varint64 row count, then for every field of T
+		//a ColumnEncoding byte and the column in that encoding. Each column picks Constant when all rows are equal,
+		//Delta when the varint differences are smaller than the raw values and Raw otherwise.
+		//T must be a Structure (or derived from one) of SingleFields of integer or floating point types.
+		//Rows are allocated once a Raw or Delta column shows the data holds them. Constant columns carry no such proof,
+		//so a message of Constant columns only is limited to MaxConstantRows rows and larger vectors get a first column in full.
+		template <typename T, typename Name, size_t MaxConstantRows = ColumnarVector::DefaultMaxConstantRows>
+		class ColumnarVectorField : public Field<Name> {
+			using Codec = detail::ColumnarCodec<T, decltype(detail::structureOf(static_cast<const T*>(nullptr)))>;
+		public:
+			using Type = BaseVectorType<T>;
+
+			const Type& getValue() const {
+				return _value;
+			}
+
+			Type& getValue() {
+				return _value;
+			}
+
+			void setValue(const Type& value) {
+				_value = value;
+			}
+
+			template<typename Serializer>
+			size_t serialize(Serializer& serializer) const {
+				return serializer.serialize(Varint64(_value.size())) && Codec::serialize(serializer, _value, MaxConstantRows);
+			}
+
+			template<typename Deserializer>
+			size_t deserialize(Deserializer& deserializer) {
+				Varint64 count;
+				if (!deserializer.deserialize(count) || count.getValue() > static_cast<uint64_t>(SIZE_MAX / sizeof(T))) {
+					return false;
+				}
+				return Codec::deserialize(deserializer, _value, static_cast<size_t>(count.getValue()), MaxConstantRows);
+			}
+
+			template<typename Deserializer>
+			static bool skip(Deserializer& deserializer) {
+				Varint64 count;
+				return deserializer.deserialize(count) && Codec::skip(deserializer);
+			}
+
+		private:
+			Type _value;
+		};
+	}
+}
+
+#endif // ColumnarVectorField_H
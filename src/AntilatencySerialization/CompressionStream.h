@@ -0,0 +1,438 @@
+#ifndef CompressionStream_H
+#define CompressionStream_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <assert.h>
+
+#include "BaseTypes.h"
+#include "Varint.h"
+#include "StreamSerialization.h"
+
+namespace Antilatency {
+	namespace Serialization {
+
+		//LZ77 block codec in the LZ4 sequence format: a token with 4 bits of literal length and 4 bits of match length,
+		//extra length bytes of 255, the literals, a 2-byte little-endian offset and extra match length bytes.
+		//The last sequence of a block has literals only.
+		namespace Compression {
+		#if defined(ARDUINO)
+			static constexpr size_t DefaultBlockSize = 256;
+			static constexpr size_t HashLog = 8;
+		#else
+			static constexpr size_t DefaultBlockSize = 65536;
+			static constexpr size_t HashLog = 12;
+		#endif
+			//Positions in the hash table are 16 bit
+			static constexpr size_t MaxBlockSize = 65536;
+			static constexpr size_t HashTableSize = static_cast<size_t>(1) << HashLog;
+
+			static constexpr size_t MinMatch = 4;
+			static constexpr size_t MaxOffset = 65535;
+			//A match can not start in the last MatchSafeDistance bytes and the last LastLiterals bytes are always literals,
+			//so the decoder never meets a match right at the end of a block
+			static constexpr size_t LastLiterals = 5;
+			static constexpr size_t MatchSafeDistance = 12;
+
+			namespace detail {
+				inline uint32_t read32(const uint8_t* data) {
+					uint32_t result;
+					memcpy(&result, data, sizeof(result));
+					return result;
+				}
+
+				inline size_t hash(uint32_t sequence) {
+					return static_cast<size_t>((sequence * 2654435761u) >> (32 - HashLog));
+				}
+
+				//Number of equal bytes at a and b, b + result never passes limit
+				inline size_t matchLength(const uint8_t* a, const uint8_t* b, const uint8_t* limit) {
+					auto start = b;
+				#if SERIALIZATION_BYTE_ORDER == SERIALIZATION_LITTLE_ENDIAN
+					while (limit - b >= static_cast<ptrdiff_t>(sizeof(uint64_t))) {
+						uint64_t wordA;
+						uint64_t wordB;
+						memcpy(&wordA, a, sizeof(wordA));
+						memcpy(&wordB, b, sizeof(wordB));
+						auto difference = wordA ^ wordB;
+						if (difference != 0) {
+							return static_cast<size_t>(b - start) + countTrailingZeros(difference) / 8;
+						}
+						a += sizeof(uint64_t);
+						b += sizeof(uint64_t);
+					}
+				#endif
+					while (b < limit && *a == *b) {
+						++a;
+						++b;
+					}
+					return static_cast<size_t>(b - start);
+				}
+
+				inline uint8_t* writeLength(uint8_t* output, size_t length) {
+					while (length >= 255) {
+						*output++ = 255;
+						length -= 255;
+					}
+					*output++ = static_cast<uint8_t>(length);
+					return output;
+				}
+
+				//Worst case size of a sequence, checked before it is written
+				inline size_t sequenceBound(size_t literalLength) {
+					return 1 + literalLength / 255 + 1 + literalLength + 2;
+				}
+			}
+
+			//Hashes every position of size bytes (at most MaxBlockSize), so blocks compressed after them can reference them
+			inline void primeHashTable(const uint8_t* data, size_t size, uint16_t* hashTable) {
+				assert(size <= MaxBlockSize);
+				memset(hashTable, 0, HashTableSize * sizeof(uint16_t));
+				for (size_t i = 0; i + MinMatch <= size; ++i) {
+					hashTable[detail::hash(detail::read32(data + i))] = static_cast<uint16_t>(i);
+				}
+			}
+
+			//Compresses size bytes that follow prefixSize bytes of history at input, matches reach at most maxOffset bytes back.
+			//The hash table must be cleared or primed with the history, its entries are positions from input.
+			//Returns the compressed size, or 0 when the result would not be smaller than capacity.
+			inline size_t compressBlock(const uint8_t* input, size_t prefixSize, size_t size, uint8_t* output, size_t capacity, uint16_t* hashTable, size_t maxOffset = MaxOffset) {
+				assert(prefixSize + size <= MaxBlockSize && maxOffset <= MaxOffset);
+				auto op = output;
+				auto outputEnd = output + capacity;
+				auto anchor = input + prefixSize;
+				auto inputEnd = anchor + size;
+
+				if (size > MatchSafeDistance) {
+					auto matchLimit = inputEnd - LastLiterals;
+					auto searchLimit = inputEnd - MatchSafeDistance;
+					auto ip = anchor;
+					while (ip < searchLimit) {
+						auto sequence = detail::read32(ip);
+						auto& entry = hashTable[detail::hash(sequence)];
+						auto candidate = input + entry;
+						entry = static_cast<uint16_t>(ip - input);
+						if (candidate >= ip || static_cast<size_t>(ip - candidate) > maxOffset || detail::read32(candidate) != sequence) {
+							//Incompressible runs are crossed with growing steps
+							ip += 1 + ((ip - anchor) >> 6);
+							continue;
+						}
+						while (ip > anchor && candidate > input && ip[-1] == candidate[-1]) {
+							--ip;
+							--candidate;
+						}
+						auto literalLength = static_cast<size_t>(ip - anchor);
+						auto length = MinMatch + detail::matchLength(candidate + MinMatch, ip + MinMatch, matchLimit);
+						if (static_cast<size_t>(outputEnd - op) < detail::sequenceBound(literalLength) + (length - MinMatch) / 255 + 1) {
+							return 0;
+						}
+
+						auto token = op++;
+						if (literalLength >= 15) {
+							*token = 15 << 4;
+							op = detail::writeLength(op, literalLength - 15);
+						}
+						else {
+							*token = static_cast<uint8_t>(literalLength << 4);
+						}
+						memcpy(op, anchor, literalLength);
+						op += literalLength;
+						auto offset = static_cast<size_t>(ip - candidate);
+						*op++ = static_cast<uint8_t>(offset);
+						*op++ = static_cast<uint8_t>(offset >> 8);
+						if (length - MinMatch >= 15) {
+							*token |= 15;
+							op = detail::writeLength(op, length - MinMatch - 15);
+						}
+						else {
+							*token |= static_cast<uint8_t>(length - MinMatch);
+						}
+
+						ip += length;
+						anchor = ip;
+						if (ip < searchLimit) {
+							hashTable[detail::hash(detail::read32(ip - 2))] = static_cast<uint16_t>(ip - 2 - input);
+						}
+					}
+				}
+
+				auto literalLength = static_cast<size_t>(inputEnd - anchor);
+				if (static_cast<size_t>(outputEnd - op) < detail::sequenceBound(literalLength)) {
+					return 0;
+				}
+				if (literalLength >= 15) {
+					*op++ = 15 << 4;
+					op = detail::writeLength(op, literalLength - 15);
+				}
+				else {
+					*op++ = static_cast<uint8_t>(literalLength << 4);
+				}
+				if (literalLength != 0) {
+					memcpy(op, anchor, literalLength);
+				}
+				op += literalLength;
+				return static_cast<size_t>(op - output);
+			}
+
+			//Compresses size bytes (at most MaxBlockSize) on their own, hashTable holds HashTableSize entries
+			inline size_t compressBlock(const uint8_t* input, size_t size, uint8_t* output, size_t capacity, uint16_t* hashTable) {
+				memset(hashTable, 0, HashTableSize * sizeof(uint16_t));
+				return compressBlock(input, 0, size, output, capacity, hashTable);
+			}
+
+			//Decompresses exactly outputSize bytes after prefixSize bytes of history at output,
+			//every length and offset is checked against the buffers
+			inline bool decompressBlock(const uint8_t* input, size_t inputSize, uint8_t* output, size_t prefixSize, size_t outputSize) {
+				auto ip = input;
+				auto inputEnd = input + inputSize;
+				auto op = output + prefixSize;
+				auto outputEnd = op + outputSize;
+
+				while (ip < inputEnd) {
+					auto token = *ip++;
+					size_t literalLength = token >> 4;
+					if (literalLength == 15) {
+						uint8_t extra;
+						do {
+							if (ip == inputEnd) {
+								return false;
+							}
+							extra = *ip++;
+							literalLength += extra;
+						} while (extra == 255);
+					}
+					if (literalLength > static_cast<size_t>(inputEnd - ip) || literalLength > static_cast<size_t>(outputEnd - op)) {
+						return false;
+					}
+					if (literalLength != 0) {
+						memcpy(op, ip, literalLength);
+					}
+					op += literalLength;
+					ip += literalLength;
+					if (ip == inputEnd) {
+						return op == outputEnd;
+					}
+
+					if (inputEnd - ip < 2) {
+						return false;
+					}
+					size_t offset = ip[0] | (static_cast<size_t>(ip[1]) << 8);
+					ip += 2;
+					if (offset == 0 || offset > static_cast<size_t>(op - output)) {
+						return false;
+					}
+					size_t length = token & 15;
+					if (length == 15) {
+						uint8_t extra;
+						do {
+							if (ip == inputEnd) {
+								return false;
+							}
+							extra = *ip++;
+							length += extra;
+						} while (extra == 255);
+					}
+					length += MinMatch;
+					if (length > static_cast<size_t>(outputEnd - op)) {
+						return false;
+					}
+
+					auto match = op - offset;
+					if (offset >= sizeof(uint64_t)) {
+						//Chunks never overlap their source, the tail is copied bytewise
+						while (length >= sizeof(uint64_t)) {
+							memcpy(op, match, sizeof(uint64_t));
+							op += sizeof(uint64_t);
+							match += sizeof(uint64_t);
+							length -= sizeof(uint64_t);
+						}
+					}
+					while (length > 0) {
+						*op++ = *match++;
+						--length;
+					}
+				}
+				return false;
+			}
+
+			inline bool decompressBlock(const uint8_t* input, size_t inputSize, uint8_t* output, size_t outputSize) {
+				return decompressBlock(input, inputSize, output, 0, outputSize);
+			}
+		}
+
+		//Compresses everything written into blocks of blockSize bytes and writes each as
+		//Varint32 raw size, Varint32 stored size and the stored bytes; a block that does not shrink is stored as is (stored size == raw size).
+		//Call flush() after the last write, it ends the current block.
+		class CompressingStreamWriter final : public IStreamWriter {
+		public:
+			explicit CompressingStreamWriter(IStreamWriter* writer, size_t blockSize = Compression::DefaultBlockSize) :
+				_writer(writer),
+				_blockSize(blockSize),
+				_buffer(new uint8_t[2 * blockSize]),
+				_hashTable(new uint16_t[Compression::HashTableSize])
+			{
+				assert(writer != nullptr);
+				assert(blockSize != 0 && blockSize <= Compression::MaxBlockSize);
+			}
+
+			CompressingStreamWriter(const CompressingStreamWriter&) = delete;
+			CompressingStreamWriter& operator=(const CompressingStreamWriter&) = delete;
+
+			~CompressingStreamWriter() {
+				delete[] _buffer;
+				delete[] _hashTable;
+			}
+
+			bool write(const uint8_t* buffer, size_t size) override {
+				while (size > 0) {
+					auto chunkSize = _blockSize - _size;
+					if (chunkSize > size) {
+						chunkSize = size;
+					}
+					memcpy(_buffer + _size, buffer, chunkSize);
+					_size += chunkSize;
+					buffer += chunkSize;
+					size -= chunkSize;
+					if (_size == _blockSize && !flush()) {
+						return false;
+					}
+				}
+				return true;
+			}
+
+			bool flush() {
+				if (_size == 0) {
+					return true;
+				}
+				auto rawSize = _size;
+				_size = 0;
+				auto compressed = _buffer + _blockSize;
+				auto storedSize = Compression::compressBlock(_buffer, rawSize, compressed, rawSize - 1, _hashTable);
+				auto stored = compressed;
+				if (storedSize == 0) {
+					storedSize = rawSize;
+					stored = _buffer;
+				}
+				uint8_t header[2 * Varint32::maxSize];
+				auto headerSize = detail::encodeVarint(rawSize, header);
+				headerSize += detail::encodeVarint(storedSize, header + headerSize);
+				return _writer->write(header, headerSize) && _writer->write(stored, storedSize);
+			}
+
+		private:
+			IStreamWriter* _writer;
+			size_t _blockSize;
+			uint8_t* _buffer;
+			uint16_t* _hashTable;
+			size_t _size = 0;
+		};
+
+		//Reads blocks written by CompressingStreamWriter one at a time as the caller asks for bytes.
+		//maxBlockSize must be at least the block size of the writer.
+		class DecompressingStreamReader final : public IStreamReader {
+		public:
+			explicit DecompressingStreamReader(IStreamReader* reader, size_t maxBlockSize = Compression::DefaultBlockSize) :
+				_reader(reader),
+				_maxBlockSize(maxBlockSize),
+				_buffer(new uint8_t[2 * maxBlockSize])
+			{
+				assert(reader != nullptr);
+				assert(maxBlockSize != 0 && maxBlockSize <= Compression::MaxBlockSize);
+			}
+
+			DecompressingStreamReader(const DecompressingStreamReader&) = delete;
+			DecompressingStreamReader& operator=(const DecompressingStreamReader&) = delete;
+
+			~DecompressingStreamReader() {
+				delete[] _buffer;
+			}
+
+			bool read(uint8_t* buffer, size_t size) override {
+				while (size > 0) {
+					if (_begin == _end && !readBlock()) {
+						return false;
+					}
+					auto chunkSize = _end - _begin;
+					if (chunkSize > size) {
+						chunkSize = size;
+					}
+					memcpy(buffer, _buffer + _begin, chunkSize);
+					_begin += chunkSize;
+					buffer += chunkSize;
+					size -= chunkSize;
+				}
+				return true;
+			}
+
+			size_t readSome(uint8_t* buffer, size_t maxSize) override {
+				if (maxSize == 0 || (_begin == _end && !readBlock())) {
+					return 0;
+				}
+				auto size = _end - _begin;
+				if (size > maxSize) {
+					size = maxSize;
+				}
+				memcpy(buffer, _buffer + _begin, size);
+				_begin += size;
+				return size;
+			}
+
+			size_t getBufferedSize() const {
+				return _end - _begin;
+			}
+
+		private:
+			bool readVarint(size_t& value) {
+				value = 0;
+				for (size_t i = 0; i < Varint32::maxSize; ++i) {
+					uint8_t sym;
+					if (!_reader->read(&sym, 1)) {
+						return false;
+					}
+					value |= static_cast<size_t>(sym & 0x7F) << (7 * i);
+					if ((sym & 0x80) == 0) {
+						return true;
+					}
+				}
+				return false;
+			}
+
+			bool readBlock() {
+				if (_isBroken) {
+					return false;
+				}
+				size_t rawSize;
+				size_t storedSize;
+				_isBroken = true;
+				if (!readVarint(rawSize) || !readVarint(storedSize) || rawSize == 0 || rawSize > _maxBlockSize || storedSize > rawSize) {
+					return false;
+				}
+				if (storedSize == rawSize) {
+					if (!_reader->read(_buffer, rawSize)) {
+						return false;
+					}
+				}
+				else {
+					auto compressed = _buffer + _maxBlockSize;
+					if (!_reader->read(compressed, storedSize) || !Compression::decompressBlock(compressed, storedSize, _buffer, rawSize)) {
+						return false;
+					}
+				}
+				_isBroken = false;
+				_begin = 0;
+				_end = rawSize;
+				return true;
+			}
+
+			IStreamReader* _reader;
+			size_t _maxBlockSize;
+			uint8_t* _buffer;
+			size_t _begin = 0;
+			size_t _end = 0;
+			bool _isBroken = false;
+		};
+	}
+}
+
+#endif // CompressionStream_H
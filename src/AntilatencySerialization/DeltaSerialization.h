@@ -0,0 +1,373 @@
+#ifndef DeltaSerialization_H
+#define DeltaSerialization_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "BaseTypes.h"
+#include "Varint.h"
+#include "Fields.h"
+#include "Structures.h"
+#include "BinarySerialization.h"
+
+namespace Antilatency {
+	namespace Serialization {
+
+		//Delta format of a Structure: a bitmap of (FieldCount + 7) / 8 bytes with a bit per changed field, then the changed fields.
+		//Integer and Varint fields are written as a zigzag varint difference, nested structures recursively,
+		//vectors as the new size, then for every 8 common elements a change mask followed by the changed elements, then appended elements.
+		//Other fields are written in full.
+		template<typename T>
+		class TrackedField;
+
+		namespace detail {
+
+			template<typename T>
+			struct DeltaCodec;
+
+			//Types derived from a Structure are coded as their Structure, other types in full
+			template<typename T, typename StructureType>
+			struct DeltaBaseCodec : DeltaCodec<StructureType> {};
+
+			template<typename T>
+			struct DeltaBaseCodec<T, void> {
+				static bool isChanged(const T& value, const T& previous) {
+					return !(value == previous);
+				}
+
+				template<typename Serializer>
+				static bool write(Serializer& serializer, const T& value, const T&) {
+					return serializer.serialize(value);
+				}
+
+				template<typename Deserializer>
+				static bool read(Deserializer& deserializer, T& value) {
+					return deserializer.deserialize(value);
+				}
+			};
+
+			template<typename T>
+			struct DeltaCodec : DeltaBaseCodec<T, decltype(structureOf(static_cast<const T*>(nullptr)))> {};
+
+			template<typename T, typename UnsignedType, typename SignedType>
+			struct DeltaIntegerCodec {
+				static bool isChanged(const T& value, const T& previous) {
+					return value != previous;
+				}
+
+				template<typename Serializer>
+				static bool write(Serializer& serializer, const T& value, const T& previous) {
+					auto difference = static_cast<SignedType>(static_cast<UnsignedType>(static_cast<UnsignedType>(value) - static_cast<UnsignedType>(previous)));
+					return serializer.serialize(Varint<int64_t>(difference));
+				}
+
+				template<typename Deserializer>
+				static bool read(Deserializer& deserializer, T& value) {
+					Varint<int64_t> difference;
+					if (!deserializer.deserialize(difference)) {
+						return false;
+					}
+					value = static_cast<T>(static_cast<UnsignedType>(static_cast<UnsignedType>(value) + static_cast<UnsignedType>(difference.getValue())));
+					return true;
+				}
+			};
+
+		#define SERIALIZATION_DELTA_INTEGER(type, unsignedType, signedType) \
+			template<> struct DeltaCodec<type> : DeltaIntegerCodec<type, unsignedType, signedType> {};
+			SERIALIZATION_DELTA_INTEGER(uint8_t, uint8_t, int8_t)
+			SERIALIZATION_DELTA_INTEGER(int8_t, uint8_t, int8_t)
+			SERIALIZATION_DELTA_INTEGER(uint16_t, uint16_t, int16_t)
+			SERIALIZATION_DELTA_INTEGER(int16_t, uint16_t, int16_t)
+			SERIALIZATION_DELTA_INTEGER(uint32_t, uint32_t, int32_t)
+			SERIALIZATION_DELTA_INTEGER(int32_t, uint32_t, int32_t)
+			SERIALIZATION_DELTA_INTEGER(uint64_t, uint64_t, int64_t)
+			SERIALIZATION_DELTA_INTEGER(int64_t, uint64_t, int64_t)
+		#undef SERIALIZATION_DELTA_INTEGER
+
+			template<typename T>
+			struct DeltaCodec<Varint<T>> {
+				static bool isChanged(const Varint<T>& value, const Varint<T>& previous) {
+					return value != previous;
+				}
+
+				template<typename Serializer>
+				static bool write(Serializer& serializer, const Varint<T>& value, const Varint<T>& previous) {
+					return DeltaCodec<T>::write(serializer, value.getValue(), previous.getValue());
+				}
+
+				template<typename Deserializer>
+				static bool read(Deserializer& deserializer, Varint<T>& value) {
+					return DeltaCodec<T>::read(deserializer, value.getRef());
+				}
+			};
+
+			template<typename T>
+			struct DeltaCodec<BaseVectorType<T>> {
+				static bool isChanged(const BaseVectorType<T>& value, const BaseVectorType<T>& previous) {
+					if (value.size() != previous.size()) {
+						return true;
+					}
+					for (size_t i = 0; i < value.size(); ++i) {
+						if (DeltaCodec<T>::isChanged(value[i], previous[i])) {
+							return true;
+						}
+					}
+					return false;
+				}
+
+				template<typename Serializer>
+				static bool write(Serializer& serializer, const BaseVectorType<T>& value, const BaseVectorType<T>& previous) {
+					if (!serializer.serialize(Varint64(value.size()))) {
+						return false;
+					}
+					auto commonSize = value.size() < previous.size() ? value.size() : previous.size();
+					for (size_t group = 0; group < commonSize; group += 8) {
+						auto groupSize = commonSize - group < 8 ? commonSize - group : 8;
+						uint8_t mask = 0;
+						for (size_t i = 0; i < groupSize; ++i) {
+							if (DeltaCodec<T>::isChanged(value[group + i], previous[group + i])) {
+								mask |= static_cast<uint8_t>(1 << i);
+							}
+						}
+						if (!serializer.serialize(mask)) {
+							return false;
+						}
+						for (size_t i = 0; i < groupSize; ++i) {
+							if (((mask >> i) & 1) && !DeltaCodec<T>::write(serializer, value[group + i], previous[group + i])) {
+								return false;
+							}
+						}
+					}
+					for (size_t i = commonSize; i < value.size(); ++i) {
+						if (!serializer.serialize(value[i])) {
+							return false;
+						}
+					}
+					return true;
+				}
+
+				template<typename Deserializer>
+				static bool read(Deserializer& deserializer, BaseVectorType<T>& value) {
+					Varint64 size;
+					if (!deserializer.deserialize(size) || size.getValue() > static_cast<uint64_t>(SIZE_MAX / sizeof(T))) {
+						return false;
+					}
+					auto commonSize = size.getValue() < value.size() ? static_cast<size_t>(size.getValue()) : value.size();
+					value.resize(commonSize);
+					for (size_t group = 0; group < commonSize; group += 8) {
+						auto groupSize = commonSize - group < 8 ? commonSize - group : 8;
+						uint8_t mask;
+						if (!deserializer.deserialize(mask)) {
+							return false;
+						}
+						for (size_t i = 0; i < groupSize; ++i) {
+							if (((mask >> i) & 1) && !DeltaCodec<T>::read(deserializer, value[group + i])) {
+								return false;
+							}
+						}
+					}
+					//Appended elements are added as they are read, so a broken size fails at the end of the data instead of allocating it
+					for (auto i = static_cast<uint64_t>(commonSize); i < size.getValue(); ++i) {
+						value.push_back(T());
+						if (!deserializer.deserialize(value.back())) {
+							return false;
+						}
+					}
+					return true;
+				}
+			};
+
+			template<typename F>
+			struct DeltaField {
+				static_assert(sizeof(F) != sizeof(F), "Field is not supported by delta serialization");
+			};
+
+			template<typename F>
+			struct DeltaValueField {
+				using Codec = DeltaCodec<typename F::Type>;
+
+				static bool isChanged(const F& field, const F& previous) {
+					return Codec::isChanged(field.getValue(), previous.getValue());
+				}
+
+				template<typename Serializer>
+				static bool write(Serializer& serializer, const F& field, const F& previous) {
+					return Codec::write(serializer, field.getValue(), previous.getValue());
+				}
+
+				template<typename Deserializer>
+				static bool read(Deserializer& deserializer, F& field) {
+					return Codec::read(deserializer, field.getValue());
+				}
+			};
+
+			template<typename T, typename Name>
+			struct DeltaField<SingleField<T, Name>> : DeltaValueField<SingleField<T, Name>> {};
+
+			template<typename T, typename Name>
+			struct DeltaField<ContainerField<T, Name>> : DeltaValueField<ContainerField<T, Name>> {};
+
+			template<typename F>
+			struct DeltaField<TrackedField<F>> : DeltaField<F> {
+				template<typename Deserializer>
+				static bool read(Deserializer& deserializer, TrackedField<F>& field) {
+					field.markDirty();
+					return DeltaField<F>::read(deserializer, field);
+				}
+			};
+
+			//Existence flag, then a delta against the previous value if it existed or the full value
+			template<typename T>
+			struct DeltaField<OptioinalField<T>> {
+				using Codec = DeltaCodec<typename T::Type>;
+
+				static bool isChanged(const OptioinalField<T>& field, const OptioinalField<T>& previous) {
+					if (field.isExists() != previous.isExists()) {
+						return true;
+					}
+					return field.isExists() && Codec::isChanged(field.getValue(), previous.getValue());
+				}
+
+				template<typename Serializer>
+				static bool write(Serializer& serializer, const OptioinalField<T>& field, const OptioinalField<T>& previous) {
+					if (!serializer.serialize(field.isExists())) {
+						return false;
+					}
+					if (!field.isExists()) {
+						return true;
+					}
+					if (previous.isExists()) {
+						return Codec::write(serializer, field.getValue(), previous.getValue());
+					}
+					return serializer.serialize(field.getValue());
+				}
+
+				template<typename Deserializer>
+				static bool read(Deserializer& deserializer, OptioinalField<T>& field) {
+					bool exists;
+					if (!deserializer.deserialize(exists)) {
+						return false;
+					}
+					if (!exists) {
+						field = OptioinalField<T>();
+						return true;
+					}
+					if (field.isExists()) {
+						return Codec::read(deserializer, field.getValue());
+					}
+					typename T::Type value;
+					if (!deserializer.deserialize(value)) {
+						return false;
+					}
+					field.setValue(value);
+					return true;
+				}
+			};
+
+			template<typename ... Fields>
+			struct DeltaCodec<Structure<Fields...>> {
+				using Type = Structure<Fields...>;
+				using Indices = typename MakeIndexSequence<sizeof...(Fields)>::Type;
+				static constexpr size_t BitmapSize = (sizeof...(Fields) + 7) / 8;
+
+				static bool isChanged(const Type& value, const Type& previous) {
+					return isChanged(value, previous, Indices{});
+				}
+
+				template<typename Serializer>
+				static bool write(Serializer& serializer, const Type& value, const Type& previous) {
+					return write(serializer, value, previous, Indices{});
+				}
+
+				template<typename Deserializer>
+				static bool read(Deserializer& deserializer, Type& value) {
+					uint8_t bitmap[BitmapSize];
+					for (size_t i = 0; i < BitmapSize; ++i) {
+						if (!deserializer.deserialize(bitmap[i])) {
+							return false;
+						}
+					}
+					return read(deserializer, value, bitmap, Indices{});
+				}
+
+			private:
+				template<size_t ... I>
+				static bool isChanged(const Type& value, const Type& previous, IndexSequence<I...>) {
+					bool result = false;
+					const int dummy[] = { (result = result || DeltaField<Fields>::isChanged(value.template getField<I>(), previous.template getField<I>()), 0)... };
+					static_cast<void>(dummy);
+					return result;
+				}
+
+				template<typename Serializer, size_t ... I>
+				static bool write(Serializer& serializer, const Type& value, const Type& previous, IndexSequence<I...>) {
+					const bool changed[] = { DeltaField<Fields>::isChanged(value.template getField<I>(), previous.template getField<I>())... };
+					uint8_t bitmap[BitmapSize] = {};
+					for (size_t i = 0; i < sizeof...(Fields); ++i) {
+						if (changed[i]) {
+							bitmap[i / 8] |= static_cast<uint8_t>(1 << (i % 8));
+						}
+					}
+					for (size_t i = 0; i < BitmapSize; ++i) {
+						if (!serializer.serialize(bitmap[i])) {
+							return false;
+						}
+					}
+					bool isOk = true;
+					const int dummy[] = { (isOk = isOk && (!changed[I] || DeltaField<Fields>::write(serializer, value.template getField<I>(), previous.template getField<I>())), 0)... };
+					static_cast<void>(dummy);
+					return isOk;
+				}
+
+				template<typename Deserializer, size_t ... I>
+				static bool read(Deserializer& deserializer, Type& value, const uint8_t* bitmap, IndexSequence<I...>) {
+					bool isOk = true;
+					const int dummy[] = { (isOk = isOk && (((bitmap[I / 8] >> (I % 8)) & 1) == 0 || DeltaField<Fields>::read(deserializer, value.template getField<I>())), 0)... };
+					static_cast<void>(dummy);
+					return isOk;
+				}
+			};
+		}
+
+		//Writes a Structure as the changes against a previous instance of the same type
+		template<typename StreamWriter>
+		class BasicDeltaSerializer {
+		public:
+			explicit BasicDeltaSerializer(StreamWriter* writer) :
+				_serializer(writer)
+			{
+			}
+
+			template<typename ... Fields>
+			bool serialize(const Structure<Fields...>& value, const Structure<Fields...>& previous) {
+				return detail::DeltaCodec<Structure<Fields...>>::write(_serializer, value, previous);
+			}
+
+		private:
+			BasicBinarySerializer<StreamWriter> _serializer;
+		};
+
+		using DeltaSerializer = BasicDeltaSerializer<IStreamWriter>;
+
+		//Applies changes written by DeltaSerializer, value must hold the same previous instance the sender used
+		template<typename StreamReader>
+		class BasicDeltaDeserializer {
+		public:
+			explicit BasicDeltaDeserializer(StreamReader* reader) :
+				_deserializer(reader)
+			{
+			}
+
+			template<typename ... Fields>
+			bool deserialize(Structure<Fields...>& value) {
+				return detail::DeltaCodec<Structure<Fields...>>::read(_deserializer, value);
+			}
+
+		private:
+			BasicBinaryDeserializer<StreamReader> _deserializer;
+		};
+
+		using DeltaDeserializer = BasicDeltaDeserializer<IStreamReader>;
+	}
+}
+
+#endif // DeltaSerialization_H
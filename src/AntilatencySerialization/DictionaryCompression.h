@@ -0,0 +1,469 @@
+#ifndef DictionaryCompression_H
+#define DictionaryCompression_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <assert.h>
+
+#include "BaseTypes.h"
+#include "Varint.h"
+#include "StreamSerialization.h"
+#include "BinarySerialization.h"
+#include "SizeCalculator.h"
+#include "CompressionStream.h"
+
+namespace Antilatency {
+	namespace Serialization {
+
+		namespace Compression {
+		#if defined(ARDUINO)
+			static constexpr size_t MaxDictionarySize = 512;
+			static constexpr size_t DefaultPacketSize = 128;
+		#else
+			static constexpr size_t MaxDictionarySize = 16384;
+			static constexpr size_t DefaultPacketSize = 4096;
+		#endif
+		}
+
+		//Bytes that packets are compressed against, usually trained from sample messages with DictionaryTrainer.
+		//The id goes into every packet, 0 is left for the empty dictionary.
+		class CompressionDictionary final {
+		public:
+			//Only the last MaxDictionarySize bytes of data are kept
+			CompressionDictionary(uint32_t id, const uint8_t* data, size_t size) :
+				_id(id),
+				_size(size < Compression::MaxDictionarySize ? size : Compression::MaxDictionarySize),
+				_data(new uint8_t[_size + 1]),
+				_hashTable(new uint16_t[Compression::HashTableSize])
+			{
+				if (_size != 0) {
+					memcpy(_data, data + size - _size, _size);
+				}
+				Compression::primeHashTable(_data, _size, _hashTable);
+			}
+
+			explicit CompressionDictionary(uint32_t id = 0) : CompressionDictionary(id, nullptr, 0) {}
+
+			CompressionDictionary(const CompressionDictionary&) = delete;
+			CompressionDictionary& operator=(const CompressionDictionary&) = delete;
+
+			~CompressionDictionary() {
+				delete[] _data;
+				delete[] _hashTable;
+			}
+
+			uint32_t getId() const {
+				return _id;
+			}
+
+			const uint8_t* data() const {
+				return _data;
+			}
+
+			size_t size() const {
+				return _size;
+			}
+
+			//Primed with every position of the dictionary
+			const uint16_t* getHashTable() const {
+				return _hashTable;
+			}
+
+		private:
+			uint32_t _id;
+			size_t _size;
+			uint8_t* _data;
+			uint16_t* _hashTable;
+		};
+
+		//Collects sample messages and picks the segments that occur in most of them.
+		//Each k-mer scores the number of samples containing it; the best scoring segment is taken, its k-mers stop scoring
+		//and the search repeats until the dictionary is full. The best segments end up last, closest to the packets.
+		class DictionaryTrainer {
+		public:
+			static constexpr size_t KmerSize = 6;
+			static constexpr size_t SegmentSize = 32;
+
+			void addSample(const uint8_t* data, size_t size) {
+				for (size_t i = 0; i < size; ++i) {
+					_samples.push_back(data[i]);
+				}
+				_sampleSizes.push_back(size);
+			}
+
+			//Adds the BinarySerializer output of value
+			template<typename T>
+			bool addMessage(const T& value) {
+				auto offset = _samples.size();
+				auto size = getSerializedSize(value);
+				_samples.resize(offset + size);
+				MemoryStreamWriter writer(_samples.data() + offset, size);
+				BinarySerializer serializer(&writer);
+				if (!serializer.serialize(value)) {
+					_samples.resize(offset);
+					return false;
+				}
+				_sampleSizes.push_back(size);
+				return true;
+			}
+
+			size_t getSampleCount() const {
+				return _sampleSizes.size();
+			}
+
+			//Writes at most capacity bytes to dictionary and returns the size taken
+			size_t train(uint8_t* dictionary, size_t capacity) const {
+				if (capacity > Compression::MaxDictionarySize) {
+					capacity = Compression::MaxDictionarySize;
+				}
+				auto counts = new uint32_t[TableSize];
+				auto lastSample = new uint32_t[TableSize];
+				memset(counts, 0, TableSize * sizeof(uint32_t));
+				memset(lastSample, 0, TableSize * sizeof(uint32_t));
+
+				size_t offset = 0;
+				for (size_t s = 0; s < _sampleSizes.size(); ++s) {
+					for (size_t i = 0; i + KmerSize <= _sampleSizes[s]; ++i) {
+						auto h = hash(_samples.data() + offset + i);
+						if (lastSample[h] != s + 1) {
+							lastSample[h] = static_cast<uint32_t>(s + 1);
+							++counts[h];
+						}
+					}
+					offset += _sampleSizes[s];
+				}
+				//A k-mer seen in a single sample does not help other messages
+				for (size_t i = 0; i < TableSize; ++i) {
+					if (counts[i] < 2) {
+						counts[i] = 0;
+					}
+				}
+
+				//Segments are placed from the end of the dictionary towards its start
+				auto position = capacity;
+				while (position > 0) {
+					uint64_t bestScore = 0;
+					size_t bestBegin = 0;
+					size_t bestSize = 0;
+					offset = 0;
+					for (size_t s = 0; s < _sampleSizes.size(); ++s) {
+						auto sample = _samples.data() + offset;
+						auto size = _sampleSizes[s];
+						offset += size;
+						auto segmentSize = SegmentSize < position ? SegmentSize : position;
+						if (size < segmentSize || segmentSize < KmerSize) {
+							continue;
+						}
+						//Sliding sum over the k-mers of a segment
+						auto window = segmentSize - KmerSize + 1;
+						uint64_t score = 0;
+						for (size_t i = 0; i + KmerSize <= size; ++i) {
+							score += counts[hash(sample + i)];
+							if (i >= window) {
+								score -= counts[hash(sample + i - window)];
+							}
+							if (i + 1 >= window && score > bestScore) {
+								bestScore = score;
+								bestBegin = static_cast<size_t>(sample - _samples.data()) + i + 1 - window;
+								bestSize = segmentSize;
+							}
+						}
+					}
+					if (bestScore == 0) {
+						break;
+					}
+					for (size_t i = 0; i + KmerSize <= bestSize; ++i) {
+						counts[hash(_samples.data() + bestBegin + i)] = 0;
+					}
+					position -= bestSize;
+					memcpy(dictionary + position, _samples.data() + bestBegin, bestSize);
+				}
+				delete[] counts;
+				delete[] lastSample;
+
+				auto size = capacity - position;
+				memmove(dictionary, dictionary + position, size);
+				return size;
+			}
+
+		private:
+			static constexpr size_t TableLog = 16;
+			static constexpr size_t TableSize = static_cast<size_t>(1) << TableLog;
+
+			static size_t hash(const uint8_t* data) {
+				uint64_t value = 0;
+				memcpy(&value, data, KmerSize);
+				return static_cast<size_t>((value * 0x9E3779B185EBCA87ull) >> (64 - TableLog));
+			}
+
+			BaseVectorType<uint8_t> _samples;
+			BaseVectorType<size_t> _sampleSizes;
+		};
+
+		enum class DictionaryMode : uint8_t {
+			//Every packet references the dictionary only, so packets may be lost or reordered
+			Static = 0,
+			//Packets also reference the previous MaxDictionarySize bytes of the stream, starting from the dictionary.
+			//Every packet has to reach the reader, in order.
+			Sliding = 1
+		};
+
+		namespace detail {
+			//History followed by room for a packet. A sliding history is moved to the start of the buffer
+			//once less than a packet is left, so it is moved about once per MaxDictionarySize bytes.
+			inline size_t dictionaryBufferSize(DictionaryMode mode, size_t maxPacketSize) {
+				return (mode == DictionaryMode::Static ? 1 : 2) * Compression::MaxDictionarySize + maxPacketSize;
+			}
+		}
+
+		//Compresses each flush() as one packet against the dictionary: Varint32 dictionary id, Varint32 raw size,
+		//Varint32 stored size and the stored bytes, stored as is when compression does not help.
+		//Writes longer than maxPacketSize are split into several packets.
+		class DictionaryCompressingStreamWriter final : public IStreamWriter {
+		public:
+			DictionaryCompressingStreamWriter(IStreamWriter* writer, const CompressionDictionary* dictionary, DictionaryMode mode = DictionaryMode::Static, size_t maxPacketSize = Compression::DefaultPacketSize) :
+				_writer(writer),
+				_dictionary(dictionary),
+				_mode(mode),
+				_maxPacketSize(maxPacketSize),
+				_bufferSize(detail::dictionaryBufferSize(mode, maxPacketSize)),
+				_buffer(new uint8_t[_bufferSize + maxPacketSize]),
+				_hashTable(new uint16_t[Compression::HashTableSize]),
+				_historySize(dictionary->size())
+			{
+				assert(writer != nullptr && dictionary != nullptr);
+				assert(maxPacketSize != 0 && _bufferSize <= Compression::MaxBlockSize);
+				memcpy(_buffer, dictionary->data(), _historySize);
+				memcpy(_hashTable, dictionary->getHashTable(), Compression::HashTableSize * sizeof(uint16_t));
+			}
+
+			DictionaryCompressingStreamWriter(const DictionaryCompressingStreamWriter&) = delete;
+			DictionaryCompressingStreamWriter& operator=(const DictionaryCompressingStreamWriter&) = delete;
+
+			~DictionaryCompressingStreamWriter() {
+				delete[] _buffer;
+				delete[] _hashTable;
+			}
+
+			bool write(const uint8_t* buffer, size_t size) override {
+				while (size > 0) {
+					auto chunkSize = _maxPacketSize - _size;
+					if (chunkSize > size) {
+						chunkSize = size;
+					}
+					memcpy(_buffer + _historySize + _size, buffer, chunkSize);
+					_size += chunkSize;
+					buffer += chunkSize;
+					size -= chunkSize;
+					if (_size == _maxPacketSize && !flush()) {
+						return false;
+					}
+				}
+				return true;
+			}
+
+			bool flush() {
+				if (_size == 0) {
+					return true;
+				}
+				auto rawSize = _size;
+				_size = 0;
+				auto compressed = _buffer + _bufferSize;
+				size_t storedSize;
+				if (_mode == DictionaryMode::Static) {
+					memcpy(_hashTable, _dictionary->getHashTable(), Compression::HashTableSize * sizeof(uint16_t));
+					storedSize = Compression::compressBlock(_buffer, _historySize, rawSize, compressed, rawSize - 1, _hashTable);
+				}
+				else {
+					storedSize = Compression::compressBlock(_buffer, _historySize, rawSize, compressed, rawSize - 1, _hashTable, Compression::MaxDictionarySize);
+				}
+				auto stored = compressed;
+				if (storedSize == 0) {
+					storedSize = rawSize;
+					stored = _buffer + _historySize;
+				}
+				uint8_t header[3 * Varint32::maxSize];
+				auto headerSize = detail::encodeVarint(_dictionary->getId(), header);
+				headerSize += detail::encodeVarint(rawSize, header + headerSize);
+				headerSize += detail::encodeVarint(storedSize, header + headerSize);
+				if (!_writer->write(header, headerSize) || !_writer->write(stored, storedSize)) {
+					return false;
+				}
+				if (_mode == DictionaryMode::Sliding) {
+					_historySize += rawSize;
+					if (_historySize + _maxPacketSize > _bufferSize) {
+						memmove(_buffer, _buffer + _historySize - Compression::MaxDictionarySize, Compression::MaxDictionarySize);
+						_historySize = Compression::MaxDictionarySize;
+						Compression::primeHashTable(_buffer, _historySize, _hashTable);
+					}
+				}
+				return true;
+			}
+
+		private:
+			IStreamWriter* _writer;
+			const CompressionDictionary* _dictionary;
+			DictionaryMode _mode;
+			size_t _maxPacketSize;
+			size_t _bufferSize;
+			uint8_t* _buffer;
+			uint16_t* _hashTable;
+			size_t _historySize;
+			size_t _size = 0;
+		};
+
+		//Reads packets of DictionaryCompressingStreamWriter, taking the dictionary whose id the packet names.
+		//A sliding history stays with the dictionary of the first packet. mode must match the writer and maxPacketSize must not be less.
+		class DictionaryDecompressingStreamReader final : public IStreamReader {
+		public:
+			DictionaryDecompressingStreamReader(IStreamReader* reader, const CompressionDictionary* const* dictionaries, size_t dictionaryCount, DictionaryMode mode = DictionaryMode::Static, size_t maxPacketSize = Compression::DefaultPacketSize) :
+				_reader(reader),
+				_dictionaries(dictionaries),
+				_dictionaryCount(dictionaryCount),
+				_mode(mode),
+				_maxPacketSize(maxPacketSize),
+				_bufferSize(detail::dictionaryBufferSize(mode, maxPacketSize)),
+				_buffer(new uint8_t[_bufferSize + maxPacketSize])
+			{
+				assert(reader != nullptr);
+				assert(maxPacketSize != 0 && _bufferSize <= Compression::MaxBlockSize);
+			}
+
+			DictionaryDecompressingStreamReader(IStreamReader* reader, const CompressionDictionary* dictionary, DictionaryMode mode = DictionaryMode::Static, size_t maxPacketSize = Compression::DefaultPacketSize) :
+				DictionaryDecompressingStreamReader(reader, &_singleDictionary, 1, mode, maxPacketSize)
+			{
+				_singleDictionary = dictionary;
+			}
+
+			DictionaryDecompressingStreamReader(const DictionaryDecompressingStreamReader&) = delete;
+			DictionaryDecompressingStreamReader& operator=(const DictionaryDecompressingStreamReader&) = delete;
+
+			~DictionaryDecompressingStreamReader() {
+				delete[] _buffer;
+			}
+
+			bool read(uint8_t* buffer, size_t size) override {
+				while (size > 0) {
+					if (_begin == _end && !readPacket()) {
+						return false;
+					}
+					auto chunkSize = _end - _begin;
+					if (chunkSize > size) {
+						chunkSize = size;
+					}
+					memcpy(buffer, _buffer + _begin, chunkSize);
+					_begin += chunkSize;
+					buffer += chunkSize;
+					size -= chunkSize;
+				}
+				return true;
+			}
+
+			size_t readSome(uint8_t* buffer, size_t maxSize) override {
+				if (maxSize == 0 || (_begin == _end && !readPacket())) {
+					return 0;
+				}
+				auto size = _end - _begin;
+				if (size > maxSize) {
+					size = maxSize;
+				}
+				memcpy(buffer, _buffer + _begin, size);
+				_begin += size;
+				return size;
+			}
+
+			size_t getBufferedSize() const {
+				return _end - _begin;
+			}
+
+		private:
+			bool readVarint(size_t& value) {
+				value = 0;
+				for (size_t i = 0; i < Varint32::maxSize; ++i) {
+					uint8_t sym;
+					if (!_reader->read(&sym, 1)) {
+						return false;
+					}
+					value |= static_cast<size_t>(sym & 0x7F) << (7 * i);
+					if ((sym & 0x80) == 0) {
+						return true;
+					}
+				}
+				return false;
+			}
+
+			const CompressionDictionary* findDictionary(size_t id) const {
+				for (size_t i = 0; i < _dictionaryCount; ++i) {
+					if (_dictionaries[i] != nullptr && _dictionaries[i]->getId() == id) {
+						return _dictionaries[i];
+					}
+				}
+				return nullptr;
+			}
+
+			bool readPacket() {
+				if (_isBroken) {
+					return false;
+				}
+				size_t id;
+				size_t rawSize;
+				size_t storedSize;
+				_isBroken = true;
+				if (!readVarint(id) || !readVarint(rawSize) || !readVarint(storedSize) || rawSize == 0 || rawSize > _maxPacketSize || storedSize > rawSize) {
+					return false;
+				}
+				if (_dictionary == nullptr || (_dictionary->getId() != id && _mode == DictionaryMode::Static)) {
+					_dictionary = findDictionary(id);
+					if (_dictionary == nullptr) {
+						return false;
+					}
+					memcpy(_buffer, _dictionary->data(), _dictionary->size());
+					_historySize = _dictionary->size();
+				}
+				else if (_dictionary->getId() != id) {
+					return false;
+				}
+
+				if (_mode == DictionaryMode::Sliding && _historySize + rawSize > _bufferSize) {
+					memmove(_buffer, _buffer + _historySize - Compression::MaxDictionarySize, Compression::MaxDictionarySize);
+					_historySize = Compression::MaxDictionarySize;
+				}
+				if (storedSize == rawSize) {
+					if (!_reader->read(_buffer + _historySize, rawSize)) {
+						return false;
+					}
+				}
+				else {
+					auto compressed = _buffer + _bufferSize;
+					if (!_reader->read(compressed, storedSize) || !Compression::decompressBlock(compressed, storedSize, _buffer, _historySize, rawSize)) {
+						return false;
+					}
+				}
+				_isBroken = false;
+				_begin = _historySize;
+				_end = _historySize + rawSize;
+				if (_mode == DictionaryMode::Sliding) {
+					_historySize = _end;
+				}
+				return true;
+			}
+
+			IStreamReader* _reader;
+			const CompressionDictionary* _singleDictionary = nullptr;
+			const CompressionDictionary* const* _dictionaries;
+			size_t _dictionaryCount;
+			DictionaryMode _mode;
+			size_t _maxPacketSize;
+			size_t _bufferSize;
+			uint8_t* _buffer;
+			const CompressionDictionary* _dictionary = nullptr;
+			size_t _historySize = 0;
+			size_t _begin = 0;
+			size_t _end = 0;
+			bool _isBroken = false;
+		};
+	}
+}
+
+#endif // DictionaryCompression_H
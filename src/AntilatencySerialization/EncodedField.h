@@ -0,0 +1,180 @@
+#ifndef EncodedField_H
+#define EncodedField_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "BaseTypes.h"
+#include "Varint.h"
+#include "Fields.h"
+#include "Structures.h"
+#include "BitPackedSerialization.h"
+
+namespace Antilatency {
+	namespace Serialization {
+
+		//Field whose value is written as an unsigned integer of Codec::BitCount bits.
+		//Codec provides Type, BitCount, encode/decode of a single value and encode/decode of an array.
+		//BitPackedSerializer writes exactly BitCount bits, other serializers write the smallest unsigned type holding them (WireType).
+		//The value is kept as set, it changes to the decoded approximation only after a round trip.
+		template <typename Codec, typename Name>
+		class EncodedField : public Field<Name> {
+		public:
+			using Type = typename Codec::Type;
+			using WireType = typename detail::BitsType<Codec::BitCount>::Type;
+
+			static constexpr WireType MaxWireValue = static_cast<WireType>(~static_cast<uint64_t>(0) >> (64 - Codec::BitCount));
+
+			const Type& getValue() const {
+				return _value;
+			}
+
+			Type& getValue() {
+				return _value;
+			}
+
+			void setValue(const Type& value) {
+				_value = value;
+			}
+
+			template<typename Serializer>
+			size_t serialize(Serializer& serializer) const {
+				return serialize(serializer, detail::SupportsBits<Serializer>{});
+			}
+
+			template<typename Deserializer>
+			size_t deserialize(Deserializer& deserializer) {
+				return deserialize(deserializer, detail::SupportsBitsOnRead<Deserializer>{});
+			}
+
+		private:
+			template<typename Serializer>
+			bool serialize(Serializer& serializer, detail::BoolConstant<true>) const {
+				return serializer.serializeBits(Codec::encode(_value), Codec::BitCount);
+			}
+
+			template<typename Serializer>
+			bool serialize(Serializer& serializer, detail::BoolConstant<false>) const {
+				return serializer.serialize(static_cast<WireType>(Codec::encode(_value)));
+			}
+
+			template<typename Deserializer>
+			bool deserialize(Deserializer& deserializer, detail::BoolConstant<true>) {
+				uint64_t wire;
+				if (!deserializer.deserializeBits(wire, Codec::BitCount)) {
+					return false;
+				}
+				_value = Codec::decode(static_cast<WireType>(wire));
+				return true;
+			}
+
+			template<typename Deserializer>
+			bool deserialize(Deserializer& deserializer, detail::BoolConstant<false>) {
+				WireType wire;
+				if (!deserializer.deserialize(wire) || wire > MaxWireValue) {
+					return false;
+				}
+				_value = Codec::decode(wire);
+				return true;
+			}
+
+			Type _value {};
+		};
+
+		//Vector of values encoded with Codec. Other serializers see it as a vector of WireType,
+		//the whole vector is converted with the array form of the codec in one pass.
+		template <typename Codec, typename Name>
+		class EncodedVectorField : public Field<Name> {
+		public:
+			using ItemType = typename Codec::Type;
+			using Type = BaseVectorType<ItemType>;
+			using WireType = typename detail::BitsType<Codec::BitCount>::Type;
+
+			static constexpr WireType MaxWireValue = static_cast<WireType>(~static_cast<uint64_t>(0) >> (64 - Codec::BitCount));
+
+			const Type& getValue() const {
+				return _value;
+			}
+
+			Type& getValue() {
+				return _value;
+			}
+
+			void setValue(const Type& value) {
+				_value = value;
+			}
+
+			template<typename Serializer>
+			size_t serialize(Serializer& serializer) const {
+				BaseVectorType<WireType> wire;
+				wire.resize(_value.size());
+				if (_value.size() != 0) {
+					Codec::encode(_value.data(), wire.data(), _value.size());
+				}
+				return serialize(serializer, wire, detail::SupportsBits<Serializer>{});
+			}
+
+			template<typename Deserializer>
+			size_t deserialize(Deserializer& deserializer) {
+				BaseVectorType<WireType> wire;
+				if (!deserialize(deserializer, wire, detail::SupportsBitsOnRead<Deserializer>{})) {
+					return false;
+				}
+				for (size_t i = 0; i < wire.size(); ++i) {
+					if (wire[i] > MaxWireValue) {
+						return false;
+					}
+				}
+				_value.resize(wire.size());
+				if (wire.size() != 0) {
+					Codec::decode(wire.data(), _value.data(), wire.size());
+				}
+				return true;
+			}
+
+		private:
+			template<typename Serializer>
+			static bool serialize(Serializer& serializer, const BaseVectorType<WireType>& wire, detail::BoolConstant<true>) {
+				if (!serializer.serialize(Varint64(wire.size()))) {
+					return false;
+				}
+				for (size_t i = 0; i < wire.size(); ++i) {
+					if (!serializer.serializeBits(wire[i], Codec::BitCount)) {
+						return false;
+					}
+				}
+				return true;
+			}
+
+			template<typename Serializer>
+			static bool serialize(Serializer& serializer, const BaseVectorType<WireType>& wire, detail::BoolConstant<false>) {
+				return serializer.serialize(wire);
+			}
+
+			template<typename Deserializer>
+			static bool deserialize(Deserializer& deserializer, BaseVectorType<WireType>& wire, detail::BoolConstant<true>) {
+				Varint64 size;
+				if (!deserializer.deserialize(size)) {
+					return false;
+				}
+				wire.clear();
+				for (uint64_t i = 0; i < size.getValue(); ++i) {
+					uint64_t item;
+					if (!deserializer.deserializeBits(item, Codec::BitCount)) {
+						return false;
+					}
+					wire.push_back(static_cast<WireType>(item));
+				}
+				return true;
+			}
+
+			template<typename Deserializer>
+			static bool deserialize(Deserializer& deserializer, BaseVectorType<WireType>& wire, detail::BoolConstant<false>) {
+				return deserializer.deserialize(wire);
+			}
+
+			Type _value;
+		};
+	}
+}
+
+#endif // EncodedField_H
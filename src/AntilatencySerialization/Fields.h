@@ -4,6 +4,7 @@
 #include <stdint.h>
 #include <assert.h>
 #include "BaseTypes.h"
+#include "Span.h"
 
 namespace Antilatency {
 	namespace Serialization {
@@ -87,6 +88,13 @@ namespace Antilatency {
 		template <typename Name>
 		using StringField = ContainerField<BaseStringType, Name>;
 
+		//View fields point into the deserialized buffer, wire format is the same as VectorField/StringField
+		template <typename T, typename Name>
+		using SpanField = ContainerField<Span<T>, Name>;
+
+		template <typename Name>
+		using StringViewField = ContainerField<StringView, Name>;
+
 		
 		template <typename T>
 		class OptioinalField : public T {
@@ -130,6 +138,18 @@ namespace Antilatency {
 				}
 				return deserializedSize;
 			}
+
+			//Value only, existence is written by the enclosing Structure in its presence bitmap
+			template<typename Serializer>
+			bool serializeValue(Serializer& serializer) const {
+				return !_exists || T::serialize(serializer);
+			}
+
+			template<typename Deserializer>
+			bool deserializeValue(Deserializer& deserializer, bool exists) {
+				_exists = exists;
+				return !_exists || T::deserialize(deserializer);
+			}
 		private:
 			bool _exists = false;
 		};
@@ -0,0 +1,127 @@
+#ifndef FixedSizeStructure_H
+#define FixedSizeStructure_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "Fields.h"
+#include "Structures.h"
+#include "StreamSerialization.h"
+
+namespace Antilatency {
+	namespace Serialization {
+		namespace detail {
+
+		#if defined(ARDUINO)
+			static constexpr size_t FixedSizeChunkSize = 64;
+		#else
+			static constexpr size_t FixedSizeChunkSize = 1024;
+		#endif
+
+			//Serialized size of types written as a fixed number of bytes, 0 for everything else.
+			//bool is excluded since not every byte is a valid bool.
+			template<typename T>
+			struct FixedSize {
+				static constexpr size_t value = 0;
+			};
+
+		#define SERIALIZATION_FIXED_SIZE_BASE_TYPE(type) template<> struct FixedSize<type> { static constexpr size_t value = sizeof(type); };
+			SERIALIZATION_FIXED_SIZE_BASE_TYPE(char)
+			SERIALIZATION_FIXED_SIZE_BASE_TYPE(uint8_t)
+			SERIALIZATION_FIXED_SIZE_BASE_TYPE(int8_t)
+			SERIALIZATION_FIXED_SIZE_BASE_TYPE(uint16_t)
+			SERIALIZATION_FIXED_SIZE_BASE_TYPE(int16_t)
+			SERIALIZATION_FIXED_SIZE_BASE_TYPE(uint32_t)
+			SERIALIZATION_FIXED_SIZE_BASE_TYPE(int32_t)
+			SERIALIZATION_FIXED_SIZE_BASE_TYPE(uint64_t)
+			SERIALIZATION_FIXED_SIZE_BASE_TYPE(int64_t)
+			SERIALIZATION_FIXED_SIZE_BASE_TYPE(float)
+			SERIALIZATION_FIXED_SIZE_BASE_TYPE(double)
+		#undef SERIALIZATION_FIXED_SIZE_BASE_TYPE
+
+			template<typename T, typename Name>
+			struct FixedSize<SingleField<T, Name>> {
+				static constexpr size_t value = FixedSize<T>::value;
+			};
+
+			//Only when every wire value decodes, narrower codecs need the range check of the field
+			template<typename Codec, typename Name>
+			struct FixedSize<EncodedField<Codec, Name>> {
+				using WireType = typename EncodedField<Codec, Name>::WireType;
+				static constexpr size_t value = Codec::BitCount == 8 * sizeof(WireType) ? sizeof(WireType) : 0;
+			};
+
+			template<typename ... Types>
+			constexpr size_t sumFixedSize() {
+				const size_t sizes[] = { FixedSize<Types>::value... };
+				size_t result = 0;
+				for (size_t i = 0; i < sizeof...(Types); ++i) {
+					if (sizes[i] == 0) {
+						return 0;
+					}
+					result += sizes[i];
+				}
+				return result;
+			}
+
+			template<typename ... Fields>
+			struct FixedSize<Structure<Fields...>> {
+				static constexpr size_t value = sumFixedSize<Fields...>();
+			};
+
+			//Number of fixed-size items packed into one stack buffer
+			template<typename T>
+			struct FixedSizeChunk {
+				static constexpr size_t count = FixedSize<T>::value < FixedSizeChunkSize ? FixedSizeChunkSize / FixedSize<T>::value : 1;
+				static constexpr size_t size = count * FixedSize<T>::value;
+			};
+
+			//Streams over memory already checked by the caller, used to pack fixed-size structures with straight-line stores
+			class UncheckedMemoryStreamWriter final : public IStreamWriter {
+			public:
+				explicit UncheckedMemoryStreamWriter(uint8_t* buffer) :
+					_buffer(buffer)
+				{
+				}
+
+				bool write(const uint8_t* buffer, size_t size) override {
+					memcpy(_buffer, buffer, size);
+					_buffer += size;
+					return true;
+				}
+
+			private:
+				uint8_t* _buffer;
+			};
+
+			class UncheckedMemoryStreamReader final : public IStreamReader {
+			public:
+				explicit UncheckedMemoryStreamReader(const uint8_t* buffer) :
+					_buffer(buffer)
+				{
+				}
+
+				bool read(uint8_t* buffer, size_t size) override {
+					memcpy(buffer, _buffer, size);
+					_buffer += size;
+					return true;
+				}
+
+			private:
+				const uint8_t* _buffer;
+			};
+
+			//Fixed-size structures take the packed path unless they are already being packed
+			template<typename Stream, typename T>
+			struct UseFixedSizePath : BoolConstant<FixedSize<T>::value != 0> {};
+
+			template<typename T>
+			struct UseFixedSizePath<UncheckedMemoryStreamWriter, T> : BoolConstant<false> {};
+
+			template<typename T>
+			struct UseFixedSizePath<UncheckedMemoryStreamReader, T> : BoolConstant<false> {};
+		}
+	}
+}
+
+#endif // FixedSizeStructure_H
@@ -0,0 +1,275 @@
+#ifndef FloatFields_H
+#define FloatFields_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <math.h>
+#include "BaseTypes.h"
+#include "EncodedField.h"
+
+#if defined(ANTILATENCY_SERIALIZATION_F16C)
+	#include <immintrin.h>
+#endif
+
+namespace Antilatency {
+	namespace Serialization {
+
+//Range of a QuantizedFloatField, floats can not be template arguments
+#define SERIALIZATION_MAKE_FLOAT_RANGE(name, min, max) class name {public: static constexpr float Min = min; static constexpr float Max = max;}
+
+		namespace detail {
+			//IEEE 754 binary16, round to nearest even
+			inline uint16_t floatToHalf(float value) {
+				uint32_t bits;
+				memcpy(&bits, &value, sizeof(bits));
+				auto sign = static_cast<uint16_t>((bits >> 16) & 0x8000);
+				auto abs = bits & 0x7FFFFFFF;
+				if (abs >= 0x7F800000) {
+					//Infinity or NaN, NaN keeps the upper payload bits and stays quiet
+					return static_cast<uint16_t>(sign | 0x7C00 | (abs > 0x7F800000 ? 0x200 | ((abs >> 13) & 0x3FF) : 0));
+				}
+				if (abs >= 0x477FF000) {
+					//65520 and above round to infinity
+					return static_cast<uint16_t>(sign | 0x7C00);
+				}
+				if (abs < 0x38800000) {
+					//Half subnormal, units of 2^-24
+					if (abs < 0x33000000) {
+						return sign;
+					}
+					auto shift = 126 - (abs >> 23);
+					auto mantissa = (abs & 0x7FFFFF) | 0x800000;
+					auto half = mantissa >> shift;
+					auto remainder = mantissa & ((1u << shift) - 1);
+					auto halfway = 1u << (shift - 1);
+					if (remainder > halfway || (remainder == halfway && (half & 1) != 0)) {
+						++half;
+					}
+					return static_cast<uint16_t>(sign | half);
+				}
+				auto half = (abs - 0x38000000) >> 13;
+				auto remainder = abs & 0x1FFF;
+				if (remainder > 0x1000 || (remainder == 0x1000 && (half & 1) != 0)) {
+					++half;
+				}
+				return static_cast<uint16_t>(sign | half);
+			}
+
+			inline float halfToFloat(uint16_t value) {
+				uint32_t sign = static_cast<uint32_t>(value & 0x8000) << 16;
+				uint32_t exponent = (value >> 10) & 0x1F;
+				uint32_t mantissa = value & 0x3FF;
+				uint32_t bits;
+				if (exponent == 0x1F) {
+					bits = sign | 0x7F800000 | (mantissa << 13);
+				}
+				else if (exponent != 0) {
+					bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+				}
+				else if (mantissa == 0) {
+					bits = sign;
+				}
+				else {
+					exponent = 113;
+					while ((mantissa & 0x400) == 0) {
+						mantissa <<= 1;
+						--exponent;
+					}
+					bits = sign | (exponent << 23) | ((mantissa & 0x3FF) << 13);
+				}
+				float result;
+				memcpy(&result, &bits, sizeof(result));
+				return result;
+			}
+
+			//F16C converts 8 values per instruction, the tail goes through the scalar conversion
+			inline void floatToHalf(const float* values, uint16_t* result, size_t count) {
+				size_t i = 0;
+			#if defined(ANTILATENCY_SERIALIZATION_F16C)
+				for (; i + 8 <= count; i += 8) {
+					auto half = _mm256_cvtps_ph(_mm256_loadu_ps(values + i), _MM_FROUND_TO_NEAREST_INT);
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(result + i), half);
+				}
+			#endif
+				for (; i < count; ++i) {
+					result[i] = floatToHalf(values[i]);
+				}
+			}
+
+			inline void halfToFloat(const uint16_t* values, float* result, size_t count) {
+				size_t i = 0;
+			#if defined(ANTILATENCY_SERIALIZATION_F16C)
+				for (; i + 8 <= count; i += 8) {
+					auto half = _mm_loadu_si128(reinterpret_cast<const __m128i*>(values + i));
+					_mm256_storeu_ps(result + i, _mm256_cvtph_ps(half));
+				}
+			#endif
+				for (; i < count; ++i) {
+					result[i] = halfToFloat(values[i]);
+				}
+			}
+		}
+
+		struct Float16Codec {
+			using Type = float;
+			static constexpr unsigned BitCount = 16;
+
+			static uint16_t encode(float value) {
+				return detail::floatToHalf(value);
+			}
+
+			static float decode(uint16_t value) {
+				return detail::halfToFloat(value);
+			}
+
+			static void encode(const float* values, uint16_t* result, size_t count) {
+				detail::floatToHalf(values, result, count);
+			}
+
+			static void decode(const uint16_t* values, float* result, size_t count) {
+				detail::halfToFloat(values, result, count);
+			}
+		};
+
+		//Range::Min..Range::Max mapped to Bits bit integer, values outside are clamped. Error is at most (Max - Min) / (2^Bits - 1) / 2.
+		template<typename Range, unsigned Bits>
+		struct QuantizedFloatCodec {
+			static_assert(Bits != 0 && Bits <= 24, "Quantized float width must be 1..24, float has 24 significant bits");
+			static_assert(Range::Min < Range::Max, "Empty range");
+
+			using Type = float;
+			using WireType = typename detail::BitsType<Bits>::Type;
+			static constexpr unsigned BitCount = Bits;
+
+			static WireType encode(float value) {
+				constexpr uint32_t maxWire = (1u << Bits) - 1;
+				constexpr float steps = static_cast<float>(maxWire);
+				constexpr float scale = steps / (Range::Max - Range::Min);
+				float normalized = (value - Range::Min) * scale;
+				//NaN goes to Min
+				normalized = normalized >= 0.0f ? normalized : 0.0f;
+				normalized = normalized <= steps ? normalized : steps;
+				//With 24 bits steps + 0.5f rounds up to 2^24
+				auto rounded = static_cast<uint32_t>(normalized + 0.5f);
+				return static_cast<WireType>(rounded <= maxWire ? rounded : maxWire);
+			}
+
+			static float decode(WireType value) {
+				constexpr float step = (Range::Max - Range::Min) / static_cast<float>((1u << Bits) - 1);
+				return Range::Min + static_cast<float>(value) * step;
+			}
+
+			//Branch-free loops, vectorized by the compiler
+			static void encode(const float* values, WireType* result, size_t count) {
+				for (size_t i = 0; i < count; ++i) {
+					result[i] = encode(values[i]);
+				}
+			}
+
+			static void decode(const WireType* values, float* result, size_t count) {
+				for (size_t i = 0; i < count; ++i) {
+					result[i] = decode(values[i]);
+				}
+			}
+		};
+
+		struct Quaternion {
+			float x = 0.0f;
+			float y = 0.0f;
+			float z = 0.0f;
+			float w = 1.0f;
+		};
+
+		//Unit quaternion as the index of its largest component (2 bits) and the other three in ComponentBits bits each.
+		//The largest component is restored from the unit length, q and -q are the same rotation so its sign is not stored.
+		template<unsigned ComponentBits>
+		struct SmallestThreeCodec {
+			static_assert(ComponentBits >= 2 && ComponentBits <= 20, "Component width must be 2..20");
+
+			using Type = Quaternion;
+			static constexpr unsigned BitCount = 2 + 3 * ComponentBits;
+			using WireType = typename detail::BitsType<BitCount>::Type;
+
+			static WireType encode(const Quaternion& value) {
+				const float components[] = { value.x, value.y, value.z, value.w };
+				unsigned largest = 0;
+				for (unsigned i = 1; i < 4; ++i) {
+					if (fabsf(components[i]) > fabsf(components[largest])) {
+						largest = i;
+					}
+				}
+				float sign = components[largest] < 0.0f ? -1.0f : 1.0f;
+				uint64_t result = largest;
+				unsigned shift = 2;
+				for (unsigned i = 0; i < 4; ++i) {
+					if (i != largest) {
+						result |= static_cast<uint64_t>(ComponentCodec::encode(components[i] * sign)) << shift;
+						shift += ComponentBits;
+					}
+				}
+				return static_cast<WireType>(result);
+			}
+
+			static Quaternion decode(WireType value) {
+				float components[4];
+				auto largest = static_cast<unsigned>(value & 3);
+				unsigned shift = 2;
+				float sum = 0.0f;
+				for (unsigned i = 0; i < 4; ++i) {
+					if (i != largest) {
+						auto component = static_cast<typename ComponentCodec::WireType>((static_cast<uint64_t>(value) >> shift) & ComponentMask);
+						components[i] = ComponentCodec::decode(component);
+						sum += components[i] * components[i];
+						shift += ComponentBits;
+					}
+				}
+				components[largest] = sum < 1.0f ? sqrtf(1.0f - sum) : 0.0f;
+				Quaternion result;
+				result.x = components[0];
+				result.y = components[1];
+				result.z = components[2];
+				result.w = components[3];
+				return result;
+			}
+
+			static void encode(const Quaternion* values, WireType* result, size_t count) {
+				for (size_t i = 0; i < count; ++i) {
+					result[i] = encode(values[i]);
+				}
+			}
+
+			static void decode(const WireType* values, Quaternion* result, size_t count) {
+				for (size_t i = 0; i < count; ++i) {
+					result[i] = decode(values[i]);
+				}
+			}
+
+		private:
+			//Components other than the largest are within +-1/sqrt(2)
+			SERIALIZATION_MAKE_FLOAT_RANGE(ComponentRange, -0.70710678f, 0.70710678f);
+			using ComponentCodec = QuantizedFloatCodec<ComponentRange, ComponentBits>;
+			static constexpr uint64_t ComponentMask = (static_cast<uint64_t>(1) << ComponentBits) - 1;
+		};
+
+		template <typename Name>
+		using Float16Field = EncodedField<Float16Codec, Name>;
+
+		template <typename Range, unsigned Bits, typename Name>
+		using QuantizedFloatField = EncodedField<QuantizedFloatCodec<Range, Bits>, Name>;
+
+		template <typename Name, unsigned ComponentBits = 10>
+		using QuaternionField = EncodedField<SmallestThreeCodec<ComponentBits>, Name>;
+
+		template <typename Name>
+		using Float16VectorField = EncodedVectorField<Float16Codec, Name>;
+
+		template <typename Range, unsigned Bits, typename Name>
+		using QuantizedFloatVectorField = EncodedVectorField<QuantizedFloatCodec<Range, Bits>, Name>;
+
+		template <typename Name, unsigned ComponentBits = 10>
+		using QuaternionVectorField = EncodedVectorField<SmallestThreeCodec<ComponentBits>, Name>;
+	}
+}
+
+#endif // FloatFields_H
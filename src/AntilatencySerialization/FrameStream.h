@@ -0,0 +1,318 @@
+#ifndef FrameStream_H
+#define FrameStream_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <assert.h>
+
+#include "BaseTypes.h"
+#include "Varint.h"
+#include "StreamSerialization.h"
+#include "ChecksumStream.h"
+
+namespace Antilatency {
+	namespace Serialization {
+
+		//Frame: 2 byte sync marker, Varint32 payload size, payload and, when checksums are on,
+		//the CRC32C of size and payload as 4 bytes little-endian.
+		namespace Framing {
+			static constexpr uint8_t SyncMarker[] = { 0xA5, 0xC3 };
+			static constexpr size_t SyncMarkerSize = sizeof(SyncMarker);
+			static constexpr size_t MaxHeaderSize = SyncMarkerSize + Varint32::maxSize;
+			static constexpr size_t MaxOverhead = MaxHeaderSize + Crc32c::TrailerSize;
+		#if defined(ARDUINO)
+			static constexpr size_t DefaultBufferSize = 128;
+		#else
+			static constexpr size_t DefaultBufferSize = 4096;
+		#endif
+			static constexpr size_t DefaultMaxFrameSize = DefaultBufferSize - MaxOverhead;
+		}
+
+		//Everything written between endFrame() calls becomes one frame. Finished frames are collected
+		//and written to writer together when the buffer can not take more, or on flush(). Call flush() once
+		//there is nothing more to send right away, it bounds the time a frame waits in the buffer.
+		//A frame can hold at most bufferSize - Framing::MaxOverhead bytes.
+		class FrameWriter final : public IStreamWriter {
+		public:
+			explicit FrameWriter(IStreamWriter* writer, size_t bufferSize = Framing::DefaultBufferSize, bool useChecksum = true) :
+				_writer(writer),
+				_capacity(bufferSize),
+				_buffer(new uint8_t[bufferSize]),
+				_useChecksum(useChecksum)
+			{
+				assert(writer != nullptr);
+				assert(bufferSize > Framing::MaxOverhead);
+			}
+
+			FrameWriter(const FrameWriter&) = delete;
+			FrameWriter& operator=(const FrameWriter&) = delete;
+
+			~FrameWriter() {
+				delete[] _buffer;
+			}
+
+			bool write(const uint8_t* buffer, size_t size) override {
+				if (_isOverflow) {
+					return false;
+				}
+				auto trailerSize = _useChecksum ? Crc32c::TrailerSize : 0;
+				if (size > _capacity - trailerSize - _end) {
+					//Finished frames make room for the current one
+					if (!flush() || size > _capacity - trailerSize - _end) {
+						_isOverflow = true;
+						return false;
+					}
+				}
+				memcpy(_buffer + _end, buffer, size);
+				_end += size;
+				return true;
+			}
+
+			//Finishes the current frame, fails when it did not fit into the buffer
+			bool endFrame() {
+				if (_isOverflow) {
+					cancelFrame();
+					return false;
+				}
+				auto payload = _frameBegin + Framing::MaxHeaderSize;
+				auto payloadSize = _end - payload;
+				uint8_t header[Framing::MaxHeaderSize];
+				memcpy(header, Framing::SyncMarker, Framing::SyncMarkerSize);
+				auto headerSize = Framing::SyncMarkerSize + detail::encodeVarint(payloadSize, header + Framing::SyncMarkerSize);
+				//The header is shorter than reserved unless the payload is huge, the payload moves back by the difference
+				if (headerSize != Framing::MaxHeaderSize) {
+					memmove(_buffer + _frameBegin + headerSize, _buffer + payload, payloadSize);
+				}
+				memcpy(_buffer + _frameBegin, header, headerSize);
+				_end = _frameBegin + headerSize + payloadSize;
+				if (_useChecksum) {
+					auto checksum = Crc32c::compute(_buffer + _frameBegin + Framing::SyncMarkerSize, _end - _frameBegin - Framing::SyncMarkerSize);
+					_buffer[_end++] = static_cast<uint8_t>(checksum);
+					_buffer[_end++] = static_cast<uint8_t>(checksum >> 8);
+					_buffer[_end++] = static_cast<uint8_t>(checksum >> 16);
+					_buffer[_end++] = static_cast<uint8_t>(checksum >> 24);
+				}
+				return startFrame(_end);
+			}
+
+			//Drops what was written since the last endFrame()
+			void cancelFrame() {
+				_isOverflow = false;
+				startFrame(_frameBegin);
+			}
+
+			//Writes the finished frames, the current one stays in the buffer
+			bool flush() {
+				if (_frameBegin == 0) {
+					return true;
+				}
+				auto isOk = _writer->write(_buffer, _frameBegin);
+				auto pending = _end - _frameBegin;
+				memmove(_buffer, _buffer + _frameBegin, pending);
+				_frameBegin = 0;
+				_end = pending;
+				return isOk;
+			}
+
+			size_t getBufferedSize() const {
+				return _frameBegin;
+			}
+
+		private:
+			bool startFrame(size_t position) {
+				_frameBegin = position;
+				_end = position;
+				auto isOk = true;
+				if (position + Framing::MaxHeaderSize > _capacity - (_useChecksum ? Crc32c::TrailerSize : 0)) {
+					isOk = flush();
+				}
+				_end = _frameBegin + Framing::MaxHeaderSize;
+				return isOk;
+			}
+
+			IStreamWriter* _writer;
+			size_t _capacity;
+			uint8_t* _buffer;
+			bool _useChecksum;
+			size_t _frameBegin = 0;
+			size_t _end = Framing::MaxHeaderSize;
+			bool _isOverflow = false;
+		};
+
+		//Finds frames of FrameWriter in reader. nextFrame() moves to the next frame with a valid size and checksum,
+		//bytes that do not start one (lost, damaged or from the middle of a frame) are dropped until a sync marker is found.
+		//The payload of the current frame is then read through this reader, reads past its end fail.
+		//When reader has no more data nextFrame() returns false and keeps what was received, so it can be called again later.
+		class FrameReader final : public IStreamReader {
+		public:
+			explicit FrameReader(IStreamReader* reader, size_t maxFrameSize = Framing::DefaultMaxFrameSize, bool useChecksum = true) :
+				_reader(reader),
+				_maxFrameSize(maxFrameSize),
+				_capacity(maxFrameSize + Framing::MaxOverhead),
+				_buffer(new uint8_t[_capacity]),
+				_useChecksum(useChecksum)
+			{
+				assert(reader != nullptr);
+			}
+
+			FrameReader(const FrameReader&) = delete;
+			FrameReader& operator=(const FrameReader&) = delete;
+
+			~FrameReader() {
+				delete[] _buffer;
+			}
+
+			bool nextFrame() {
+				if (_hasFrame) {
+					_begin = _frameEnd;
+					_hasFrame = false;
+				}
+				_position = 0;
+				_payloadEnd = 0;
+				auto trailerSize = _useChecksum ? Crc32c::TrailerSize : 0;
+				while (true) {
+					if (!findSyncMarker()) {
+						return false;
+					}
+					size_t headerSize = Framing::SyncMarkerSize;
+					uint32_t payloadSize = 0;
+					while (true) {
+						auto varintSize = detail::decodeVarint(_buffer + _begin + headerSize, _end - _begin - headerSize, payloadSize);
+						if (varintSize != 0) {
+							headerSize += varintSize;
+							break;
+						}
+						//Incomplete varint unless all of its bytes are there
+						if (_end - _begin >= Framing::MaxHeaderSize) {
+							break;
+						}
+						if (!fill()) {
+							return false;
+						}
+					}
+					if (headerSize == Framing::SyncMarkerSize || payloadSize > _maxFrameSize) {
+						drop(1);
+						continue;
+					}
+					auto frameSize = headerSize + payloadSize + trailerSize;
+					while (_end - _begin < frameSize) {
+						if (!fill()) {
+							return false;
+						}
+					}
+					if (_useChecksum) {
+						auto checksum = Crc32c::compute(_buffer + _begin + Framing::SyncMarkerSize, headerSize - Framing::SyncMarkerSize + payloadSize);
+						auto trailer = _buffer + _begin + headerSize + payloadSize;
+						auto expected = static_cast<uint32_t>(trailer[0]) | (static_cast<uint32_t>(trailer[1]) << 8) |
+							(static_cast<uint32_t>(trailer[2]) << 16) | (static_cast<uint32_t>(trailer[3]) << 24);
+						if (checksum != expected) {
+							drop(1);
+							continue;
+						}
+					}
+					_position = _begin + headerSize;
+					_payloadEnd = _position + payloadSize;
+					_frameEnd = _begin + frameSize;
+					_hasFrame = true;
+					return true;
+				}
+			}
+
+			bool read(uint8_t* buffer, size_t size) override {
+				if (size > _payloadEnd - _position) {
+					return false;
+				}
+				memcpy(buffer, _buffer + _position, size);
+				_position += size;
+				return true;
+			}
+
+			size_t readSome(uint8_t* buffer, size_t maxSize) override {
+				auto size = _payloadEnd - _position;
+				if (size > maxSize) {
+					size = maxSize;
+				}
+				memcpy(buffer, _buffer + _position, size);
+				_position += size;
+				return size;
+			}
+
+			bool skip(size_t size) override {
+				if (size > _payloadEnd - _position) {
+					return false;
+				}
+				_position += size;
+				return true;
+			}
+
+			//Unread bytes of the current frame
+			size_t getRemainingSize() const {
+				return _payloadEnd - _position;
+			}
+
+			//Bytes dropped while looking for frames
+			uint64_t getDroppedSize() const {
+				return _droppedSize;
+			}
+
+		private:
+			void drop(size_t size) {
+				_begin += size;
+				_droppedSize += size;
+			}
+
+			//Moves the unread bytes to the start of the buffer and reads more after them
+			bool fill() {
+				if (_begin != 0) {
+					memmove(_buffer, _buffer + _begin, _end - _begin);
+					_end -= _begin;
+					_begin = 0;
+				}
+				auto size = _reader->readSome(_buffer + _end, _capacity - _end);
+				_end += size;
+				return size != 0;
+			}
+
+			//Drops bytes up to the marker and keeps at least the marker in the buffer
+			bool findSyncMarker() {
+				while (true) {
+					auto data = _buffer + _begin;
+					auto size = _end - _begin;
+					auto found = static_cast<const uint8_t*>(size != 0 ? memchr(data, Framing::SyncMarker[0], size) : nullptr);
+					if (found == nullptr) {
+						drop(size);
+					}
+					else {
+						drop(static_cast<size_t>(found - data));
+						if (_end - _begin >= Framing::SyncMarkerSize) {
+							if (_buffer[_begin + 1] == Framing::SyncMarker[1]) {
+								return true;
+							}
+							drop(1);
+							continue;
+						}
+					}
+					if (!fill()) {
+						return false;
+					}
+				}
+			}
+
+			IStreamReader* _reader;
+			size_t _maxFrameSize;
+			size_t _capacity;
+			uint8_t* _buffer;
+			bool _useChecksum;
+			size_t _begin = 0;
+			size_t _end = 0;
+			size_t _position = 0;
+			size_t _payloadEnd = 0;
+			size_t _frameEnd = 0;
+			bool _hasFrame = false;
+			uint64_t _droppedSize = 0;
+		};
+	}
+}
+
+#endif // FrameStream_H
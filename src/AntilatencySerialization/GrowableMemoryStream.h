@@ -0,0 +1,90 @@
+#ifndef GrowableMemoryStream_H
+#define GrowableMemoryStream_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <assert.h>
+
+#include "BaseTypes.h"
+#include "StreamSerialization.h"
+
+#if defined(ANTILATENCY_SERIALIZATION_STL_SUPPORT)
+
+#include <memory>
+#include <vector>
+
+namespace Antilatency {
+	namespace Serialization {
+
+		//Appends everything to a std::vector, so a message can be serialized in one pass without counting its size first.
+		//The buffer is either owned or borrowed from the caller, reset() keeps the capacity for the next message.
+		template<typename Allocator = std::allocator<uint8_t>>
+		class BasicGrowableMemoryStreamWriter final : public IStreamWriter {
+		public:
+			using BufferType = std::vector<uint8_t, Allocator>;
+
+			explicit BasicGrowableMemoryStreamWriter(size_t initialCapacity = 0, const Allocator& allocator = Allocator()) :
+				_ownBuffer(allocator),
+				_buffer(&_ownBuffer)
+			{
+				_ownBuffer.reserve(initialCapacity);
+			}
+
+			explicit BasicGrowableMemoryStreamWriter(BufferType* buffer) :
+				_buffer(buffer)
+			{
+				assert(buffer != nullptr);
+			}
+
+			BasicGrowableMemoryStreamWriter(const BasicGrowableMemoryStreamWriter&) = delete;
+			BasicGrowableMemoryStreamWriter& operator=(const BasicGrowableMemoryStreamWriter&) = delete;
+
+			bool write(const uint8_t* buffer, size_t size) override {
+				_buffer->insert(_buffer->end(), buffer, buffer + size);
+				return true;
+			}
+
+			uint8_t* allocate(size_t size) override {
+				auto offset = _buffer->size();
+				_buffer->resize(offset + size);
+				return _buffer->data() + offset;
+			}
+
+			const uint8_t* data() const {
+				return _buffer->data();
+			}
+
+			size_t size() const {
+				return _buffer->size();
+			}
+
+			size_t capacity() const {
+				return _buffer->capacity();
+			}
+
+			void reserve(size_t capacity) {
+				_buffer->reserve(capacity);
+			}
+
+			void reset() {
+				_buffer->clear();
+			}
+
+			BufferType release() {
+				BufferType result(_buffer->get_allocator());
+				result.swap(*_buffer);
+				return result;
+			}
+
+		private:
+			BufferType _ownBuffer;
+			BufferType* _buffer;
+		};
+
+		using GrowableMemoryStreamWriter = BasicGrowableMemoryStreamWriter<>;
+	}
+}
+
+#endif
+
+#endif // GrowableMemoryStream_H
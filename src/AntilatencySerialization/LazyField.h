@@ -0,0 +1,78 @@
+#ifndef LazyField_H
+#define LazyField_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "BaseTypes.h"
+#include "Fields.h"
+#include "BinarySerialization.h"
+
+namespace Antilatency {
+	namespace Serialization {
+
+		//Wraps a field (SingleField, ContainerField...) and only records its bytes on deserialization.
+		//The value is decoded on first access. When the source stream is backed by memory the recorded bytes point into it,
+		//so the buffer must outlive the field until it is decoded; other streams are copied.
+		template<typename T>
+		class LazyField : public Field<typename T::Name> {
+		public:
+			using Type = typename T::Type;
+
+			const Type& getValue() const {
+				decode();
+				return _field.getValue();
+			}
+
+			Type& getValue() {
+				decode();
+				return _field.getValue();
+			}
+
+			void setValue(const Type& value) {
+				_field.setValue(value);
+				_rawData = nullptr;
+				_rawSize = 0;
+				_isDecoded = true;
+				_isValid = true;
+			}
+
+			bool isDecoded() const {
+				return _isDecoded;
+			}
+
+			//Decodes the recorded bytes if not done yet, returns false if they are broken
+			bool decode() const {
+				if (!_isDecoded) {
+					auto data = _rawData != nullptr ? _rawData : _storage.data();
+					MemoryStreamReader reader(data, _rawSize);
+					BasicBinaryDeserializer<MemoryStreamReader> deserializer(&reader);
+					_isValid = _field.deserialize(deserializer) != 0;
+					_isDecoded = true;
+				}
+				return _isValid;
+			}
+
+			template<typename Serializer>
+			size_t serialize(Serializer& serializer) const {
+				return decode() && _field.serialize(serializer);
+			}
+
+			template<typename Deserializer>
+			size_t deserialize(Deserializer& deserializer) {
+				_isDecoded = false;
+				_isValid = false;
+				return deserializer.template capture<T>(_rawData, _rawSize, _storage);
+			}
+
+		private:
+			mutable T _field;
+			mutable bool _isDecoded = true;
+			mutable bool _isValid = true;
+			const uint8_t* _rawData = nullptr;
+			size_t _rawSize = 0;
+			BaseVectorType<uint8_t> _storage;
+		};
+	}
+}
+
+#endif // LazyField_H
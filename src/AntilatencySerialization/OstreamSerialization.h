@@ -8,6 +8,8 @@
 #include <ostream>
 
 #include "Varint.h"
+#include "Span.h"
+#include "PackedIntegerVector.h"
 
 namespace Antilatency {
 	namespace Serialization {
@@ -57,6 +59,31 @@ namespace Antilatency {
 				serialize(']');
 				return true;
 			}
+
+			template <typename T>
+			bool serialize(const PackedIntegerVector<T>& value) {
+				return serialize(static_cast<const BaseVectorType<T>&>(value));
+			}
+
+			template <typename T>
+			bool serialize(const Span<T>& value) {
+				serialize('[');
+				for (size_t i = 0; i < value.size(); ++i) {
+					serialize(value[i]);
+					if (i != value.size() - 1) {
+						serialize(',');
+					}
+				}
+				serialize(']');
+				return true;
+			}
+
+			bool serialize(const StringView& value) {
+				serialize('\"');
+				_stream.write(value.data(), value.size());
+				serialize('\"');
+				return true;
+			}
 		private:
 			std::ostream& _stream;
 		};
@@ -0,0 +1,179 @@
+#ifndef PackedIntegerVector_H
+#define PackedIntegerVector_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "BaseTypes.h"
+#include "Fields.h"
+#include "Varint.h"
+#include "StreamVByte.h"
+
+namespace Antilatency {
+	namespace Serialization {
+
+		//Vector of 32-bit integers serialized with StreamVByte instead of one Varint per element.
+		//int32_t values are zigzag encoded, so small negative numbers stay short.
+		template<typename T>
+		class PackedIntegerVector : public BaseVectorType<T> {
+			static_assert(sizeof(T) == sizeof(uint32_t), "PackedIntegerVector supports uint32_t and int32_t only");
+		public:
+			using BaseVectorType<T>::BaseVectorType;
+			using BaseVectorType<T>::operator=;
+		};
+
+		template <typename T, typename Name>
+		using PackedIntegerVectorField = ContainerField<PackedIntegerVector<T>, Name>;
+
+		namespace StreamVByte {
+			static constexpr size_t ChunkSize = 256;
+
+			namespace detail {
+				inline const uint32_t* toUnsigned(const uint32_t* values, size_t count, uint32_t* temp) {
+					static_cast<void>(count);
+					static_cast<void>(temp);
+					return values;
+				}
+
+				inline const uint32_t* toUnsigned(const int32_t* values, size_t count, uint32_t* temp) {
+					for (size_t i = 0; i < count; ++i) {
+						temp[i] = Serialization::detail::zigzagEncode(values[i]);
+					}
+					return temp;
+				}
+
+				//Data bytes StreamVByte uses for values
+				inline size_t getEncodedSize(const uint32_t* values, size_t count) {
+					size_t size = count;
+					for (size_t i = 0; i < count; ++i) {
+						auto value = values[i];
+						size += static_cast<uint32_t>(value > 0xFF) + static_cast<uint32_t>(value > 0xFFFF) + static_cast<uint32_t>(value > 0xFFFFFF);
+					}
+					return size;
+				}
+
+				inline void fromUnsigned(uint32_t* values, size_t count) {
+					static_cast<void>(values);
+					static_cast<void>(count);
+				}
+
+				inline void fromUnsigned(int32_t* values, size_t count) {
+					auto unsignedValues = reinterpret_cast<const uint32_t*>(values);
+					for (size_t i = 0; i < count; ++i) {
+						values[i] = Serialization::detail::zigzagDecode<int32_t>(unsignedValues[i]);
+					}
+				}
+			}
+
+			namespace detail {
+				//For writers without allocate: control bytes of all chunks first, then the chunks are encoded again for their data
+				template<typename StreamWriter, typename T>
+				bool writeChunks(StreamWriter* writer, const T* values, size_t count) {
+					uint32_t temp[ChunkSize];
+					uint8_t control[getControlSize(ChunkSize)];
+					uint8_t data[getMaxDataSize(ChunkSize) + EncodeSlack];
+					for (size_t offset = 0; offset < count; offset += ChunkSize) {
+						auto chunkSize = count - offset < ChunkSize ? count - offset : ChunkSize;
+						encode(toUnsigned(values + offset, chunkSize, temp), chunkSize, control, data);
+						if (!writer->write(control, getControlSize(chunkSize))) {
+							return false;
+						}
+					}
+					for (size_t offset = 0; offset < count; offset += ChunkSize) {
+						auto chunkSize = count - offset < ChunkSize ? count - offset : ChunkSize;
+						auto dataSize = encode(toUnsigned(values + offset, chunkSize, temp), chunkSize, control, data);
+						if (!writer->write(data, dataSize)) {
+							return false;
+						}
+					}
+					return true;
+				}
+			}
+
+			//Writes control bytes of all values then their data.
+			//Writers with allocate get the exact size and are encoded into in place, every value is encoded once.
+			//Other writers get the encoding in stack-sized chunks.
+			template<typename StreamWriter, typename T>
+			bool write(StreamWriter* writer, const T* values, size_t count) {
+				uint32_t temp[ChunkSize];
+				uint8_t data[getMaxDataSize(ChunkSize) + EncodeSlack];
+				if (count <= ChunkSize) {
+					uint8_t control[getControlSize(ChunkSize)];
+					auto dataSize = encode(detail::toUnsigned(values, count, temp), count, control, data);
+					return writer->write(control, getControlSize(count)) && writer->write(data, dataSize);
+				}
+				auto controlSize = getControlSize(count);
+				size_t dataSize = 0;
+				for (size_t offset = 0; offset < count; offset += ChunkSize) {
+					auto chunkSize = count - offset < ChunkSize ? count - offset : ChunkSize;
+					dataSize += detail::getEncodedSize(detail::toUnsigned(values + offset, chunkSize, temp), chunkSize);
+				}
+				auto control = writer->allocate(controlSize + dataSize);
+				if (control == nullptr) {
+					return detail::writeChunks(writer, values, count);
+				}
+				auto output = control + controlSize;
+				size_t position = 0;
+				for (size_t offset = 0; offset < count; offset += ChunkSize) {
+					auto chunkSize = count - offset < ChunkSize ? count - offset : ChunkSize;
+					auto chunk = detail::toUnsigned(values + offset, chunkSize, temp);
+					//ChunkSize is a multiple of 4, so every chunk starts at a whole control byte.
+					//The encoder writes past the end of its data, chunks near the end go through the stack.
+					if (dataSize - position >= getMaxDataSize(chunkSize) + EncodeSlack) {
+						position += encode(chunk, chunkSize, control + offset / 4, output + position);
+					}
+					else {
+						auto size = encode(chunk, chunkSize, control + offset / 4, data);
+						memcpy(output + position, data, size);
+						position += size;
+					}
+				}
+				return true;
+			}
+
+			//Decodes in place when the reader is memory-backed, otherwise reads control and data into a temporary buffer
+			template<typename StreamReader, typename T>
+			bool read(StreamReader* reader, T* values, size_t count) {
+				if (count == 0) {
+					return true;
+				}
+				auto controlSize = getControlSize(count);
+				auto unsignedValues = reinterpret_cast<uint32_t*>(values);
+
+				size_t availableSize;
+				auto buffer = reader->peek(availableSize);
+				if (buffer != nullptr) {
+					if (controlSize > availableSize) {
+						return false;
+					}
+					auto dataSize = getDataSize(buffer, count);
+					if (dataSize > availableSize - controlSize) {
+						return false;
+					}
+					decode(buffer, buffer + controlSize, dataSize, count, unsignedValues);
+					if (!reader->skip(controlSize + dataSize)) {
+						return false;
+					}
+				}
+				else {
+					BaseVectorType<uint8_t> temp;
+					temp.resize(controlSize);
+					if (!reader->read(temp.data(), controlSize)) {
+						return false;
+					}
+					auto dataSize = getDataSize(temp.data(), count);
+					temp.resize(controlSize + dataSize);
+					if (!reader->read(temp.data() + controlSize, dataSize)) {
+						return false;
+					}
+					decode(temp.data(), temp.data() + controlSize, dataSize, count, unsignedValues);
+				}
+				detail::fromUnsigned(values, count);
+				return true;
+			}
+		}
+	}
+}
+
+#endif // PackedIntegerVector_H
@@ -0,0 +1,584 @@
+#ifndef ResumableDeserializer_H
+#define ResumableDeserializer_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <assert.h>
+
+#include "BaseTypes.h"
+#include "Varint.h"
+#include "StreamSerialization.h"
+#include "BinarySerialization.h"
+
+namespace Antilatency {
+	namespace Serialization {
+
+		enum class FeedResult : uint8_t {
+			NeedMoreData,
+			Done,
+			Error
+		};
+
+		namespace Resumable {
+		#if defined(ARDUINO)
+			static constexpr size_t DefaultMaxMessageSize = 1024;
+		#else
+			static constexpr size_t DefaultMaxMessageSize = 1 << 20;
+		#endif
+		}
+
+		namespace detail {
+			//Memory reader without peek that remembers whether a read ran past the end,
+			//so a failed skip tells truncated data from broken data
+			class PartialMemoryStreamReader final : public IStreamReader {
+			public:
+				PartialMemoryStreamReader(const uint8_t* buffer, size_t size) :
+					_buffer(buffer),
+					_size(size)
+				{
+				}
+
+				bool read(uint8_t* buffer, size_t size) override {
+					if (size > _size - _position) {
+						_isStarved = true;
+						return false;
+					}
+					memcpy(buffer, _buffer + _position, size);
+					_position += size;
+					return true;
+				}
+
+				size_t readSome(uint8_t* buffer, size_t maxSize) override {
+					auto size = _size - _position;
+					if (size > maxSize) {
+						size = maxSize;
+					}
+					if (size == 0) {
+						_isStarved = true;
+					}
+					memcpy(buffer, _buffer + _position, size);
+					_position += size;
+					return size;
+				}
+
+				bool skip(size_t size) override {
+					if (size > _size - _position) {
+						_isStarved = true;
+						return false;
+					}
+					_position += size;
+					return true;
+				}
+
+				size_t getPosition() const {
+					return _position;
+				}
+
+				bool isStarved() const {
+					return _isStarved;
+				}
+
+			private:
+				const uint8_t* _buffer;
+				size_t _size;
+				size_t _position = 0;
+				bool _isStarved = false;
+			};
+
+			enum class ResumableOpCode : uint8_t {
+				Bytes,			//size bytes
+				Varint,			//varint of at most size bytes
+				Array,			//Varint64 count, then count items of size bytes
+				Repeat,			//Varint64 count, then the body count times
+				Presence,		//presence bitmap of size bytes, the body is the structure
+				OptionalFlag,	//bool, the body follows when it is set
+				OptionalBit,	//the body follows when bit size of the enclosing bitmap is set
+				Version,		//Varint64 version, the body follows when it is version, otherwise skip decodes the value
+				Opaque			//skip decodes the value
+			};
+
+			using ResumableSkip = bool(*)(PartialMemoryStreamReader&);
+
+			//end is the index of the op after the body
+			struct ResumableOp {
+				ResumableOpCode code;
+				size_t size;
+				size_t end;
+				uint64_t version;
+				ResumableSkip skip;
+			};
+
+			//Flattens the wire layout of a type into ops, following BasicBinaryDeserializer::skipValue
+			class ResumableProgramBuilder {
+			public:
+				explicit ResumableProgramBuilder(BaseVectorType<ResumableOp>* ops) : _ops(ops) {}
+
+			#define SERIALIZATION_RESUMABLE_BASE_TYPE(type) void add(const type*) { addBytes(sizeof(type)); }
+				SERIALIZATION_RESUMABLE_BASE_TYPE(char)
+				SERIALIZATION_RESUMABLE_BASE_TYPE(uint8_t)
+				SERIALIZATION_RESUMABLE_BASE_TYPE(int8_t)
+				SERIALIZATION_RESUMABLE_BASE_TYPE(uint16_t)
+				SERIALIZATION_RESUMABLE_BASE_TYPE(int16_t)
+				SERIALIZATION_RESUMABLE_BASE_TYPE(uint32_t)
+				SERIALIZATION_RESUMABLE_BASE_TYPE(int32_t)
+				SERIALIZATION_RESUMABLE_BASE_TYPE(uint64_t)
+				SERIALIZATION_RESUMABLE_BASE_TYPE(int64_t)
+				SERIALIZATION_RESUMABLE_BASE_TYPE(float)
+				SERIALIZATION_RESUMABLE_BASE_TYPE(double)
+				SERIALIZATION_RESUMABLE_BASE_TYPE(bool)
+			#undef SERIALIZATION_RESUMABLE_BASE_TYPE
+
+				template<typename T>
+				void add(const Varint<T>*) {
+					push(ResumableOpCode::Varint, Varint<T>::maxSize);
+				}
+
+				template<typename T, typename Name>
+				void add(const SingleField<T, Name>*) {
+					add(static_cast<const T*>(nullptr));
+				}
+
+				template<typename T, typename Name>
+				void add(const ContainerField<T, Name>*) {
+					add(static_cast<const T*>(nullptr));
+				}
+
+				template<typename T>
+				void add(const LazyField<T>*) {
+					add(static_cast<const T*>(nullptr));
+				}
+
+				template<typename Codec, typename Name>
+				void add(const EncodedField<Codec, Name>*) {
+					add(static_cast<const typename EncodedField<Codec, Name>::WireType*>(nullptr));
+				}
+
+				template<typename Codec, typename Name>
+				void add(const EncodedVectorField<Codec, Name>*) {
+					add(static_cast<const BaseVectorType<typename EncodedVectorField<Codec, Name>::WireType>*>(nullptr));
+				}
+
+				template<typename T, typename Name, size_t MaxConstantRows>
+				void add(const ColumnarVectorField<T, Name, MaxConstantRows>*) {
+					addOpaque<ColumnarVectorField<T, Name, MaxConstantRows>>();
+				}
+
+				template<typename T>
+				void add(const PackedIntegerVector<T>*) {
+					addOpaque<PackedIntegerVector<T>>();
+				}
+
+				template<typename T>
+				void add(const OptioinalField<T>*) {
+					auto index = push(ResumableOpCode::OptionalFlag, 0);
+					add(static_cast<const T*>(nullptr));
+					close(index);
+				}
+
+				template<typename ... Fields>
+				void add(const Structure<Fields...>*) {
+					addStructure(static_cast<const Structure<Fields...>*>(nullptr), BoolConstant<FixedSize<Structure<Fields...>>::value != 0>{});
+				}
+
+				template<uint64_t Version, typename ChildType, typename ... Fields>
+				void add(const VersionedStructure<Version, ChildType, Fields...>*) {
+					auto index = push(ResumableOpCode::Version, 0);
+					(*_ops)[index].version = Version;
+					(*_ops)[index].skip = &skip<ChildType>;
+					add(static_cast<const Structure<Fields...>*>(nullptr));
+					close(index);
+				}
+
+				template<typename T>
+				void add(const BaseVectorType<T>*) {
+					addItems(static_cast<const T*>(nullptr), BoolConstant<FixedSize<T>::value != 0>{});
+				}
+
+				template<typename T>
+				void add(const Span<T>*) {
+					push(ResumableOpCode::Array, sizeof(T));
+				}
+
+				void add(const BaseStringType*) {
+					push(ResumableOpCode::Array, sizeof(char));
+				}
+
+			private:
+				template<typename T>
+				static bool skip(PartialMemoryStreamReader& reader) {
+					BasicBinaryDeserializer<PartialMemoryStreamReader> deserializer(&reader);
+					return deserializer.template skip<T>();
+				}
+
+				size_t push(ResumableOpCode code, size_t size) {
+					ResumableOp op = { code, size, _ops->size() + 1, 0, nullptr };
+					_ops->push_back(op);
+					_canMerge = false;
+					return _ops->size() - 1;
+				}
+
+				//The body of the op at index ends here
+				void close(size_t index) {
+					(*_ops)[index].end = _ops->size();
+					_canMerge = false;
+				}
+
+				//Neighbouring fixed-size values become one op
+				void addBytes(size_t size) {
+					if (_canMerge) {
+						(*_ops)[_ops->size() - 1].size += size;
+						return;
+					}
+					push(ResumableOpCode::Bytes, size);
+					_canMerge = true;
+				}
+
+				template<typename T>
+				void addOpaque() {
+					auto index = push(ResumableOpCode::Opaque, 0);
+					(*_ops)[index].skip = &skip<T>;
+				}
+
+				template<typename T>
+				void addItems(const T*, BoolConstant<true>) {
+					push(ResumableOpCode::Array, FixedSize<T>::value);
+				}
+
+				template<typename T>
+				void addItems(const T* item, BoolConstant<false>) {
+					auto index = push(ResumableOpCode::Repeat, 0);
+					add(item);
+					close(index);
+				}
+
+				template<typename ... Fields>
+				void addStructure(const Structure<Fields...>*, BoolConstant<true>) {
+					addBytes(FixedSize<Structure<Fields...>>::value);
+				}
+
+				template<typename ... Fields>
+				void addStructure(const Structure<Fields...>*, BoolConstant<false>) {
+					using Optionals = OptionalFields<Fields...>;
+					if (Optionals::BitmapSize == 0) {
+						addFields(static_cast<const Structure<Fields...>*>(nullptr), typename MakeIndexSequence<sizeof...(Fields)>::Type{});
+						return;
+					}
+					auto index = push(ResumableOpCode::Presence, Optionals::BitmapSize);
+					addFields(static_cast<const Structure<Fields...>*>(nullptr), typename MakeIndexSequence<sizeof...(Fields)>::Type{});
+					close(index);
+				}
+
+				template<typename ... Fields, size_t ... I>
+				void addFields(const Structure<Fields...>*, IndexSequence<I...>) {
+					const int dummy[] = { (addField(static_cast<const Fields*>(nullptr), OptionalFields<Fields...>::bit(I)), 0)... };
+					static_cast<void>(dummy);
+				}
+
+				template<typename T>
+				void addField(const T* field, size_t) {
+					add(field);
+				}
+
+				template<typename T>
+				void addField(const OptioinalField<T>*, size_t bit) {
+					auto index = push(ResumableOpCode::OptionalBit, bit);
+					add(static_cast<const T*>(nullptr));
+					close(index);
+				}
+
+				BaseVectorType<ResumableOp>* _ops;
+				bool _canMerge = false;
+			};
+		}
+
+		//Deserializes a T that arrives in pieces. Every feed() continues the walk over the wire layout of T
+		//where the previous one stopped: inside nested structures, at an item of a container or in the middle of a varint,
+		//so each byte is looked at once however the message is split. The bytes are kept until the message is complete,
+		//then T is deserialized from them in one pass. Span fields point into these bytes and stay valid until reset().
+		//A VersionedStructure of an older version is read through convertFromPreviousVersion, whose layout is not known
+		//in advance, so it is skipped with BinaryDeserializer from its version on every feed() until it is complete.
+		//ColumnarVectorField and PackedIntegerVector are handled the same way. Keep such values small or feed them in large pieces.
+		template<typename T>
+		class ResumableDeserializer {
+		public:
+			explicit ResumableDeserializer(size_t maxMessageSize = Resumable::DefaultMaxMessageSize) :
+				_maxMessageSize(maxMessageSize)
+			{
+			}
+
+			ResumableDeserializer(const ResumableDeserializer&) = delete;
+			ResumableDeserializer& operator=(const ResumableDeserializer&) = delete;
+
+			//Takes the bytes up to the end of the message, see getUsedSize(). After Done or Error call reset() for the next message.
+			//Messages longer than maxMessageSize are an Error.
+			FeedResult feed(const uint8_t* data, size_t size) {
+				_usedSize = 0;
+				if (_result != FeedResult::NeedMoreData) {
+					return _result;
+				}
+				auto bufferedSize = _buffer.size();
+				if (size > _maxMessageSize - bufferedSize) {
+					size = _maxMessageSize - bufferedSize;
+				}
+				if (size != 0) {
+					_buffer.resize(bufferedSize + size);
+					memcpy(_buffer.data() + bufferedSize, data, size);
+				}
+				_result = run();
+				if (_result == FeedResult::NeedMoreData && _buffer.size() == _maxMessageSize) {
+					_result = FeedResult::Error;
+				}
+				if (_result == FeedResult::Done) {
+					_usedSize = _position - bufferedSize;
+					_buffer.resize(_position);
+				}
+				else {
+					_usedSize = size;
+				}
+				return _result;
+			}
+
+			//Bytes of the last feed() that belong to the message, the rest starts the next one
+			size_t getUsedSize() const {
+				return _usedSize;
+			}
+
+			size_t getBufferedSize() const {
+				return _buffer.size();
+			}
+
+			const T& getValue() const {
+				return _value;
+			}
+
+			T& getValue() {
+				return _value;
+			}
+
+			void reset() {
+				_buffer.clear();
+				_frames.clear();
+				_value = T();
+				_result = FeedResult::NeedMoreData;
+				_usedSize = 0;
+				_pc = 0;
+				_position = 0;
+				_skipSize = 0;
+				_varintValue = 0;
+				_varintSize = 0;
+				_valueBegin = 0;
+				_isOpaque = false;
+			}
+
+		private:
+			using Op = detail::ResumableOp;
+			using OpCode = detail::ResumableOpCode;
+
+			//Repeated body or structure with a presence bitmap
+			struct Frame {
+				size_t begin;
+				size_t end;
+				uint64_t remaining;
+				size_t bitmap;
+			};
+
+			static const BaseVectorType<Op>& getProgram() {
+				static const BaseVectorType<Op> program = makeProgram();
+				return program;
+			}
+
+			static BaseVectorType<Op> makeProgram() {
+				BaseVectorType<Op> ops;
+				detail::ResumableProgramBuilder builder(&ops);
+				builder.add(static_cast<const T*>(nullptr));
+				return ops;
+			}
+
+			FeedResult run() {
+				auto& program = getProgram();
+				while (true) {
+					if (_skipSize != 0) {
+						auto availableSize = _buffer.size() - _position;
+						if (_skipSize > availableSize) {
+							_skipSize -= availableSize;
+							_position = _buffer.size();
+							return FeedResult::NeedMoreData;
+						}
+						_position += _skipSize;
+						_skipSize = 0;
+					}
+					if (_frames.size() != 0 && _pc == _frames.back().end) {
+						auto& frame = _frames.back();
+						if (frame.remaining > 1) {
+							--frame.remaining;
+							_pc = frame.begin;
+						}
+						else {
+							_frames.resize(_frames.size() - 1);
+						}
+						continue;
+					}
+					if (_pc == program.size()) {
+						return finish();
+					}
+					auto& op = program[_pc];
+					if (_isOpaque) {
+						detail::PartialMemoryStreamReader reader(_buffer.data() + _valueBegin, _buffer.size() - _valueBegin);
+						if (!op.skip(reader)) {
+							return reader.isStarved() ? FeedResult::NeedMoreData : FeedResult::Error;
+						}
+						_position = _valueBegin + reader.getPosition();
+						_isOpaque = false;
+						_pc = op.end;
+						continue;
+					}
+					switch (op.code) {
+					case OpCode::Bytes:
+						if (!setSkip(1, op.size)) {
+							return FeedResult::Error;
+						}
+						++_pc;
+						break;
+					case OpCode::Varint: {
+						auto result = readVarint(op.size);
+						if (result != FeedResult::Done) {
+							return result;
+						}
+						_varintValue = 0;
+						++_pc;
+						break;
+					}
+					case OpCode::Array: {
+						auto result = readVarint(Varint64::maxSize);
+						if (result != FeedResult::Done) {
+							return result;
+						}
+						if (!setSkip(takeVarint(), op.size)) {
+							return FeedResult::Error;
+						}
+						++_pc;
+						break;
+					}
+					case OpCode::Repeat: {
+						auto result = readVarint(Varint64::maxSize);
+						if (result != FeedResult::Done) {
+							return result;
+						}
+						//Every item takes at least one byte
+						auto count = takeVarint();
+						if (count > _maxMessageSize - _position) {
+							return FeedResult::Error;
+						}
+						if (count == 0) {
+							_pc = op.end;
+						}
+						else {
+							_frames.push_back(Frame{ _pc + 1, op.end, count, 0 });
+							++_pc;
+						}
+						break;
+					}
+					case OpCode::Presence:
+						_frames.push_back(Frame{ _pc + 1, op.end, 1, _position });
+						if (!setSkip(1, op.size)) {
+							return FeedResult::Error;
+						}
+						++_pc;
+						break;
+					case OpCode::OptionalFlag:
+						if (_position == _buffer.size()) {
+							return FeedResult::NeedMoreData;
+						}
+						_pc = _buffer[_position++] != 0 ? _pc + 1 : op.end;
+						break;
+					case OpCode::OptionalBit: {
+						auto bitmap = _buffer.data() + _frames.back().bitmap;
+						_pc = ((bitmap[op.size / 8] >> (op.size % 8)) & 1) != 0 ? _pc + 1 : op.end;
+						break;
+					}
+					case OpCode::Version: {
+						if (_varintSize == 0) {
+							_valueBegin = _position;
+						}
+						auto result = readVarint(Varint64::maxSize);
+						if (result != FeedResult::Done) {
+							return result;
+						}
+						if (takeVarint() == op.version) {
+							++_pc;
+						}
+						else {
+							_isOpaque = true;
+						}
+						break;
+					}
+					case OpCode::Opaque:
+						_valueBegin = _position;
+						_isOpaque = true;
+						break;
+					}
+				}
+			}
+
+			FeedResult finish() {
+				MemoryStreamReader reader(_buffer.data(), _position);
+				BasicBinaryDeserializer<MemoryStreamReader> deserializer(&reader);
+				if (!deserializer.deserialize(_value) || reader.getPosition() != _position) {
+					return FeedResult::Error;
+				}
+				return FeedResult::Done;
+			}
+
+			bool setSkip(uint64_t count, size_t itemSize) {
+				if (count > static_cast<uint64_t>((_maxMessageSize - _position) / itemSize)) {
+					return false;
+				}
+				_skipSize = static_cast<size_t>(count) * itemSize;
+				return true;
+			}
+
+			//Continues the varint at the current position
+			FeedResult readVarint(size_t maxSize) {
+				while (_position != _buffer.size()) {
+					auto byte = _buffer[_position++];
+					_varintValue |= static_cast<uint64_t>(byte & Varint64::mask) << (Varint64::usedBits * _varintSize);
+					++_varintSize;
+					if ((byte & ~Varint64::mask) == 0) {
+						_varintSize = 0;
+						return FeedResult::Done;
+					}
+					if (_varintSize == maxSize) {
+						return FeedResult::Error;
+					}
+				}
+				return FeedResult::NeedMoreData;
+			}
+
+			uint64_t takeVarint() {
+				auto value = _varintValue;
+				_varintValue = 0;
+				return value;
+			}
+
+			size_t _maxMessageSize;
+			BaseVectorType<uint8_t> _buffer;
+			BaseVectorType<Frame> _frames;
+			T _value;
+			FeedResult _result = FeedResult::NeedMoreData;
+			size_t _usedSize = 0;
+			//Next op and the first byte it has not looked at
+			size_t _pc = 0;
+			size_t _position = 0;
+			size_t _skipSize = 0;
+			//Varint read so far
+			uint64_t _varintValue = 0;
+			size_t _varintSize = 0;
+			//Start of the value skipped from the beginning on every feed
+			size_t _valueBegin = 0;
+			bool _isOpaque = false;
+		};
+	}
+}
+
+#endif // ResumableDeserializer_H
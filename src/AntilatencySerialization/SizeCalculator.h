@@ -0,0 +1,214 @@
+#ifndef SizeCalculator_H
+#define SizeCalculator_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "BaseTypes.h"
+#include "Varint.h"
+#include "Span.h"
+#include "Fields.h"
+#include "Structures.h"
+#include "PackedIntegerVector.h"
+
+namespace Antilatency {
+	namespace Serialization {
+
+#define SERIALIZATION_SIZE_BASE_TYPE(type) bool serialize(const type&) { _size += sizeof(type); return true; }
+#define SERIALIZATION_SIZE_CONTAINER_BASE_TYPE(type) bool serialize(const BaseVectorType<type>& value) { return addNativeContainer(value.size(), sizeof(type)); }
+
+		//Serializer that only sums the size BinarySerializer would write, no stream is involved.
+		//Native containers are measured as size() * sizeof(item) without visiting items.
+		class SizeCalculator {
+		public:
+			void beginStructure() {
+
+			}
+
+			void endStructure() {
+
+			}
+
+			size_t getSize() const {
+				return _size;
+			}
+
+			void reset() {
+				_size = 0;
+			}
+
+			template<typename T>
+			bool serialize(const T& value) {
+				return value.serialize(*this);
+			}
+
+			bool serializePresence(const uint8_t*, size_t size) {
+				_size += size;
+				return true;
+			}
+
+			template <typename T>
+			bool serialize(const Varint<T>& value) {
+		#if SERIALIZATION_BYTE_ORDER == SERIALIZATION_BIG_ENDIAN
+				_size += Varint<T>(swapBytes(value.getValue())).getActualSize();
+		#else
+				_size += value.getActualSize();
+		#endif
+				return true;
+			}
+
+			template <typename T>
+			bool serialize(const BaseVectorType<T>& value) {
+				serialize(Varint64(value.size()));
+				for (size_t i = 0; i < value.size(); ++i) {
+					serialize(value[i]);
+				}
+				return true;
+			}
+
+			template <typename T>
+			bool serialize(const Span<T>& value) {
+				return addNativeContainer(value.size(), sizeof(T));
+			}
+
+			template <typename T>
+			bool serialize(const PackedIntegerVector<T>& value) {
+				serialize(Varint64(value.size()));
+				_size += StreamVByte::getControlSize(value.size());
+				for (size_t i = 0; i < value.size(); ++i) {
+					_size += StreamVByte::detail::getCode(static_cast<uint32_t>(detail::zigzagEncode(value[i]))) + 1;
+				}
+				return true;
+			}
+
+			SERIALIZATION_SIZE_BASE_TYPE(char)
+			SERIALIZATION_SIZE_BASE_TYPE(uint8_t)
+			SERIALIZATION_SIZE_BASE_TYPE(int8_t)
+			SERIALIZATION_SIZE_BASE_TYPE(uint16_t)
+			SERIALIZATION_SIZE_BASE_TYPE(int16_t)
+			SERIALIZATION_SIZE_BASE_TYPE(uint32_t)
+			SERIALIZATION_SIZE_BASE_TYPE(int32_t)
+			SERIALIZATION_SIZE_BASE_TYPE(uint64_t)
+			SERIALIZATION_SIZE_BASE_TYPE(int64_t)
+			SERIALIZATION_SIZE_BASE_TYPE(float)
+			SERIALIZATION_SIZE_BASE_TYPE(double)
+			SERIALIZATION_SIZE_BASE_TYPE(bool)
+
+			SERIALIZATION_SIZE_CONTAINER_BASE_TYPE(uint8_t)
+			SERIALIZATION_SIZE_CONTAINER_BASE_TYPE(int8_t)
+			SERIALIZATION_SIZE_CONTAINER_BASE_TYPE(uint16_t)
+			SERIALIZATION_SIZE_CONTAINER_BASE_TYPE(int16_t)
+			SERIALIZATION_SIZE_CONTAINER_BASE_TYPE(uint32_t)
+			SERIALIZATION_SIZE_CONTAINER_BASE_TYPE(int32_t)
+			SERIALIZATION_SIZE_CONTAINER_BASE_TYPE(uint64_t)
+			SERIALIZATION_SIZE_CONTAINER_BASE_TYPE(int64_t)
+			SERIALIZATION_SIZE_CONTAINER_BASE_TYPE(float)
+			SERIALIZATION_SIZE_CONTAINER_BASE_TYPE(double)
+
+			bool serialize(const BaseStringType& value) {
+				return addNativeContainer(value.length(), sizeof(char));
+			}
+
+		private:
+			bool addNativeContainer(size_t containerSize, size_t itemSize) {
+				serialize(Varint64(containerSize));
+				_size += containerSize * itemSize;
+				return true;
+			}
+
+			size_t _size = 0;
+		};
+
+		namespace detail {
+			//Overloads take pointers, so types derived from Structure/VersionedStructure pick the closest base.
+			//Types with no overload (containers, strings) have no maximum size and fail to compile.
+			constexpr size_t maxSerializedSize(const char*) { return sizeof(char); }
+			constexpr size_t maxSerializedSize(const uint8_t*) { return sizeof(uint8_t); }
+			constexpr size_t maxSerializedSize(const int8_t*) { return sizeof(int8_t); }
+			constexpr size_t maxSerializedSize(const uint16_t*) { return sizeof(uint16_t); }
+			constexpr size_t maxSerializedSize(const int16_t*) { return sizeof(int16_t); }
+			constexpr size_t maxSerializedSize(const uint32_t*) { return sizeof(uint32_t); }
+			constexpr size_t maxSerializedSize(const int32_t*) { return sizeof(int32_t); }
+			constexpr size_t maxSerializedSize(const uint64_t*) { return sizeof(uint64_t); }
+			constexpr size_t maxSerializedSize(const int64_t*) { return sizeof(int64_t); }
+			constexpr size_t maxSerializedSize(const float*) { return sizeof(float); }
+			constexpr size_t maxSerializedSize(const double*) { return sizeof(double); }
+			constexpr size_t maxSerializedSize(const bool*) { return sizeof(uint8_t); }
+
+			template<typename T>
+			constexpr size_t maxSerializedSize(const Varint<T>*);
+
+			template<typename T, typename Name>
+			constexpr size_t maxSerializedSize(const SingleField<T, Name>*);
+
+			template<typename T>
+			constexpr size_t maxSerializedSize(const OptioinalField<T>*);
+
+			template<typename Codec, typename Name>
+			constexpr size_t maxSerializedSize(const EncodedField<Codec, Name>*);
+
+			template<typename ... Fields>
+			constexpr size_t maxSerializedSize(const Structure<Fields...>*);
+
+			template<uint64_t Version, typename ChildType, typename ... Fields>
+			constexpr size_t maxSerializedSize(const VersionedStructure<Version, ChildType, Fields...>*);
+
+			template<typename ... Types>
+			constexpr size_t sumMaxSerializedSize() {
+				const size_t sizes[] = { 0, maxSerializedSize(static_cast<const Types*>(nullptr))... };
+				size_t result = 0;
+				for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i) {
+					result += sizes[i];
+				}
+				return result;
+			}
+
+			template<typename T>
+			constexpr size_t maxSerializedSize(const Varint<T>*) {
+				return Varint<T>::maxSize;
+			}
+
+			template<typename T, typename Name>
+			constexpr size_t maxSerializedSize(const SingleField<T, Name>*) {
+				return maxSerializedSize(static_cast<const T*>(nullptr));
+			}
+
+			template<typename T>
+			constexpr size_t maxSerializedSize(const OptioinalField<T>*) {
+				return sizeof(uint8_t) + maxSerializedSize(static_cast<const T*>(nullptr));
+			}
+
+			template<typename Codec, typename Name>
+			constexpr size_t maxSerializedSize(const EncodedField<Codec, Name>*) {
+				return sizeof(typename EncodedField<Codec, Name>::WireType);
+			}
+
+			//Inside a structure the flag bytes of optional fields are replaced by one bitmap
+			template<typename ... Fields>
+			constexpr size_t maxSerializedSize(const Structure<Fields...>*) {
+				return sumMaxSerializedSize<Fields...>() - OptionalFields<Fields...>::count() + OptionalFields<Fields...>::BitmapSize;
+			}
+
+			template<uint64_t Version, typename ChildType, typename ... Fields>
+			constexpr size_t maxSerializedSize(const VersionedStructure<Version, ChildType, Fields...>*) {
+				return Varint64::getEncodedSize(Version) + maxSerializedSize(static_cast<const Structure<Fields...>*>(nullptr));
+			}
+		}
+
+		//Upper bound of the serialized size of a structure made of fixed-width fields (base types, Varints, optionals, nested structures).
+		//Usable in static_assert and as a stack buffer size.
+		template<typename T>
+		constexpr size_t maxSerializedSize() {
+			return detail::maxSerializedSize(static_cast<const T*>(nullptr));
+		}
+
+		//Serialized size of a value without writing it
+		template<typename T>
+		size_t getSerializedSize(const T& value) {
+			SizeCalculator calculator;
+			calculator.serialize(value);
+			return calculator.getSize();
+		}
+	}
+}
+
+#endif // SizeCalculator_H
@@ -0,0 +1,66 @@
+#ifndef Span_H
+#define Span_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <assert.h>
+
+namespace Antilatency {
+	namespace Serialization {
+
+		//Non-owning view of contiguous elements, filled by BinaryDeserializer straight from the input buffer.
+		//The buffer must outlive the view. The wire format has no padding, so only byte-sized types can be viewed in place,
+		//use VectorField for multibyte items.
+		template<typename T>
+		class Span {
+			static_assert(alignof(T) == 1 && sizeof(T) == 1, "Span items must be single bytes");
+		public:
+			using Type = T;
+
+			constexpr Span() = default;
+
+			constexpr Span(const T* data, size_t size) :
+				_data(data),
+				_size(size)
+			{
+			}
+
+			const T* data() const {
+				return _data;
+			}
+
+			size_t size() const {
+				return _size;
+			}
+
+			size_t length() const {
+				return _size;
+			}
+
+			bool empty() const {
+				return _size == 0;
+			}
+
+			const T& operator[](size_t index) const {
+				assert(index < _size);
+				return _data[index];
+			}
+
+			const T* begin() const {
+				return _data;
+			}
+
+			const T* end() const {
+				return _data + _size;
+			}
+
+		private:
+			const T* _data = nullptr;
+			size_t _size = 0;
+		};
+
+		using StringView = Span<char>;
+	}
+}
+
+#endif // Span_H
@@ -16,15 +16,48 @@ namespace Antilatency {
 		public:
 			virtual ~IStreamWriter() = default;
 			virtual bool write(const uint8_t* buffer, size_t size) = 0;
+
+			//Returns memory for the next size bytes and counts them as written when the stream is backed by memory with enough room, otherwise nullptr.
+			virtual uint8_t* allocate(size_t size) {
+				static_cast<void>(size);
+				return nullptr;
+			}
 		};
 
 		class IStreamReader {
 		public:
 			virtual ~IStreamReader() = default;
 			virtual bool read(uint8_t* buffer, size_t size) = 0;
+
+			//Reads at least one and at most maxSize bytes, returns the number of bytes read or 0 on failure.
+			//Default implementation reads a single byte, streams that know their available size should override it.
+			virtual size_t readSome(uint8_t* buffer, size_t maxSize) {
+				if (maxSize == 0 || !read(buffer, 1)) {
+					return 0;
+				}
+				return 1;
+			}
+
+			//Returns the unread bytes when the stream is backed by contiguous memory that outlives the reader, otherwise nullptr.
+			virtual const uint8_t* peek(size_t& availableSize) {
+				availableSize = 0;
+				return nullptr;
+			}
+
+			virtual bool skip(size_t size) {
+				uint8_t temp[64];
+				while (size > 0) {
+					auto chunkSize = size < sizeof(temp) ? size : sizeof(temp);
+					if (!read(temp, chunkSize)) {
+						return false;
+					}
+					size -= chunkSize;
+				}
+				return true;
+			}
 		};
 
-		class MemoryStreamReader : public IStreamReader {
+		class MemoryStreamReader final : public IStreamReader {
 		public:
 			MemoryStreamReader(const uint8_t* buffer, size_t capacity) :
 				_buffer(buffer), 
@@ -32,9 +65,6 @@ namespace Antilatency {
 			{
 			}
 
-
-
-		private:
 			bool read(uint8_t* buffer, size_t size) override {
 				if (_currentPosition + size <= _capacity) {
 					memcpy(buffer, _buffer + _currentPosition, size);
@@ -44,13 +74,38 @@ namespace Antilatency {
 				return false;
 			}
 
+			size_t readSome(uint8_t* buffer, size_t maxSize) override {
+				auto available = _capacity - _currentPosition;
+				auto size = maxSize < available ? maxSize : available;
+				memcpy(buffer, _buffer + _currentPosition, size);
+				_currentPosition += size;
+				return size;
+			}
+
+			const uint8_t* peek(size_t& availableSize) override {
+				availableSize = _capacity - _currentPosition;
+				return _buffer + _currentPosition;
+			}
+
+			size_t getPosition() const {
+				return _currentPosition;
+			}
+
+			bool skip(size_t size) override {
+				if (size <= _capacity - _currentPosition) {
+					_currentPosition += size;
+					return true;
+				}
+				return false;
+			}
+
 		private:
 			const uint8_t* _buffer;
 			size_t _capacity;
 			size_t _currentPosition = 0;
 		};
 
-		class MemoryStreamWriter : public IStreamWriter {
+		class MemoryStreamWriter final : public IStreamWriter {
 		public:
 			MemoryStreamWriter(uint8_t* buffer, size_t capacity) :
 				_buffer(buffer),
@@ -58,7 +113,6 @@ namespace Antilatency {
 			{
 			}
 
-		private:
 			bool write(const uint8_t* buffer, size_t size) override {
 				if(_currentPosition + size <= _capacity) {
 					memcpy(_buffer + _currentPosition, buffer, size);
@@ -69,6 +123,15 @@ namespace Antilatency {
 				return false;
 			}
 
+			uint8_t* allocate(size_t size) override {
+				if (size <= _capacity - _currentPosition) {
+					auto result = _buffer + _currentPosition;
+					_currentPosition += size;
+					return result;
+				}
+				return nullptr;
+			}
+
 		private:
 			uint8_t* _buffer;
 			size_t _capacity;
@@ -76,14 +139,13 @@ namespace Antilatency {
 		};
 
 		class MemorySizeCounterStream final : public IStreamWriter{
-
-		private:
+		public:
 			bool write(const uint8_t* buffer, size_t size) override {
 				buffer;
 				_totalSize += size;
 				return true;
 			}
-		public:
+
 			size_t getActualSize() const {
 				return _totalSize;
 			}
@@ -0,0 +1,196 @@
+#ifndef StreamVByte_H
+#define StreamVByte_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "BaseTypes.h"
+
+#if defined(ANTILATENCY_SERIALIZATION_SSSE3)
+	#include <tmmintrin.h>
+#endif
+
+namespace Antilatency {
+	namespace Serialization {
+
+		//Stream VByte integer codec: one control byte per 4 values (2 bits of length - 1 for each),
+		//all control bytes go first, then 1..4 little endian data bytes per value.
+		//Scalar and SSSE3 kernels produce identical bytes.
+		namespace StreamVByte {
+
+			//Encoders may write up to this many bytes past the end of encoded data
+			static constexpr size_t EncodeSlack = 16;
+
+			static constexpr size_t getControlSize(size_t count) {
+				return (count + 3) / 4;
+			}
+
+			static constexpr size_t getMaxDataSize(size_t count) {
+				return count * sizeof(uint32_t);
+			}
+
+			namespace detail {
+				struct Tables {
+					uint8_t length[256];
+					uint8_t decodeShuffle[256][16];
+					uint8_t encodeShuffle[256][16];
+				};
+
+				constexpr Tables makeTables() {
+					Tables tables{};
+					for (size_t control = 0; control < 256; ++control) {
+						size_t offset = 0;
+						for (size_t i = 0; i < 16; ++i) {
+							tables.decodeShuffle[control][i] = 0xFF;
+							tables.encodeShuffle[control][i] = 0xFF;
+						}
+						for (size_t lane = 0; lane < 4; ++lane) {
+							size_t length = ((control >> (2 * lane)) & 3) + 1;
+							for (size_t j = 0; j < length; ++j) {
+								tables.decodeShuffle[control][4 * lane + j] = static_cast<uint8_t>(offset + j);
+								tables.encodeShuffle[control][offset + j] = static_cast<uint8_t>(4 * lane + j);
+							}
+							offset += length;
+						}
+						tables.length[control] = static_cast<uint8_t>(offset);
+					}
+					return tables;
+				}
+
+				static constexpr Tables tables = makeTables();
+
+				inline uint8_t getCode(uint32_t value) {
+					return static_cast<uint8_t>((value > 0xFF) + (value > 0xFFFF) + (value > 0xFFFFFF));
+				}
+
+				inline uint8_t* encodeValue(uint32_t value, uint8_t code, uint8_t* data) {
+					for (size_t i = 0; i <= code; ++i) {
+						data[i] = static_cast<uint8_t>(value >> (8 * i));
+					}
+					return data + code + 1;
+				}
+
+				inline const uint8_t* decodeValue(const uint8_t* data, uint8_t code, uint32_t& value) {
+					value = 0;
+					for (size_t i = 0; i <= code; ++i) {
+						value |= static_cast<uint32_t>(data[i]) << (8 * i);
+					}
+					return data + code + 1;
+				}
+
+				//Last control byte may describe less than 4 values, unused codes are zero and have no data
+				inline uint8_t getTailControl(const uint32_t* values, size_t count, uint8_t*& data) {
+					uint8_t control = 0;
+					for (size_t i = 0; i < count; ++i) {
+						auto code = getCode(values[i]);
+						data = encodeValue(values[i], code, data);
+						control |= static_cast<uint8_t>(code << (2 * i));
+					}
+					return control;
+				}
+			}
+
+			//Returns size of data bytes described by control bytes of count values
+			inline size_t getDataSize(const uint8_t* control, size_t count) {
+				size_t size = 0;
+				auto quads = count / 4;
+				for (size_t i = 0; i < quads; ++i) {
+					size += detail::tables.length[control[i]];
+				}
+				for (size_t i = 0; i < count % 4; ++i) {
+					size += ((control[quads] >> (2 * i)) & 3) + 1;
+				}
+				return size;
+			}
+
+			//Returns size of data bytes, control must have getControlSize(count) bytes
+			inline size_t encodeScalar(const uint32_t* values, size_t count, uint8_t* control, uint8_t* data) {
+				auto begin = data;
+				auto quads = count / 4;
+				for (size_t i = 0; i < quads; ++i) {
+					control[i] = detail::getTailControl(values + 4 * i, 4, data);
+				}
+				if (count % 4) {
+					control[quads] = detail::getTailControl(values + 4 * quads, count % 4, data);
+				}
+				return static_cast<size_t>(data - begin);
+			}
+
+			//Returns number of data bytes used or 0 if dataSize is not enough
+			inline size_t decodeScalar(const uint8_t* control, const uint8_t* data, size_t dataSize, size_t count, uint32_t* values) {
+				if (getDataSize(control, count) > dataSize) {
+					return 0;
+				}
+				auto begin = data;
+				for (size_t i = 0; i < count; ++i) {
+					data = detail::decodeValue(data, (control[i / 4] >> (2 * (i % 4))) & 3, values[i]);
+				}
+				return static_cast<size_t>(data - begin);
+			}
+
+		#if defined(ANTILATENCY_SERIALIZATION_SSSE3)
+			//data must have getMaxDataSize(count) + EncodeSlack bytes
+			inline size_t encode(const uint32_t* values, size_t count, uint8_t* control, uint8_t* data) {
+				auto begin = data;
+				auto quads = count / 4;
+				const __m128i zero = _mm_setzero_si128();
+				const __m128i three = _mm_set1_epi32(3);
+				for (size_t i = 0; i < quads; ++i) {
+					__m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(values + 4 * i));
+					//3 + (-1 for every zero upper byte) = code of each lane
+					__m128i codes = _mm_add_epi32(_mm_cmpeq_epi32(_mm_srli_epi32(value, 8), zero), _mm_cmpeq_epi32(_mm_srli_epi32(value, 16), zero));
+					codes = _mm_add_epi32(codes, _mm_cmpeq_epi32(_mm_srli_epi32(value, 24), zero));
+					codes = _mm_add_epi32(codes, three);
+					codes = _mm_packus_epi16(_mm_packs_epi32(codes, codes), zero);
+					uint32_t packedCodes = static_cast<uint32_t>(_mm_cvtsi128_si32(codes));
+					packedCodes |= packedCodes >> 6;
+					packedCodes |= packedCodes >> 12;
+					uint8_t code = static_cast<uint8_t>(packedCodes);
+
+					__m128i shuffle = _mm_loadu_si128(reinterpret_cast<const __m128i*>(detail::tables.encodeShuffle[code]));
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(data), _mm_shuffle_epi8(value, shuffle));
+					data += detail::tables.length[code];
+					control[i] = code;
+				}
+				if (count % 4) {
+					control[quads] = detail::getTailControl(values + 4 * quads, count % 4, data);
+				}
+				return static_cast<size_t>(data - begin);
+			}
+
+			inline size_t decode(const uint8_t* control, const uint8_t* data, size_t dataSize, size_t count, uint32_t* values) {
+				if (getDataSize(control, count) > dataSize) {
+					return 0;
+				}
+				auto begin = data;
+				auto end = data + dataSize;
+				auto quads = count / 4;
+				size_t i = 0;
+				//Full 16 byte loads stay inside the data
+				for (; i < quads && end - data >= 16; ++i) {
+					auto code = control[i];
+					__m128i encoded = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+					__m128i shuffle = _mm_loadu_si128(reinterpret_cast<const __m128i*>(detail::tables.decodeShuffle[code]));
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(values + 4 * i), _mm_shuffle_epi8(encoded, shuffle));
+					data += detail::tables.length[code];
+				}
+				for (i *= 4; i < count; ++i) {
+					data = detail::decodeValue(data, (control[i / 4] >> (2 * (i % 4))) & 3, values[i]);
+				}
+				return static_cast<size_t>(data - begin);
+			}
+		#else
+			inline size_t encode(const uint32_t* values, size_t count, uint8_t* control, uint8_t* data) {
+				return encodeScalar(values, count, control, data);
+			}
+
+			inline size_t decode(const uint8_t* control, const uint8_t* data, size_t dataSize, size_t count, uint32_t* values) {
+				return decodeScalar(control, data, dataSize, count, values);
+			}
+		#endif
+		}
+	}
+}
+
+#endif // StreamVByte_H
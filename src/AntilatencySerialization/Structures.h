@@ -10,124 +10,258 @@ namespace Antilatency {
 	namespace Serialization {
 
 #define SERIALIZATION_MAKE_FIELD_NAME(name) class name {public: static constexpr auto FieldName = #name;} 
+
+		template <typename T>
+		class OptioinalField;
+
+		template <typename Codec, typename Name>
+		class EncodedField;
+
+		template <typename Codec, typename Name>
+		class EncodedVectorField;
+
+		template <typename T, typename Name, size_t MaxConstantRows>
+		class ColumnarVectorField;
+
 		namespace detail {
-			template< typename T, typename Name>
-			struct Single {
-				static T& get(T& value) {
-					static_assert(sizeof(Name) != sizeof(Name), "Field is not supported");
-					return value;
-				}
+			template<bool Value>
+			struct BoolConstant {
+				static constexpr bool value = Value;
+			};
 
-				static const T& get(const T& value) {
-					static_assert(sizeof(Name) != sizeof(Name), "Field is not supported");
-					return value;
-				}
+			template<size_t ... Indices>
+			struct IndexSequence {};
+
+			template<typename First, typename Second>
+			struct ConcatIndexSequence;
+
+			template<size_t ... First, size_t ... Second>
+			struct ConcatIndexSequence<IndexSequence<First...>, IndexSequence<Second...>> {
+				using Type = IndexSequence<First..., (sizeof...(First) + Second)...>;
 			};
 
-			template< typename T >
-			struct Single<T, typename T::Name> {
-				static T& get(T& value) {
-					return value;
-				}
+			//Halving keeps instantiation depth logarithmic in the number of fields
+			template<size_t Count>
+			struct MakeIndexSequence {
+				using Type = typename ConcatIndexSequence<typename MakeIndexSequence<Count / 2>::Type, typename MakeIndexSequence<Count - Count / 2>::Type>::Type;
+			};
 
-				static const T& get(const T& value) {
-					return value;
-				}
+			template<>
+			struct MakeIndexSequence<0> {
+				using Type = IndexSequence<>;
 			};
 
-			template< typename FirstFieldType, typename RestFieldsType, typename Name>
-			struct Multi {
-				static auto get(FirstFieldType& firstField, RestFieldsType& restFields) -> decltype(restFields.template get<Name>()) {
-					firstField;
-					return restFields.template get<Name>();
-				}
+			template<>
+			struct MakeIndexSequence<1> {
+				using Type = IndexSequence<0>;
+			};
 
-				static auto get(const FirstFieldType& firstField, const RestFieldsType& restFields) -> decltype(restFields.template get<Name>()) {
-					firstField;
-					return restFields.template get<Name>();
-				}
+			template<typename Name, size_t Index, typename FieldType>
+			struct FieldHolder {
+				FieldType field;
 			};
 
-			template<typename FirstFieldType, typename RestFieldsType>
-			struct Multi<FirstFieldType, RestFieldsType, typename FirstFieldType::Name> {
+			//Every field is a direct base, so a field is found by name or index with a single overload resolution
+			template<typename Indices, typename ... Fields>
+			struct StructureStorage;
 
-				static FirstFieldType& get(FirstFieldType& firstField, RestFieldsType& restFields) {
-					restFields;
-					return firstField;
+			template<size_t ... Indices, typename ... Fields>
+			struct StructureStorage<IndexSequence<Indices...>, Fields...> : FieldHolder<typename Fields::Name, Indices, Fields>... {
+			};
+
+			template<typename Name, size_t Index, typename FieldType>
+			FieldType& getFieldByName(FieldHolder<Name, Index, FieldType>& holder) {
+				return holder.field;
+			}
+
+			template<typename Name, size_t Index, typename FieldType>
+			const FieldType& getFieldByName(const FieldHolder<Name, Index, FieldType>& holder) {
+				return holder.field;
+			}
+
+			template<size_t Index, typename Name, typename FieldType>
+			FieldType& getFieldByIndex(FieldHolder<Name, Index, FieldType>& holder) {
+				return holder.field;
+			}
+
+			template<size_t Index, typename Name, typename FieldType>
+			const FieldType& getFieldByIndex(const FieldHolder<Name, Index, FieldType>& holder) {
+				return holder.field;
+			}
+
+			template<typename T>
+			struct IsOptionalField : BoolConstant<false> {};
+
+			template<typename T>
+			struct IsOptionalField<OptioinalField<T>> : BoolConstant<true> {};
+
+			//Existence of the optional fields of a structure is written as one bitmap of BitmapSize bytes
+			template<typename ... Fields>
+			struct OptionalFields {
+				static constexpr size_t count() {
+					const bool isOptional[] = { IsOptionalField<Fields>::value... };
+					size_t result = 0;
+					for (size_t i = 0; i < sizeof...(Fields); ++i) {
+						result += isOptional[i] ? 1 : 0;
+					}
+					return result;
 				}
 
-				static const FirstFieldType& get(const FirstFieldType& firstField, const RestFieldsType& restFields) {
-					restFields;
-					return firstField;
+				//Bit of the field in the bitmap, fields before it that are optional
+				static constexpr size_t bit(size_t fieldIndex) {
+					const bool isOptional[] = { IsOptionalField<Fields>::value... };
+					size_t result = 0;
+					for (size_t i = 0; i < fieldIndex; ++i) {
+						result += isOptional[i] ? 1 : 0;
+					}
+					return result;
 				}
+
+				static constexpr size_t BitmapSize = (count() + 7) / 8;
+
+				//Zero-length arrays are not allowed
+				static constexpr size_t BufferSize = BitmapSize != 0 ? BitmapSize : 1;
 			};
 
+			//Serializers opt in to the bitmap by providing serializePresence/deserializePresence,
+			//others (OstreamSerializer, user serializers) get a flag per optional field as before
+			template<typename Serializer>
+			auto hasSerializePresence(Serializer* serializer, int) -> decltype(serializer->serializePresence(static_cast<const uint8_t*>(nullptr), size_t()), BoolConstant<true>());
+
+			template<typename Serializer>
+			BoolConstant<false> hasSerializePresence(Serializer*, long);
+
+			template<typename Deserializer>
+			auto hasDeserializePresence(Deserializer* deserializer, int) -> decltype(deserializer->deserializePresence(static_cast<uint8_t*>(nullptr), size_t()), BoolConstant<true>());
+
+			template<typename Deserializer>
+			BoolConstant<false> hasDeserializePresence(Deserializer*, long);
+
+			template<typename Serializer, typename ... Fields>
+			struct UsePresenceBitmap : BoolConstant<OptionalFields<Fields...>::BitmapSize != 0 &&
+				decltype(hasSerializePresence(static_cast<Serializer*>(nullptr), 0))::value> {};
+
+			template<typename Deserializer, typename ... Fields>
+			struct UsePresenceBitmapOnRead : BoolConstant<OptionalFields<Fields...>::BitmapSize != 0 &&
+				decltype(hasDeserializePresence(static_cast<Deserializer*>(nullptr), 0))::value> {};
 		}
 
 		template <typename FirstField, typename ... Fields>
-		class Structure {
-			FirstField firstField;
-			Structure<Fields...> restFields;
+		class Structure : private detail::StructureStorage<typename detail::MakeIndexSequence<1 + sizeof...(Fields)>::Type, FirstField, Fields...> {
+			using Indices = typename detail::MakeIndexSequence<1 + sizeof...(Fields)>::Type;
 		public:
+			static constexpr size_t FieldCount = 1 + sizeof...(Fields);
+
 			template<typename Name>
-			auto get() -> decltype(detail::Multi<FirstField, Structure<Fields...>, Name>::get(firstField, restFields)) {
-				return detail::Multi<FirstField, Structure<Fields...>, Name>::get(firstField, restFields);
+			auto& get() {
+				return detail::getFieldByName<Name>(*this);
 			}
 
 			template<typename Name>
-			auto get() const -> decltype(detail::Multi<FirstField, Structure<Fields...>, Name>::get(firstField, restFields)) {
-				return detail::Multi<FirstField, Structure<Fields...>, Name>::get(firstField, restFields);
+			const auto& get() const {
+				return detail::getFieldByName<Name>(*this);
+			}
+
+			template<size_t Index>
+			auto& getField() {
+				return detail::getFieldByIndex<Index>(*this);
+			}
+
+			template<size_t Index>
+			const auto& getField() const {
+				return detail::getFieldByIndex<Index>(*this);
 			}
 		
 			template<typename Serializer>
 			bool serialize(Serializer& serializer) const {
 				serializer.beginStructure();
-				if(firstField.serialize(serializer)) {
-					if(restFields.serialize(serializer)) {
-						serializer.endStructure();
-						return true;
-					}
-				}		
+				if (serializeFields(serializer, Indices{}, detail::UsePresenceBitmap<Serializer, FirstField, Fields...>{})) {
+					serializer.endStructure();
+					return true;
+				}
 				return false;
 			}
 
 			template<typename Deserializer>
 			bool deserialize(Deserializer& deserializer) {
-				if(firstField.deserialize(deserializer)) {
-					return restFields.deserialize(deserializer);
+				return deserializeFields(deserializer, Indices{}, detail::UsePresenceBitmapOnRead<Deserializer, FirstField, Fields...>{});
+			}
+
+		private:
+			using Optionals = detail::OptionalFields<FirstField, Fields...>;
+
+			//Fields are visited in order and the first failure stops the rest
+			template<typename Serializer, size_t ... FieldIndices>
+			bool serializeFields(Serializer& serializer, detail::IndexSequence<FieldIndices...>, detail::BoolConstant<false>) const {
+				bool isOk = true;
+				const int dummy[] = { (isOk = isOk && getField<FieldIndices>().serialize(serializer), 0)... };
+				static_cast<void>(dummy);
+				return isOk;
+			}
+
+			template<typename Serializer, size_t ... FieldIndices>
+			bool serializeFields(Serializer& serializer, detail::IndexSequence<FieldIndices...>, detail::BoolConstant<true>) const {
+				uint8_t bitmap[Optionals::BufferSize] = {};
+				const int setBits[] = { (setPresence(bitmap, Optionals::bit(FieldIndices), getField<FieldIndices>()), 0)... };
+				static_cast<void>(setBits);
+				if (!serializer.serializePresence(bitmap, Optionals::BitmapSize)) {
+					return false;
 				}
-				return false;
+				bool isOk = true;
+				const int dummy[] = { (isOk = isOk && serializeField(serializer, getField<FieldIndices>()), 0)... };
+				static_cast<void>(dummy);
+				return isOk;
 			}
-		};		
 
-		template <typename FirstField>
-		class Structure<FirstField> {
-			FirstField firstField;
-		public:
-			template<typename Name>
-			FirstField& get() {
-				return detail::Single<FirstField, Name>::get(firstField);
+			template<typename Deserializer, size_t ... FieldIndices>
+			bool deserializeFields(Deserializer& deserializer, detail::IndexSequence<FieldIndices...>, detail::BoolConstant<false>) {
+				bool isOk = true;
+				const int dummy[] = { (isOk = isOk && getField<FieldIndices>().deserialize(deserializer), 0)... };
+				static_cast<void>(dummy);
+				return isOk;
 			}
 
-			template<typename Name>
-			const FirstField& get() const {
-				return detail::Single<FirstField, Name>::get(firstField);
+			template<typename Deserializer, size_t ... FieldIndices>
+			bool deserializeFields(Deserializer& deserializer, detail::IndexSequence<FieldIndices...>, detail::BoolConstant<true>) {
+				uint8_t bitmap[Optionals::BufferSize];
+				if (!deserializer.deserializePresence(bitmap, Optionals::BitmapSize)) {
+					return false;
+				}
+				bool isOk = true;
+				const int dummy[] = { (isOk = isOk && deserializeField(deserializer, bitmap, Optionals::bit(FieldIndices), getField<FieldIndices>()), 0)... };
+				static_cast<void>(dummy);
+				return isOk;
 			}
 
+			template<typename Field>
+			static void setPresence(uint8_t*, size_t, const Field&) {
+			}
 
-			template<typename Serializer>
-			bool serialize(Serializer& serializer) const {
-				serializer.beginStructure();
-				if (firstField.serialize(serializer)) {
-					serializer.endStructure();
-					return true;
+			template<typename T>
+			static void setPresence(uint8_t* bitmap, size_t bit, const OptioinalField<T>& field) {
+				if (field.isExists()) {
+					bitmap[bit / 8] |= static_cast<uint8_t>(1 << (bit % 8));
 				}
-				return false;
 			}
 
-			template<typename Deserializer>
-			bool deserialize(Deserializer& deserializer) {
-				return firstField.deserialize(deserializer);
+			template<typename Serializer, typename Field>
+			static bool serializeField(Serializer& serializer, const Field& field) {
+				return field.serialize(serializer) != 0;
+			}
+
+			template<typename Serializer, typename T>
+			static bool serializeField(Serializer& serializer, const OptioinalField<T>& field) {
+				return field.serializeValue(serializer);
+			}
+
+			template<typename Deserializer, typename Field>
+			static bool deserializeField(Deserializer& deserializer, const uint8_t*, size_t, Field& field) {
+				return field.deserialize(deserializer) != 0;
+			}
+
+			template<typename Deserializer, typename T>
+			static bool deserializeField(Deserializer& deserializer, const uint8_t* bitmap, size_t bit, OptioinalField<T>& field) {
+				return field.deserializeValue(deserializer, ((bitmap[bit / 8] >> (bit % 8)) & 1) != 0);
 			}
 		};
 
@@ -143,7 +277,7 @@ namespace Antilatency {
 			bool serialize(Serializer& serializer) const {	
 				serializer.beginStructure();
 				if(serializer.serialize(Version)) {
-					if(Structure<Fields...>::serialize(serializer)) {
+					if(serializer.serialize(static_cast<const Structure<Fields...>&>(*this))) {
 						serializer.endStructure();
 						return true;
 					}
@@ -163,13 +297,21 @@ namespace Antilatency {
 			template<typename Deserializer>
 			bool deserialize(VersionType version, Deserializer& deserializer) {
 				if (version == Version) {
-					return Structure<Fields...>::deserialize(deserializer);
+					return deserializer.deserialize(static_cast<Structure<Fields...>&>(*this));
 				}
 				else {
 					return reinterpret_cast<ChildType*>(this)->convertFromPreviousVersion(version, deserializer);
 				}
 			}
 		};
+
+		namespace detail {
+			//Structure base of T, so types derived from a Structure can be used where a Structure is expected, void for other types
+			template<typename ... Fields>
+			Structure<Fields...> structureOf(const Structure<Fields...>*);
+
+			void structureOf(const void*);
+		}
 	}
 }
 
@@ -0,0 +1,231 @@
+#ifndef TrackedField_H
+#define TrackedField_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "BaseTypes.h"
+#include "Varint.h"
+#include "Fields.h"
+#include "Structures.h"
+#include "BinarySerialization.h"
+
+namespace Antilatency {
+	namespace Serialization {
+
+		//Field (SingleField, ContainerField...) that remembers whether it was modified since the last clearDirty.
+		//Non-const getValue marks the field dirty, since the caller may change the value through the reference.
+		template<typename T>
+		class TrackedField : public T {
+		public:
+			const typename T::Type& getValue() const {
+				return T::getValue();
+			}
+
+			typename T::Type& getValue() {
+				_isDirty = true;
+				return T::getValue();
+			}
+
+			void setValue(const typename T::Type& value) {
+				T::setValue(value);
+				_isDirty = true;
+			}
+
+			bool isDirty() const {
+				return _isDirty;
+			}
+
+			void markDirty() {
+				_isDirty = true;
+			}
+
+			void clearDirty() {
+				_isDirty = false;
+			}
+
+			template<typename Deserializer>
+			size_t deserialize(Deserializer& deserializer) {
+				_isDirty = true;
+				return T::deserialize(deserializer);
+			}
+
+		private:
+			bool _isDirty = true;
+		};
+
+		template <typename T, typename Name>
+		using TrackedSingleField = TrackedField<SingleField<T, Name>>;
+
+		template <typename T, typename Name>
+		using TrackedContainerField = TrackedField<ContainerField<T, Name>>;
+
+		template <typename T, typename Name>
+		using TrackedVectorField = TrackedField<VectorField<T, Name>>;
+
+		//Bit per field of a structure
+		template<size_t FieldCount>
+		class FieldMask {
+		public:
+			bool test(size_t index) const {
+				return ((_bytes[index / 8] >> (index % 8)) & 1) != 0;
+			}
+
+			void set(size_t index) {
+				_bytes[index / 8] |= static_cast<uint8_t>(1 << (index % 8));
+			}
+
+			size_t count() const {
+				size_t result = 0;
+				for (size_t i = 0; i < FieldCount; ++i) {
+					result += test(i) ? 1 : 0;
+				}
+				return result;
+			}
+
+			bool any() const {
+				for (size_t i = 0; i < sizeof(_bytes); ++i) {
+					if (_bytes[i] != 0) {
+						return true;
+					}
+				}
+				return false;
+			}
+
+		private:
+			uint8_t _bytes[(FieldCount + 7) / 8] = {};
+		};
+
+		namespace detail {
+			//Fields that are not tracked are always dirty
+			template<typename T>
+			bool isFieldDirty(const T&) {
+				return true;
+			}
+
+			template<typename T>
+			bool isFieldDirty(const TrackedField<T>& field) {
+				return field.isDirty();
+			}
+
+			template<typename T>
+			void clearFieldDirty(T&) {
+			}
+
+			template<typename T>
+			void clearFieldDirty(TrackedField<T>& field) {
+				field.clearDirty();
+			}
+
+			template<typename ... Fields, size_t ... I>
+			FieldMask<sizeof...(Fields)> getDirtyMask(const Structure<Fields...>& value, IndexSequence<I...>) {
+				FieldMask<sizeof...(Fields)> mask;
+				const int dummy[] = { (isFieldDirty(value.template getField<I>()) ? mask.set(I) : static_cast<void>(0), 0)... };
+				static_cast<void>(dummy);
+				return mask;
+			}
+
+			template<typename ... Fields, size_t ... I>
+			void clearDirty(Structure<Fields...>& value, IndexSequence<I...>) {
+				const int dummy[] = { (clearFieldDirty(value.template getField<I>()), 0)... };
+				static_cast<void>(dummy);
+			}
+		}
+
+		template<typename ... Fields>
+		FieldMask<sizeof...(Fields)> getDirtyMask(const Structure<Fields...>& value) {
+			return detail::getDirtyMask(value, typename detail::MakeIndexSequence<sizeof...(Fields)>::Type{});
+		}
+
+		template<typename ... Fields>
+		void clearDirty(Structure<Fields...>& value) {
+			detail::clearDirty(value, typename detail::MakeIndexSequence<sizeof...(Fields)>::Type{});
+		}
+
+		//Writes only dirty fields of a structure as a Varint32 count followed by Varint32 field index and field value pairs,
+		//then clears the dirty bits. Untracked fields are always written.
+		template<typename StreamWriter>
+		class BasicDirtyFieldSerializer {
+		public:
+			explicit BasicDirtyFieldSerializer(StreamWriter* writer) :
+				_serializer(writer)
+			{
+			}
+
+			template<typename ... Fields>
+			bool serialize(Structure<Fields...>& value) {
+				auto mask = getDirtyMask(value);
+				if (!_serializer.serialize(Varint32(static_cast<uint32_t>(mask.count())))) {
+					return false;
+				}
+				if (!serializeFields(value, mask, typename detail::MakeIndexSequence<sizeof...(Fields)>::Type{})) {
+					return false;
+				}
+				clearDirty(value);
+				return true;
+			}
+
+		private:
+			template<typename ... Fields, size_t ... I>
+			bool serializeFields(const Structure<Fields...>& value, const FieldMask<sizeof...(Fields)>& mask, detail::IndexSequence<I...>) {
+				bool isOk = true;
+				const int dummy[] = { (isOk = isOk && (!mask.test(I) || (_serializer.serialize(Varint32(I)) && value.template getField<I>().serialize(_serializer))), 0)... };
+				static_cast<void>(dummy);
+				return isOk;
+			}
+
+			BasicBinarySerializer<StreamWriter> _serializer;
+		};
+
+		using DirtyFieldSerializer = BasicDirtyFieldSerializer<IStreamWriter>;
+
+		//Applies fields written by DirtyFieldSerializer, fields that were not sent keep their values
+		template<typename StreamReader>
+		class BasicDirtyFieldDeserializer {
+		public:
+			explicit BasicDirtyFieldDeserializer(StreamReader* reader) :
+				_deserializer(reader)
+			{
+			}
+
+			template<typename ... Fields>
+			bool deserialize(Structure<Fields...>& value) {
+				return deserializeFields(value, typename detail::MakeIndexSequence<sizeof...(Fields)>::Type{});
+			}
+
+		private:
+			using Deserializer = BasicBinaryDeserializer<StreamReader>;
+
+			template<size_t Index, typename ... Fields>
+			static bool deserializeField(Deserializer& deserializer, Structure<Fields...>& value) {
+				return value.template getField<Index>().deserialize(deserializer) != 0;
+			}
+
+			template<typename ... Fields, size_t ... I>
+			bool deserializeFields(Structure<Fields...>& value, detail::IndexSequence<I...>) {
+				using FieldDeserializer = bool(*)(Deserializer&, Structure<Fields...>&);
+				static const FieldDeserializer fieldDeserializers[] = { &deserializeField<I, Fields...>... };
+
+				Varint32 count;
+				if (!_deserializer.deserialize(count) || count.getValue() > sizeof...(Fields)) {
+					return false;
+				}
+				for (uint32_t i = 0; i < count.getValue(); ++i) {
+					Varint32 index;
+					if (!_deserializer.deserialize(index) || index.getValue() >= sizeof...(Fields)) {
+						return false;
+					}
+					if (!fieldDeserializers[index.getValue()](_deserializer, value)) {
+						return false;
+					}
+				}
+				return true;
+			}
+
+			Deserializer _deserializer;
+		};
+
+		using DirtyFieldDeserializer = BasicDirtyFieldDeserializer<IStreamReader>;
+	}
+}
+
+#endif // TrackedField_H
@@ -26,9 +26,11 @@ namespace Antilatency {
 		class UserStreamReader : public IStreamReader {
 		public:
 			using FunctionType = std::function<bool(uint8_t*, size_t)>;
+			using ReadSomeFunctionType = std::function<size_t(uint8_t*, size_t)>;
 
-			explicit UserStreamReader(FunctionType readFunction) :
-				_readFunction(readFunction)
+			explicit UserStreamReader(FunctionType readFunction, ReadSomeFunctionType readSomeFunction = nullptr) :
+				_readFunction(readFunction),
+				_readSomeFunction(readSomeFunction)
 			{
 
 			}
@@ -37,8 +39,16 @@ namespace Antilatency {
 				return _readFunction(buffer, size);
 			}
 
+			size_t readSome(uint8_t* buffer, size_t maxSize) override {
+				if (_readSomeFunction) {
+					return _readSomeFunction(buffer, maxSize);
+				}
+				return IStreamReader::readSome(buffer, maxSize);
+			}
+
 		private:
 			FunctionType _readFunction;
+			ReadSomeFunctionType _readSomeFunction;
 		};
 	}
 }
@@ -2,10 +2,44 @@
 #define Varint_H
 
 #include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "BaseTypes.h"
+
+#if defined(__BMI2__)
+	#include <immintrin.h>
+#endif
 
 namespace Antilatency {
 	namespace Serialization {
 
+		namespace detail {
+			//Signed varints are zigzag encoded so small negative values stay short
+			template<typename T>
+			constexpr T zigzagEncode(T value) {
+				return value;
+			}
+
+			constexpr uint16_t zigzagEncode(int16_t value) {
+				return value < 0 ? static_cast<uint16_t>(~(static_cast<uint16_t>(value) << 1)) : static_cast<uint16_t>(static_cast<uint16_t>(value) << 1);
+			}
+
+			constexpr uint32_t zigzagEncode(int32_t value) {
+				return value < 0 ? ~(static_cast<uint32_t>(value) << 1) : static_cast<uint32_t>(value) << 1;
+			}
+
+			constexpr uint64_t zigzagEncode(int64_t value) {
+				return value < 0 ? ~(static_cast<uint64_t>(value) << 1) : static_cast<uint64_t>(value) << 1;
+			}
+
+			//Inverse of zigzagEncode, unsigned types are kept as is
+			template<typename T>
+			constexpr T zigzagDecode(uint64_t value) {
+				return static_cast<T>(-1) > static_cast<T>(0) ? static_cast<T>(value) : static_cast<T>((value & 1) != 0 ? ~(value >> 1) : value >> 1);
+			}
+		}
+
 		template<typename BaseType>
 		struct Varint {
 			using Type = BaseType;
@@ -31,12 +65,19 @@ namespace Antilatency {
 				_value = value;
 			}
 
+			//Size of the encoded value, signed values are measured after zigzag encoding
 			size_t getActualSize() const {
-				Type value = _value;
+				auto value = static_cast<uint64_t>(detail::zigzagEncode(_value));
+				return (64 - countLeadingZeros(value | 1) + usedBits - 1) / usedBits;
+			}
+
+			//Same as getActualSize, usable in constant expressions
+			static constexpr size_t getEncodedSize(Type value) {
+				auto encoded = static_cast<uint64_t>(detail::zigzagEncode(value));
 				size_t size = 1;
-				while (value >= base) {
+				while (encoded >= base) {
 					++size;
-					value >>= usedBits;
+					encoded >>= usedBits;
 				}
 				return size;
 			}
@@ -64,12 +105,98 @@ namespace Antilatency {
 			static constexpr size_t usedBits = 7;
 			static constexpr size_t base = 1 << usedBits;
 			static constexpr size_t mask = base - 1;
+			static constexpr size_t maxSize = (sizeof(Type) * 8 + usedBits - 1) / usedBits;
 
 
 		private:
 			Type _value = 0;
 		};
 
+		namespace detail {
+			//Decodes a varint from memory, returns the number of bytes used or 0 if data is truncated or too long for T
+			template<typename T>
+			size_t decodeVarint(const uint8_t* data, size_t size, T& value) {
+				using VariantType = Varint<T>;
+		#if UINTPTR_MAX == 0xFFFFFFFFFFFFFFFF
+				//Whole 8-byte window at once: find the terminating byte and compact the 7-bit groups without a loop
+				if (size >= sizeof(uint64_t)) {
+					uint64_t word;
+					memcpy(&word, data, sizeof(word));
+			#if SERIALIZATION_BYTE_ORDER == SERIALIZATION_BIG_ENDIAN
+					word = swapBytes(word);
+			#endif
+					uint64_t stopBits = ~word & 0x8080808080808080ull;
+					if (stopBits != 0) {
+						auto length = countTrailingZeros(stopBits) / 8 + 1;
+						if (length <= VariantType::maxSize) {
+							word &= stopBits ^ (stopBits - 1);
+			#if defined(__BMI2__)
+							uint64_t result = _pext_u64(word, 0x7F7F7F7F7F7F7F7Full);
+			#else
+							uint64_t result =
+								(word & 0x000000000000007Full) |
+								((word & 0x0000000000007F00ull) >> 1) |
+								((word & 0x00000000007F0000ull) >> 2) |
+								((word & 0x000000007F000000ull) >> 3) |
+								((word & 0x0000007F00000000ull) >> 4) |
+								((word & 0x00007F0000000000ull) >> 5) |
+								((word & 0x007F000000000000ull) >> 6) |
+								((word & 0x7F00000000000000ull) >> 7);
+			#endif
+							value = static_cast<T>(result);
+							return length;
+						}
+					}
+				}
+		#endif
+				T result = 0;
+				auto limit = size < VariantType::maxSize ? size : VariantType::maxSize;
+				for (size_t i = 0; i < limit; ++i) {
+					uint8_t sym = data[i];
+					result |= static_cast<T>(sym & VariantType::mask) << (VariantType::usedBits * i);
+					if ((sym & (~VariantType::mask)) == 0) {
+						value = result;
+						return i + 1;
+					}
+				}
+				return 0;
+			}
+		}
+
+		namespace detail {
+			//Writes value as a varint of at most 10 bytes, returns the number of bytes written
+			inline size_t encodeVarint(uint64_t value, uint8_t* data) {
+				size_t size = 0;
+				while (value >= 0x80) {
+					data[size++] = static_cast<uint8_t>(value | 0x80);
+					value >>= 7;
+				}
+				data[size++] = static_cast<uint8_t>(value);
+				return size;
+			}
+
+			//Returns the number of bytes taken by count varints of at most maxSize bytes each, 0 if data is truncated or a varint is too long
+			inline size_t skipVarints(const uint8_t* data, size_t size, size_t count, size_t maxSize) {
+				size_t position = 0;
+				size_t length = 0;
+				while (count > 0) {
+					if (position == size) {
+						return 0;
+					}
+					if (data[position++] & 0x80) {
+						if (++length == maxSize) {
+							return 0;
+						}
+					}
+					else {
+						length = 0;
+						--count;
+					}
+				}
+				return position;
+			}
+		}
+
 		using Varint32 = Varint<uint32_t>;
 		using Varint64 = Varint<uint64_t>;
 	}
@@ -5,6 +5,7 @@
 #include <ctime>
 #include "AntilatencySerialization/BinarySerialization.h"
 #include "AntilatencySerialization/Base64Stream.h"
+#include "AntilatencySerialization/UserStream.h"
 
 using namespace Microsoft::VisualStudio::CppUnitTestFramework;
 
@@ -171,5 +172,85 @@ namespace SerializationTest
 			}
 		}
 
+
+		static std::vector<uint8_t> encode(const std::vector<uint8_t>& data, size_t maxWriteSize) {
+			std::vector<uint8_t> result;
+			UserStreamWriter userWriter([&result](const uint8_t* buffer, size_t size) {
+				result.insert(result.end(), buffer, buffer + size);
+				return true;
+			});
+			Base64StreamWriter writer(&userWriter);
+			size_t offset = 0;
+			while (offset < data.size()) {
+				size_t size = 1 + rand() % maxWriteSize;
+				if (size > data.size() - offset) {
+					size = data.size() - offset;
+				}
+				Assert::IsTrue(writer.write(data.data() + offset, size));
+				offset += size;
+			}
+			Assert::IsTrue(writer.flush());
+			return result;
+		}
+
+		TEST_METHOD(ChunkedWriteRead) {
+			for (auto i = 0; i < 100; ++i) {
+				std::vector<uint8_t> base(rand() % 2048);
+				for (auto& value : base) {
+					value = static_cast<uint8_t>(rand());
+				}
+				auto whole = encode(base, base.size() + 1);
+				auto chunked = encode(base, 7);
+				Assert::IsTrue(whole == chunked);
+
+				MemoryStreamReader memoryReader(whole.data(), whole.size());
+				Base64StreamReader reader(&memoryReader);
+				std::vector<uint8_t> result(base.size());
+				size_t offset = 0;
+				while (offset < result.size()) {
+					size_t size = 1 + rand() % 100;
+					if (size > result.size() - offset) {
+						size = result.size() - offset;
+					}
+					Assert::IsTrue(reader.read(result.data() + offset, size));
+					offset += size;
+				}
+				Assert::IsTrue(base == result);
+			}
+		}
+
+		TEST_METHOD(BlockMatchesGroups) {
+			std::vector<uint8_t> base(3 * 100);
+			for (auto& value : base) {
+				value = static_cast<uint8_t>(rand());
+			}
+			std::vector<uint8_t> block(4 * 100);
+			std::vector<uint8_t> groups(4 * 100);
+			Base64::encodeBlock(Base64::StandardAlphabet, base.data(), 100, block.data());
+			for (size_t i = 0; i < 100; ++i) {
+				Base64::encodeGroup(Base64::StandardAlphabet, base.data() + 3 * i, groups.data() + 4 * i);
+			}
+			Assert::IsTrue(block == groups);
+
+			std::vector<uint8_t> decoded(base.size());
+			Assert::IsTrue(Base64::decodeBlock(Base64::StandardAlphabet, block.data(), 100, decoded.data()));
+			Assert::IsTrue(base == decoded);
+		}
+
+		TEST_METHOD(InvalidSymbol) {
+			std::vector<uint8_t> base(3 * 64);
+			for (auto& value : base) {
+				value = static_cast<uint8_t>(rand());
+			}
+			auto encoded = encode(base, base.size());
+			std::vector<uint8_t> decoded(base.size());
+			for (int sym = 0; sym < 256; ++sym) {
+				bool isValid;
+				Base64::getPositionFromChar(static_cast<char>(sym), isValid);
+				auto broken = encoded;
+				broken[rand() % broken.size()] = static_cast<uint8_t>(sym);
+				Assert::AreEqual(isValid, Base64::decodeBlock(Base64::StandardAlphabet, broken.data(), 64, decoded.data()));
+			}
+		}
 	};
 }
\ No newline at end of file
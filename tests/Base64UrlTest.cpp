@@ -0,0 +1,101 @@
+#include "stdafx.h"
+#include "CppUnitTest.h"
+
+#include <ctime>
+#include <string>
+#include <vector>
+
+#include "AntilatencySerialization/Base64Stream.h"
+#include "AntilatencySerialization/GrowableMemoryStream.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace Antilatency::Serialization;
+
+namespace SerializationTest
+{
+	TEST_CLASS(Base64UrlTest)
+	{
+		TEST_CLASS_INITIALIZE(Init) {
+			srand(static_cast<unsigned>(time(nullptr)));
+		}
+
+		static std::vector<uint8_t> randomData(size_t size) {
+			std::vector<uint8_t> data(size);
+			for (auto& byte : data) {
+				byte = static_cast<uint8_t>(rand());
+			}
+			return data;
+		}
+
+		static std::string encode(const std::vector<uint8_t>& data, const Base64::Alphabet& alphabet, bool usePadding) {
+			GrowableMemoryStreamWriter memoryWriter;
+			Base64StreamWriter writer(&memoryWriter, alphabet, usePadding);
+			Assert::IsTrue(writer.write(data.data(), data.size()));
+			Assert::IsTrue(writer.flush());
+			return std::string(memoryWriter.data(), memoryWriter.data() + memoryWriter.size());
+		}
+
+		static std::string encodeWithConverter(const std::vector<uint8_t>& data) {
+			GrowableMemoryStreamWriter memoryWriter;
+			Base64UrlConverterWriter converter(&memoryWriter);
+			Base64StreamWriter writer(&converter);
+			Assert::IsTrue(writer.write(data.data(), data.size()));
+			Assert::IsTrue(writer.flush());
+			return std::string(memoryWriter.data(), memoryWriter.data() + memoryWriter.size());
+		}
+
+	public:
+		TEST_METHOD(KnownValues) {
+			const uint8_t data[] = { 0xFB, 0xFF, 0xBF, 0xFE };
+			std::vector<uint8_t> vector(data, data + sizeof(data));
+			Assert::IsTrue(std::string("-_-__g") == encode(vector, Base64::UrlAlphabet, false));
+			Assert::IsTrue(std::string("-_-__g==") == encode(vector, Base64::UrlAlphabet, true));
+			Assert::IsTrue(std::string("+/+//g==") == encode(vector, Base64::StandardAlphabet, true));
+			Assert::IsTrue(std::string("+/+//g") == encode(vector, Base64::StandardAlphabet, false));
+		}
+
+		TEST_METHOD(MatchesConverter) {
+			for (size_t size = 0; size < 1000; size += 1 + size / 8) {
+				auto data = randomData(size);
+				Assert::IsTrue(encodeWithConverter(data) == encode(data, Base64::UrlAlphabet, false));
+			}
+		}
+
+		TEST_METHOD(UnpaddedRoundTrip) {
+			for (size_t size = 0; size < 1000; size += 1 + size / 8) {
+				auto data = randomData(size);
+				auto encoded = encode(data, Base64::UrlAlphabet, false);
+				Assert::IsTrue(encoded.find_first_of("+/=") == std::string::npos);
+
+				std::vector<uint8_t> decoded(size);
+				MemoryStreamReader memoryReader(reinterpret_cast<const uint8_t*>(encoded.data()), encoded.size());
+				Base64StreamReader reader(&memoryReader, Base64::UrlAlphabet);
+				Assert::IsTrue(reader.read(decoded.data(), decoded.size()));
+				Assert::IsTrue(data == decoded);
+
+				uint8_t extra;
+				Assert::IsFalse(reader.read(&extra, 1));
+			}
+		}
+
+		TEST_METHOD(ConverterReaderMatchesUrlAlphabet) {
+			auto data = randomData(777);
+			auto encoded = encode(data, Base64::UrlAlphabet, false);
+
+			std::vector<uint8_t> decoded(data.size());
+			MemoryStreamReader memoryReader(reinterpret_cast<const uint8_t*>(encoded.data()), encoded.size());
+			Base64UrlConverterReader converter(&memoryReader);
+			Base64StreamReader reader(&converter);
+			Assert::IsTrue(reader.read(decoded.data(), decoded.size()));
+			Assert::IsTrue(data == decoded);
+		}
+
+		TEST_METHOD(StandardSymbolsRejectedByUrlAlphabet) {
+			const char encoded[] = "+/+/";
+			uint8_t decoded[3];
+			MemoryStreamReader memoryReader(reinterpret_cast<const uint8_t*>(encoded), 4);
+			Base64StreamReader reader(&memoryReader, Base64::UrlAlphabet);
+			Assert::IsFalse(reader.read(decoded, sizeof(decoded)));
+		}
+	};
+}
@@ -0,0 +1,108 @@
+#include "stdafx.h"
+#include "CppUnitTest.h"
+
+#include <ctime>
+#include <vector>
+#include "AntilatencySerialization/Fields.h"
+#include "AntilatencySerialization/Structures.h"
+#include "AntilatencySerialization/BinarySerialization.h"
+#include "AntilatencySerialization/BinaryValidator.h"
+#include "AntilatencySerialization/GrowableMemoryStream.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+using namespace Antilatency::Serialization;
+
+namespace SerializationTest
+{
+	namespace BinaryValidatorTestTypes {
+		SERIALIZATION_MAKE_FIELD_NAME(Id);
+		SERIALIZATION_MAKE_FIELD_NAME(Name);
+		SERIALIZATION_MAKE_FIELD_NAME(Samples);
+		SERIALIZATION_MAKE_FIELD_NAME(Tags);
+		SERIALIZATION_MAKE_FIELD_NAME(Extra);
+
+		class Message : public VersionedStructure<1, Message,
+			SingleField<Varint<int64_t>, Id>,
+			StringField<Name>,
+			VectorField<Varint32, Samples>,
+			VectorField<BaseStringType, Tags>,
+			OptioinalField<VectorField<float, Extra>>
+		> {
+		public:
+			template<typename Deserializer>
+			bool convertFromPreviousVersion(VersionType, Deserializer&) {
+				return false;
+			}
+		};
+	}
+
+	using namespace BinaryValidatorTestTypes;
+
+	TEST_CLASS(BinaryValidatorTest)
+	{
+		TEST_CLASS_INITIALIZE(Init) {
+			srand(static_cast<unsigned>(time(nullptr)));
+		}
+
+		static Message makeMessage() {
+			Message message;
+			message.get<Id>().setValue(Varint<int64_t>(rand() - RAND_MAX / 2));
+			message.get<Name>().setValue(BaseStringType(rand() % 20, 'x'));
+			for (int i = rand() % 50; i > 0; --i) {
+				message.get<Samples>().getValue().push_back(Varint32(static_cast<uint32_t>(rand()) << (rand() % 16)));
+			}
+			message.get<Tags>().getValue().resize(rand() % 5, "tag");
+			if (rand() % 2) {
+				message.get<Extra>().setValue(BaseVectorType<float>(rand() % 10, 1.0f));
+			}
+			return message;
+		}
+
+	public:
+		TEST_METHOD(FindBoundaries) {
+			GrowableMemoryStreamWriter writer;
+			BinarySerializer serializer(&writer);
+			std::vector<size_t> boundaries;
+			for (int i = 0; i < 100; ++i) {
+				Assert::IsTrue(serializer.serialize(makeMessage()));
+				boundaries.push_back(writer.size());
+			}
+
+			BinaryValidator validator(writer.data(), writer.size());
+			for (auto boundary : boundaries) {
+				Assert::AreNotEqual(static_cast<size_t>(0), validator.validate<Message>());
+				Assert::AreEqual(boundary, validator.getPosition());
+			}
+			Assert::AreEqual(static_cast<size_t>(0), validator.getRemainingSize());
+			Assert::AreEqual(static_cast<size_t>(0), validator.validate<Message>());
+		}
+
+		TEST_METHOD(RejectTruncated) {
+			GrowableMemoryStreamWriter writer;
+			BinarySerializer serializer(&writer);
+			auto message = makeMessage();
+			Assert::IsTrue(serializer.serialize(message));
+			auto size = writer.size();
+
+			for (size_t truncatedSize = 0; truncatedSize < size; ++truncatedSize) {
+				BinaryValidator validator(writer.data(), truncatedSize);
+				Assert::AreEqual(static_cast<size_t>(0), validator.validate<Message>());
+				Assert::AreEqual(static_cast<size_t>(0), validator.getPosition());
+			}
+			BinaryValidator validator(writer.data(), size);
+			Assert::AreEqual(size, validator.validate<Message>());
+		}
+
+		TEST_METHOD(RejectHugeCount) {
+			//Version, Id, empty Name, then Samples claiming 2^40 items
+			const uint8_t data[] = { 1, 0, 0, 0x80, 0x80, 0x80, 0x80, 0x80, 0x20, 1, 2, 3 };
+			BinaryValidator validator(data, sizeof(data));
+			Assert::AreEqual(static_cast<size_t>(0), validator.validate<Message>());
+
+			const uint8_t overlong[] = { 1, 0x80, 0x80, 0x80, 0x80, 0x80, 0 };
+			BinaryValidator samplesValidator(overlong, sizeof(overlong));
+			Assert::AreEqual(static_cast<size_t>(0), samplesValidator.validate<BaseVectorType<Varint32>>());
+		}
+	};
+}
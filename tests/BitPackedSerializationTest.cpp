@@ -0,0 +1,206 @@
+#include "stdafx.h"
+#include "CppUnitTest.h"
+
+#include <ctime>
+#include <vector>
+#include "AntilatencySerialization/Fields.h"
+#include "AntilatencySerialization/Structures.h"
+#include "AntilatencySerialization/BinarySerialization.h"
+#include "AntilatencySerialization/BitPackedSerialization.h"
+#include "AntilatencySerialization/GrowableMemoryStream.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+using namespace Antilatency::Serialization;
+
+namespace SerializationTest
+{
+	namespace BitPackedTestTypes {
+		SERIALIZATION_MAKE_FIELD_NAME(IsTracking);
+		SERIALIZATION_MAKE_FIELD_NAME(IsStable);
+		SERIALIZATION_MAKE_FIELD_NAME(Stage);
+		SERIALIZATION_MAKE_FIELD_NAME(Quality);
+		SERIALIZATION_MAKE_FIELD_NAME(Offset);
+		SERIALIZATION_MAKE_FIELD_NAME(Frame);
+		SERIALIZATION_MAKE_FIELD_NAME(Marker);
+
+		using Packet = Structure<
+			SingleField<bool, IsTracking>,
+			SingleField<bool, IsStable>,
+			BitsField<3, Stage>,
+			RangeField<uint8_t, 0, 100, Quality>,
+			RangeField<int16_t, -8, 7, Offset>,
+			SingleField<Varint32, Frame>,
+			OptioinalField<BitsField<5, Marker>>
+		>;
+	}
+
+	using namespace BitPackedTestTypes;
+
+	TEST_CLASS(BitPackedSerializationTest)
+	{
+		TEST_CLASS_INITIALIZE(Init) {
+			srand(static_cast<unsigned>(time(nullptr)));
+		}
+
+		template<typename T>
+		static std::vector<uint8_t> serialize(const T& value) {
+			GrowableMemoryStreamWriter writer;
+			BitPackedSerializer serializer(&writer);
+			Assert::IsTrue(serializer.serialize(value));
+			Assert::IsTrue(serializer.flush());
+			return std::vector<uint8_t>(writer.data(), writer.data() + writer.size());
+		}
+
+		static Packet makePacket() {
+			Packet packet;
+			packet.get<IsTracking>().setValue(true);
+			packet.get<IsStable>().setValue(false);
+			packet.get<Stage>().setValue(5);
+			packet.get<Quality>().setValue(99);
+			packet.get<Offset>().setValue(-3);
+			packet.get<Frame>().setValue(Varint32(300));
+			packet.get<Marker>().setValue(17);
+			return packet;
+		}
+
+	public:
+		TEST_METHOD(FieldWidths) {
+			static_assert(BitsField<3, Stage>::BitCount == 3, "Wrong width");
+			static_assert(RangeField<uint8_t, 0, 100, Quality>::BitCount == 7, "Wrong width");
+			static_assert(RangeField<int16_t, -8, 7, Offset>::BitCount == 4, "Wrong width");
+			static_assert(RangeField<int32_t, 5, 5, Offset>::BitCount == 0, "Wrong width");
+			static_assert(sizeof(BitsField<9, Stage>::Type) == 2, "Wrong value type");
+
+			//1 + 1 + 3 + 7 + 4 + 16 (varint 300) + 1 + 5 bits
+			auto buffer = serialize(makePacket());
+			Assert::AreEqual(static_cast<size_t>(5), buffer.size());
+		}
+
+		TEST_METHOD(RoundTrip) {
+			auto buffer = serialize(makePacket());
+			Packet dest;
+			MemoryStreamReader reader(buffer.data(), buffer.size());
+			BitPackedDeserializer deserializer(&reader);
+			Assert::IsTrue(deserializer.deserialize(dest));
+			deserializer.align();
+			Assert::AreEqual(buffer.size(), reader.getPosition());
+
+			Assert::IsTrue(dest.get<IsTracking>().getValue());
+			Assert::IsFalse(dest.get<IsStable>().getValue());
+			Assert::AreEqual(5, static_cast<int>(dest.get<Stage>().getValue()));
+			Assert::AreEqual(99, static_cast<int>(dest.get<Quality>().getValue()));
+			Assert::AreEqual(-3, static_cast<int>(dest.get<Offset>().getValue()));
+			Assert::AreEqual(300u, dest.get<Frame>().getValue().getValue());
+			Assert::AreEqual(17, static_cast<int>(dest.get<Marker>().getValue()));
+		}
+
+		TEST_METHOD(WordBoundaries) {
+			GrowableMemoryStreamWriter writer;
+			BitPackedSerializer serializer(&writer);
+			std::vector<uint64_t> values;
+			std::vector<unsigned> widths;
+			for (int i = 0; i < 200; ++i) {
+				unsigned width = 1 + rand() % 64;
+				uint64_t value = (static_cast<uint64_t>(rand()) << 40) ^ (static_cast<uint64_t>(rand()) << 20) ^ static_cast<uint64_t>(rand());
+				value &= ~static_cast<uint64_t>(0) >> (64 - width);
+				values.push_back(value);
+				widths.push_back(width);
+				Assert::IsTrue(serializer.serializeBits(value, width));
+			}
+			Assert::IsTrue(serializer.serialize(static_cast<int64_t>(-1234567890123ll)));
+			Assert::IsTrue(serializer.serialize(Varint<int64_t>(-5)));
+			Assert::IsTrue(serializer.serialize(2.5f));
+			Assert::IsTrue(serializer.flush());
+
+			MemoryStreamReader reader(writer.data(), writer.size());
+			BitPackedDeserializer deserializer(&reader);
+			for (size_t i = 0; i < values.size(); ++i) {
+				uint64_t value;
+				Assert::IsTrue(deserializer.deserializeBits(value, widths[i]));
+				Assert::IsTrue(values[i] == value);
+			}
+			int64_t integer;
+			Varint<int64_t> varint;
+			float real;
+			Assert::IsTrue(deserializer.deserialize(integer));
+			Assert::IsTrue(deserializer.deserialize(varint));
+			Assert::IsTrue(deserializer.deserialize(real));
+			Assert::IsTrue(integer == static_cast<int64_t>(-1234567890123ll));
+			Assert::IsTrue(varint.getValue() == -5);
+			Assert::AreEqual(2.5f, real);
+			Assert::AreEqual(writer.size(), reader.getPosition());
+		}
+
+		TEST_METHOD(Containers) {
+			BaseVectorType<uint16_t> samples;
+			for (int i = 0; i < 100; ++i) {
+				samples.push_back(static_cast<uint16_t>(rand()));
+			}
+			BaseStringType text = "packed";
+			GrowableMemoryStreamWriter writer;
+			BitPackedSerializer serializer(&writer);
+			Assert::IsTrue(serializer.serialize(true));
+			Assert::IsTrue(serializer.serialize(samples));
+			Assert::IsTrue(serializer.serialize(text));
+			Assert::IsTrue(serializer.flush());
+
+			bool flag;
+			BaseVectorType<uint16_t> destSamples;
+			BaseStringType destText;
+			MemoryStreamReader reader(writer.data(), writer.size());
+			BitPackedDeserializer deserializer(&reader);
+			Assert::IsTrue(deserializer.deserialize(flag));
+			Assert::IsTrue(deserializer.deserialize(destSamples));
+			Assert::IsTrue(deserializer.deserialize(destText));
+			Assert::IsTrue(flag);
+			Assert::IsTrue(samples == destSamples);
+			Assert::IsTrue(text == destText);
+		}
+
+		TEST_METHOD(OutOfRange) {
+			GrowableMemoryStreamWriter writer;
+			BitPackedSerializer serializer(&writer);
+			Assert::IsTrue(serializer.serializeBits(127, 7));
+			Assert::IsTrue(serializer.flush());
+
+			RangeField<uint8_t, 0, 100, Quality> quality;
+			MemoryStreamReader reader(writer.data(), writer.size());
+			BitPackedDeserializer deserializer(&reader);
+			Assert::IsFalse(deserializer.deserialize(quality));
+
+			uint8_t byte = 200;
+			MemoryStreamReader binaryReader(&byte, 1);
+			BinaryDeserializer binaryDeserializer(&binaryReader);
+			Assert::IsFalse(binaryDeserializer.deserialize(quality));
+		}
+
+		TEST_METHOD(ByteSerializerFallback) {
+			auto packet = makePacket();
+			GrowableMemoryStreamWriter writer;
+			BinarySerializer serializer(&writer);
+			Assert::IsTrue(serializer.serialize(packet));
+
+			Packet dest;
+			MemoryStreamReader reader(writer.data(), writer.size());
+			BinaryDeserializer deserializer(&reader);
+			Assert::IsTrue(deserializer.deserialize(dest));
+			Assert::AreEqual(5, static_cast<int>(dest.get<Stage>().getValue()));
+			Assert::AreEqual(-3, static_cast<int>(dest.get<Offset>().getValue()));
+			Assert::AreEqual(17, static_cast<int>(dest.get<Marker>().getValue()));
+
+			MemoryStreamReader skipReader(writer.data(), writer.size());
+			BinaryDeserializer skipDeserializer(&skipReader);
+			Assert::IsTrue(skipDeserializer.skip<Packet>());
+			Assert::AreEqual(writer.size(), skipReader.getPosition());
+		}
+
+		TEST_METHOD(Truncated) {
+			auto buffer = serialize(makePacket());
+			Packet dest;
+			MemoryStreamReader reader(buffer.data(), buffer.size() - 1);
+			BitPackedDeserializer deserializer(&reader);
+			Assert::IsFalse(deserializer.deserialize(dest));
+		}
+	};
+}
@@ -0,0 +1,113 @@
+#include "stdafx.h"
+#include "CppUnitTest.h"
+#include <array>
+
+#include <ctime>
+#include <vector>
+#include "AntilatencySerialization/BinarySerialization.h"
+#include "AntilatencySerialization/BufferedStream.h"
+#include "AntilatencySerialization/UserStream.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+using namespace Antilatency::Serialization;
+
+namespace SerializationTest
+{
+	TEST_CLASS(BufferedStreamTest)
+	{
+		TEST_CLASS_INITIALIZE(Init) {
+			srand(static_cast<unsigned>(time(nullptr)));
+		}
+
+	public:
+		static std::vector<uint32_t> makeValues(size_t count) {
+			std::vector<uint32_t> values;
+			for (size_t i = 0; i < count; ++i) {
+				values.push_back(static_cast<uint32_t>(rand()) >> (rand() % 32));
+			}
+			return values;
+		}
+
+		TEST_METHOD(CoalesceWrites) {
+			std::vector<uint8_t> data;
+			size_t writeCount = 0;
+			UserStreamWriter userWriter([&data, &writeCount](const uint8_t* buffer, size_t size) {
+				data.insert(data.end(), buffer, buffer + size);
+				++writeCount;
+				return true;
+			});
+
+			auto values = makeValues(1000);
+			BufferedStreamWriter bufferedWriter(&userWriter, 256);
+			BinarySerializer serializer(&bufferedWriter);
+			for (auto value : values) {
+				Assert::IsTrue(serializer.serialize(Varint32(value)));
+			}
+			Assert::IsTrue(bufferedWriter.flush());
+			Assert::AreEqual(static_cast<size_t>(0), bufferedWriter.getBufferedSize());
+			Assert::IsTrue(writeCount <= data.size() / (256 - Varint32::maxSize) + 1);
+
+			MemoryStreamReader reader(data.data(), data.size());
+			BinaryDeserializer deserializer(&reader);
+			for (auto value : values) {
+				Varint32 dest;
+				Assert::IsTrue(deserializer.deserialize(dest));
+				Assert::AreEqual(value, dest.getValue());
+			}
+		}
+
+		TEST_METHOD(LargeWritePassThrough) {
+			std::vector<uint8_t> data;
+			UserStreamWriter userWriter([&data](const uint8_t* buffer, size_t size) {
+				data.insert(data.end(), buffer, buffer + size);
+				return true;
+			});
+
+			BufferedStreamWriter bufferedWriter(&userWriter, 16);
+			std::vector<uint8_t> source(100);
+			for (size_t i = 0; i < source.size(); ++i) {
+				source[i] = static_cast<uint8_t>(i);
+			}
+			IStreamWriter* iWriter = &bufferedWriter;
+			Assert::IsTrue(iWriter->write(source.data(), 3));
+			Assert::IsTrue(iWriter->write(source.data() + 3, source.size() - 3));
+			Assert::IsTrue(bufferedWriter.flush());
+			Assert::IsTrue(source == data);
+		}
+
+		TEST_METHOD(BulkRefill) {
+			auto values = makeValues(1000);
+			MemorySizeCounterStream counterStream;
+			BinarySerializer counter(&counterStream);
+			Assert::IsTrue(counter.serialize(values));
+
+			std::vector<uint8_t> data(counterStream.getActualSize());
+			MemoryStreamWriter writer(data.data(), data.size());
+			BinarySerializer serializer(&writer);
+			Assert::IsTrue(serializer.serialize(values));
+
+			MemoryStreamReader memoryReader(data.data(), data.size());
+			size_t readCount = 0;
+			UserStreamReader userReader(
+				[&memoryReader, &readCount](uint8_t* buffer, size_t size) {
+					++readCount;
+					return memoryReader.read(buffer, size);
+				},
+				[&memoryReader, &readCount](uint8_t* buffer, size_t maxSize) {
+					++readCount;
+					return memoryReader.readSome(buffer, maxSize);
+				});
+
+			BufferedStreamReader bufferedReader(&userReader, 128);
+			BinaryDeserializer deserializer(&bufferedReader);
+			std::vector<uint32_t> dest;
+			Assert::IsTrue(deserializer.deserialize(dest));
+			Assert::IsTrue(values == dest);
+			Assert::IsTrue(readCount <= data.size() / 128 + 2);
+
+			uint8_t extra;
+			Assert::IsFalse(deserializer.deserialize(extra));
+		}
+	};
+}
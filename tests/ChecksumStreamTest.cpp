@@ -0,0 +1,148 @@
+#include "stdafx.h"
+#include "CppUnitTest.h"
+
+#include <ctime>
+#include <vector>
+#include "AntilatencySerialization/Fields.h"
+#include "AntilatencySerialization/Structures.h"
+#include "AntilatencySerialization/BinarySerialization.h"
+#include "AntilatencySerialization/BufferedStream.h"
+#include "AntilatencySerialization/ChecksumStream.h"
+#include "AntilatencySerialization/GrowableMemoryStream.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+using namespace Antilatency::Serialization;
+
+namespace SerializationTest
+{
+	namespace ChecksumStreamTestTypes {
+		SERIALIZATION_MAKE_FIELD_NAME(Id);
+		SERIALIZATION_MAKE_FIELD_NAME(Name);
+		SERIALIZATION_MAKE_FIELD_NAME(Values);
+
+		using Message = Structure<
+			SingleField<uint32_t, Id>,
+			StringField<Name>,
+			VectorField<int32_t, Values>
+		>;
+	}
+
+	using namespace ChecksumStreamTestTypes;
+
+	TEST_CLASS(ChecksumStreamTest)
+	{
+		TEST_CLASS_INITIALIZE(Init) {
+			srand(static_cast<unsigned>(time(nullptr)));
+		}
+
+		static Message makeMessage(uint32_t id) {
+			Message message;
+			message.get<Id>().setValue(id);
+			message.get<Name>().setValue("message");
+			for (int i = 0; i < rand() % 100; ++i) {
+				message.get<Values>().getValue().push_back(rand());
+			}
+			return message;
+		}
+
+		//Each message followed by its checksum
+		static std::vector<uint8_t> write(const std::vector<Message>& messages) {
+			GrowableMemoryStreamWriter writer;
+			ChecksumStreamWriter checksumWriter(&writer);
+			BufferedStreamWriter bufferedWriter(&checksumWriter, 64);
+			BinarySerializer serializer(&bufferedWriter);
+			for (auto& message : messages) {
+				Assert::IsTrue(serializer.serialize(message));
+				Assert::IsTrue(bufferedWriter.flush());
+				Assert::IsTrue(checksumWriter.finish());
+			}
+			return std::vector<uint8_t>(writer.data(), writer.data() + writer.size());
+		}
+
+		//Counts the messages that deserialize and verify, stops at the first that does not
+		template<typename Reader>
+		static size_t read(Reader& source, const std::vector<Message>& messages) {
+			ChecksumStreamReader reader(&source);
+			BinaryDeserializer deserializer(&reader);
+			for (size_t i = 0; i < messages.size(); ++i) {
+				Message dest;
+				if (!deserializer.deserialize(dest) || !reader.verify()) {
+					return i;
+				}
+				Assert::AreEqual(messages[i].get<Id>().getValue(), dest.get<Id>().getValue());
+				Assert::IsTrue(messages[i].get<Values>().getValue() == dest.get<Values>().getValue());
+			}
+			return messages.size();
+		}
+
+	public:
+		TEST_METHOD(KnownValues) {
+			const char* digits = "123456789";
+			Assert::AreEqual(0xE3069283u, Crc32c::compute(reinterpret_cast<const uint8_t*>(digits), 9));
+			//RFC 3720 B.4
+			uint8_t data[32];
+			memset(data, 0, sizeof(data));
+			Assert::AreEqual(0x8A9136AAu, Crc32c::compute(data, sizeof(data)));
+			memset(data, 0xFF, sizeof(data));
+			Assert::AreEqual(0x62A8AB43u, Crc32c::compute(data, sizeof(data)));
+			for (uint8_t i = 0; i < 32; ++i) {
+				data[i] = i;
+			}
+			Assert::AreEqual(0x46DD794Eu, Crc32c::compute(data, sizeof(data)));
+			Assert::AreEqual(0u, Crc32c::compute(data, 0));
+		}
+
+		TEST_METHOD(InstructionsMatchTable) {
+			std::vector<uint8_t> data(1000);
+			for (auto& item : data) {
+				item = static_cast<uint8_t>(rand());
+			}
+			for (size_t size = 0; size < 40; ++size) {
+				for (size_t offset = 0; offset < 8; ++offset) {
+					Assert::AreEqual(Crc32c::updateTable(Crc32c::Initial, data.data() + offset, size), Crc32c::update(Crc32c::Initial, data.data() + offset, size));
+				}
+			}
+			//Split anywhere, same result
+			auto whole = Crc32c::update(Crc32c::Initial, data.data(), data.size());
+			for (int i = 0; i < 20; ++i) {
+				size_t split = rand() % data.size();
+				auto crc = Crc32c::update(Crc32c::Initial, data.data(), split);
+				Assert::AreEqual(whole, Crc32c::update(crc, data.data() + split, data.size() - split));
+			}
+		}
+
+		TEST_METHOD(RoundTrip) {
+			std::vector<Message> messages;
+			for (uint32_t i = 0; i < 50; ++i) {
+				messages.push_back(makeMessage(i));
+			}
+			auto data = write(messages);
+
+			//Memory backed, checksummed through peek and skip
+			MemoryStreamReader memoryReader(data.data(), data.size());
+			Assert::AreEqual(messages.size(), read(memoryReader, messages));
+			Assert::AreEqual(data.size(), memoryReader.getPosition());
+
+			//Not memory backed, checksummed through read
+			MemoryStreamReader source(data.data(), data.size());
+			BufferedStreamReader bufferedReader(&source, 16);
+			Assert::AreEqual(messages.size(), read(bufferedReader, messages));
+		}
+
+		TEST_METHOD(DetectsCorruption) {
+			std::vector<Message> messages;
+			for (uint32_t i = 0; i < 10; ++i) {
+				messages.push_back(makeMessage(i));
+			}
+			auto data = write(messages);
+			for (int i = 0; i < 200; ++i) {
+				auto damaged = data;
+				auto position = rand() % damaged.size();
+				damaged[position] ^= static_cast<uint8_t>(1 << (rand() % 8));
+				MemoryStreamReader reader(damaged.data(), damaged.size());
+				Assert::IsTrue(read(reader, messages) < messages.size());
+			}
+		}
+	};
+}
@@ -0,0 +1,219 @@
+#include "stdafx.h"
+#include "CppUnitTest.h"
+
+#include <ctime>
+#include <vector>
+#include "AntilatencySerialization/Fields.h"
+#include "AntilatencySerialization/Structures.h"
+#include "AntilatencySerialization/BinarySerialization.h"
+#include "AntilatencySerialization/ColumnarVectorField.h"
+#include "AntilatencySerialization/SizeCalculator.h"
+#include "AntilatencySerialization/GrowableMemoryStream.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+using namespace Antilatency::Serialization;
+
+namespace SerializationTest
+{
+	namespace ColumnarTestTypes {
+		SERIALIZATION_MAKE_FIELD_NAME(PositionX);
+		SERIALIZATION_MAKE_FIELD_NAME(PositionY);
+		SERIALIZATION_MAKE_FIELD_NAME(Direction);
+		SERIALIZATION_MAKE_FIELD_NAME(Weight);
+		SERIALIZATION_MAKE_FIELD_NAME(Bars);
+
+		using Bar = Structure<
+			Int32Field<PositionX>,
+			Int32Field<PositionY>,
+			SingleField<uint16_t, Direction>,
+			SingleField<float, Weight>
+		>;
+
+		class DerivedBar : public Bar {
+		};
+
+		using Columnar = Structure<ColumnarVectorField<Bar, Bars>>;
+		using RowWise = Structure<VectorField<Bar, Bars>>;
+	}
+
+	using namespace ColumnarTestTypes;
+
+	TEST_CLASS(ColumnarVectorFieldTest)
+	{
+		TEST_CLASS_INITIALIZE(Init) {
+			srand(static_cast<unsigned>(time(nullptr)));
+		}
+
+		template<typename T>
+		static std::vector<uint8_t> serialize(const T& value) {
+			GrowableMemoryStreamWriter writer;
+			BinarySerializer serializer(&writer);
+			Assert::IsTrue(serializer.serialize(value));
+			return std::vector<uint8_t>(writer.data(), writer.data() + writer.size());
+		}
+
+		static BaseVectorType<Bar> makeBars(size_t count) {
+			BaseVectorType<Bar> bars(count);
+			for (size_t i = 0; i < count; ++i) {
+				bars[i].get<PositionX>().setValue(1000 + 3 * static_cast<int32_t>(i) - rand() % 3);
+				bars[i].get<PositionY>().setValue(-7);
+				bars[i].get<Direction>().setValue(static_cast<uint16_t>(rand()));
+				bars[i].get<Weight>().setValue(static_cast<float>(rand()) / 7.0f);
+			}
+			return bars;
+		}
+
+		static bool equal(const Bar& a, const Bar& b) {
+			return a.get<PositionX>().getValue() == b.get<PositionX>().getValue() &&
+				a.get<PositionY>().getValue() == b.get<PositionY>().getValue() &&
+				a.get<Direction>().getValue() == b.get<Direction>().getValue() &&
+				a.get<Weight>().getValue() == b.get<Weight>().getValue();
+		}
+
+	public:
+		TEST_METHOD(Layout) {
+			Columnar value;
+			auto& bars = value.get<Bars>().getValue();
+			bars.resize(2);
+			bars[0].get<PositionX>().setValue(10);
+			bars[1].get<PositionX>().setValue(12);
+			bars[0].get<PositionY>().setValue(5);
+			bars[1].get<PositionY>().setValue(5);
+			bars[0].get<Direction>().setValue(0x0201);
+			bars[1].get<Direction>().setValue(0x0403);
+			bars[0].get<Weight>().setValue(1.0f);
+			bars[1].get<Weight>().setValue(1.0f);
+			const uint8_t expected[] = {
+				2,
+				2, 2, 20, 4,
+				1, 5, 0, 0, 0,
+				0, 2, 1, 2, 3, 4,
+				1, 0x00, 0x00, 0x80, 0x3F
+			};
+			auto buffer = serialize(value);
+			Assert::IsTrue(buffer == std::vector<uint8_t>(expected, expected + sizeof(expected)));
+		}
+
+		TEST_METHOD(RoundTrip) {
+			Columnar value;
+			value.get<Bars>().setValue(makeBars(500));
+			auto buffer = serialize(value);
+			Assert::AreEqual(buffer.size(), getSerializedSize(value));
+
+			RowWise rowWise;
+			rowWise.get<Bars>().setValue(value.get<Bars>().getValue());
+			Assert::IsTrue(buffer.size() < serialize(rowWise).size() * 2 / 3);
+
+			Columnar dest;
+			MemoryStreamReader reader(buffer.data(), buffer.size());
+			BinaryDeserializer deserializer(&reader);
+			Assert::IsTrue(deserializer.deserialize(dest));
+			Assert::AreEqual(buffer.size(), reader.getPosition());
+			Assert::AreEqual(static_cast<size_t>(500), dest.get<Bars>().getValue().size());
+			for (size_t i = 0; i < 500; ++i) {
+				Assert::IsTrue(equal(value.get<Bars>().getValue()[i], dest.get<Bars>().getValue()[i]));
+			}
+
+			MemoryStreamReader skipReader(buffer.data(), buffer.size());
+			BinaryDeserializer skipDeserializer(&skipReader);
+			Assert::IsTrue(skipDeserializer.skip<Columnar>());
+			Assert::AreEqual(buffer.size(), skipReader.getPosition());
+		}
+
+		TEST_METHOD(WrappingDeltas) {
+			using Extremes = Structure<SingleField<int64_t, PositionX>, SingleField<uint8_t, PositionY>>;
+			ColumnarVectorField<Extremes, Bars> value;
+			const int64_t xs[] = { INT64_MIN, INT64_MAX, 0, -1, INT64_MIN };
+			const uint8_t ys[] = { 0, 255, 1, 254, 0 };
+			for (size_t i = 0; i < 40; ++i) {
+				Extremes row;
+				row.get<PositionX>().setValue(i < 5 ? xs[i] : static_cast<int64_t>(i));
+				row.get<PositionY>().setValue(i < 5 ? ys[i] : static_cast<uint8_t>(i));
+				value.getValue().push_back(row);
+			}
+			auto buffer = serialize(value);
+			ColumnarVectorField<Extremes, Bars> dest;
+			MemoryStreamReader reader(buffer.data(), buffer.size());
+			BinaryDeserializer deserializer(&reader);
+			Assert::IsTrue(deserializer.deserialize(dest));
+			for (size_t i = 0; i < 40; ++i) {
+				Assert::IsTrue(value.getValue()[i].get<PositionX>().getValue() == dest.getValue()[i].get<PositionX>().getValue());
+				Assert::AreEqual(value.getValue()[i].get<PositionY>().getValue(), dest.getValue()[i].get<PositionY>().getValue());
+			}
+		}
+
+		TEST_METHOD(DerivedRows) {
+			ColumnarVectorField<DerivedBar, Bars> value;
+			value.getValue().resize(3);
+			value.getValue()[2].get<PositionX>().setValue(42);
+			auto buffer = serialize(value);
+			ColumnarVectorField<DerivedBar, Bars> dest;
+			MemoryStreamReader reader(buffer.data(), buffer.size());
+			BinaryDeserializer deserializer(&reader);
+			Assert::IsTrue(deserializer.deserialize(dest));
+			Assert::AreEqual(42, dest.getValue()[2].get<PositionX>().getValue());
+		}
+
+		TEST_METHOD(Broken) {
+			Columnar value;
+			value.get<Bars>().setValue(makeBars(20));
+			auto buffer = serialize(value);
+
+			auto wrongCount = buffer;
+			wrongCount[0] = 21;
+			Columnar dest;
+			MemoryStreamReader reader(wrongCount.data(), wrongCount.size());
+			BinaryDeserializer deserializer(&reader);
+			Assert::IsFalse(deserializer.deserialize(dest));
+
+			auto wrongEncoding = buffer;
+			wrongEncoding[1] = 7;
+			MemoryStreamReader encodingReader(wrongEncoding.data(), wrongEncoding.size());
+			BinaryDeserializer encodingDeserializer(&encodingReader);
+			Assert::IsFalse(encodingDeserializer.deserialize(dest));
+
+			MemoryStreamReader truncatedReader(buffer.data(), buffer.size() - 1);
+			BinaryDeserializer truncatedDeserializer(&truncatedReader);
+			Assert::IsFalse(truncatedDeserializer.deserialize(dest));
+		}
+
+		TEST_METHOD(ConstantRowLimit) {
+			using LimitedField = ColumnarVectorField<Bar, Bars, 16>;
+			for (size_t count : { 16, 17, 100 }) {
+				LimitedField value;
+				value.getValue().resize(count);
+				auto buffer = serialize(value);
+				//Count, then PositionX as Delta once the limit is passed
+				Assert::AreEqual(static_cast<uint8_t>(count <= 16 ? ColumnEncoding::Constant : ColumnEncoding::Delta), buffer[1]);
+				LimitedField dest;
+				MemoryStreamReader reader(buffer.data(), buffer.size());
+				BinaryDeserializer deserializer(&reader);
+				Assert::IsTrue(deserializer.deserialize(dest));
+				Assert::AreEqual(count, dest.getValue().size());
+			}
+
+			//A few bytes must not make the reader allocate the rows they claim
+			GrowableMemoryStreamWriter writer;
+			BinarySerializer serializer(&writer);
+			Assert::IsTrue(serializer.serialize(Varint64(static_cast<uint64_t>(1) << 40)));
+			Assert::IsTrue(serializer.serialize(static_cast<uint8_t>(ColumnEncoding::Constant)) && serializer.serialize(static_cast<int32_t>(0)));
+			Assert::IsTrue(serializer.serialize(static_cast<uint8_t>(ColumnEncoding::Constant)) && serializer.serialize(static_cast<int32_t>(0)));
+			Assert::IsTrue(serializer.serialize(static_cast<uint8_t>(ColumnEncoding::Constant)) && serializer.serialize(static_cast<uint16_t>(0)));
+			Assert::IsTrue(serializer.serialize(static_cast<uint8_t>(ColumnEncoding::Constant)) && serializer.serialize(0.0f));
+			LimitedField dest;
+			MemoryStreamReader reader(writer.data(), writer.size());
+			BinaryDeserializer deserializer(&reader);
+			Assert::IsFalse(deserializer.deserialize(dest));
+
+			auto deltaBuffer = std::vector<uint8_t>(writer.data(), writer.data() + writer.size());
+			//PositionX as a Delta column of a single byte
+			deltaBuffer[6] = static_cast<uint8_t>(ColumnEncoding::Delta);
+			deltaBuffer[7] = 1;
+			MemoryStreamReader deltaReader(deltaBuffer.data(), deltaBuffer.size());
+			BinaryDeserializer deltaDeserializer(&deltaReader);
+			Assert::IsFalse(deltaDeserializer.deserialize(dest));
+			Assert::AreEqual(static_cast<size_t>(0), dest.getValue().size());
+		}
+	};
+}
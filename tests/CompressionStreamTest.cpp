@@ -0,0 +1,184 @@
+#include "stdafx.h"
+#include "CppUnitTest.h"
+
+#include <ctime>
+#include <vector>
+#include "AntilatencySerialization/BinarySerialization.h"
+#include "AntilatencySerialization/CompressionStream.h"
+#include "AntilatencySerialization/GrowableMemoryStream.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+using namespace Antilatency::Serialization;
+
+namespace SerializationTest
+{
+	TEST_CLASS(CompressionStreamTest)
+	{
+		TEST_CLASS_INITIALIZE(Init) {
+			srand(static_cast<unsigned>(time(nullptr)));
+		}
+
+		//Text-like data: random words from a small vocabulary
+		static std::vector<uint8_t> makeRepetitive(size_t size) {
+			static const char* words[] = { "position ", "rotation ", "velocity ", "tracker ", "marker ", "0.125 ", "-3.5 " };
+			std::vector<uint8_t> data;
+			while (data.size() < size) {
+				auto word = words[rand() % 7];
+				data.insert(data.end(), word, word + strlen(word));
+			}
+			data.resize(size);
+			return data;
+		}
+
+		static std::vector<uint8_t> makeRandom(size_t size) {
+			std::vector<uint8_t> data(size);
+			for (auto& item : data) {
+				item = static_cast<uint8_t>(rand());
+			}
+			return data;
+		}
+
+		static std::vector<uint8_t> compress(const std::vector<uint8_t>& data, size_t blockSize, size_t writeSize) {
+			GrowableMemoryStreamWriter writer;
+			CompressingStreamWriter compressor(&writer, blockSize);
+			for (size_t i = 0; i < data.size(); i += writeSize) {
+				auto size = data.size() - i < writeSize ? data.size() - i : writeSize;
+				Assert::IsTrue(compressor.write(data.data() + i, size));
+			}
+			Assert::IsTrue(compressor.flush());
+			return std::vector<uint8_t>(writer.data(), writer.data() + writer.size());
+		}
+
+		static void checkBlock(const std::vector<uint8_t>& data) {
+			std::vector<uint8_t> compressed(data.size() + data.size() / 255 + 16);
+			std::vector<uint16_t> hashTable(Compression::HashTableSize);
+			auto size = Compression::compressBlock(data.data(), data.size(), compressed.data(), compressed.size(), hashTable.data());
+			Assert::IsTrue(size != 0);
+			std::vector<uint8_t> decompressed(data.size());
+			Assert::IsTrue(Compression::decompressBlock(compressed.data(), size, decompressed.data(), decompressed.size()));
+			Assert::IsTrue(data == decompressed);
+		}
+
+	public:
+		TEST_METHOD(BlockRoundTrip) {
+			for (size_t size : { 0, 1, 12, 13, 100, 1000, 65536 }) {
+				checkBlock(makeRepetitive(size));
+				checkBlock(makeRandom(size));
+				checkBlock(std::vector<uint8_t>(size, 0x55));
+			}
+			//Overlapping matches with short periods
+			for (size_t period = 1; period < 10; ++period) {
+				auto pattern = makeRandom(period);
+				std::vector<uint8_t> data;
+				for (size_t i = 0; i < 5000; ++i) {
+					data.push_back(pattern[i % period]);
+				}
+				checkBlock(data);
+			}
+		}
+
+		TEST_METHOD(StreamRoundTrip) {
+			auto data = makeRepetitive(100000);
+			for (size_t blockSize : { 64, 1000, 65536 }) {
+				for (size_t writeSize : { 1, 7, 4096, 100000 }) {
+					auto compressed = compress(data, blockSize, writeSize);
+					if (blockSize >= 1000) {
+						Assert::IsTrue(compressed.size() < data.size() / 2);
+					}
+
+					MemoryStreamReader reader(compressed.data(), compressed.size());
+					DecompressingStreamReader decompressor(&reader, 65536);
+					std::vector<uint8_t> result(data.size());
+					for (size_t i = 0; i < result.size(); i += writeSize) {
+						auto size = result.size() - i < writeSize ? result.size() - i : writeSize;
+						Assert::IsTrue(decompressor.read(result.data() + i, size));
+					}
+					Assert::IsTrue(data == result);
+					Assert::AreEqual(compressed.size(), reader.getPosition());
+					uint8_t extra;
+					Assert::IsFalse(decompressor.read(&extra, 1));
+				}
+			}
+		}
+
+		TEST_METHOD(IncompressibleStoredRaw) {
+			auto data = makeRandom(10000);
+			auto compressed = compress(data, 4096, data.size());
+			//Three stored blocks with a 2 + 2 byte header each
+			Assert::AreEqual(data.size() + 3 * 4, compressed.size());
+
+			MemoryStreamReader reader(compressed.data(), compressed.size());
+			DecompressingStreamReader decompressor(&reader, 4096);
+			std::vector<uint8_t> result(data.size());
+			Assert::IsTrue(decompressor.read(result.data(), result.size()));
+			Assert::IsTrue(data == result);
+		}
+
+		TEST_METHOD(ReadSome) {
+			auto data = makeRepetitive(3000);
+			auto compressed = compress(data, 1000, data.size());
+			MemoryStreamReader reader(compressed.data(), compressed.size());
+			DecompressingStreamReader decompressor(&reader, 1000);
+			std::vector<uint8_t> result(data.size());
+			//A block at a time, never more than is decoded
+			Assert::AreEqual(static_cast<size_t>(1000), decompressor.readSome(result.data(), 5000));
+			Assert::AreEqual(static_cast<size_t>(10), decompressor.readSome(result.data() + 1000, 10));
+			Assert::AreEqual(static_cast<size_t>(990), decompressor.getBufferedSize());
+			Assert::IsTrue(decompressor.read(result.data() + 1010, 1990));
+			Assert::IsTrue(data == result);
+			Assert::AreEqual(static_cast<size_t>(0), decompressor.readSome(result.data(), 1));
+		}
+
+		TEST_METHOD(Serializer) {
+			BaseVectorType<uint32_t> values;
+			for (uint32_t i = 0; i < 5000; ++i) {
+				values.push_back(1000000 + i % 50);
+			}
+			GrowableMemoryStreamWriter writer;
+			CompressingStreamWriter compressor(&writer);
+			BinarySerializer serializer(&compressor);
+			Assert::IsTrue(serializer.serialize(values));
+			Assert::IsTrue(compressor.flush());
+			Assert::IsTrue(writer.size() < values.size() * sizeof(uint32_t) / 10);
+
+			MemoryStreamReader reader(writer.data(), writer.size());
+			DecompressingStreamReader decompressor(&reader);
+			BinaryDeserializer deserializer(&decompressor);
+			BaseVectorType<uint32_t> dest;
+			Assert::IsTrue(deserializer.deserialize(dest));
+			Assert::IsTrue(values == dest);
+		}
+
+		TEST_METHOD(RejectsCorruptData) {
+			auto data = makeRepetitive(5000);
+			auto compressed = compress(data, 5000, data.size());
+			std::vector<uint8_t> result(data.size());
+
+			//Truncated
+			{
+				MemoryStreamReader reader(compressed.data(), compressed.size() - 1);
+				DecompressingStreamReader decompressor(&reader, 5000);
+				Assert::IsFalse(decompressor.read(result.data(), result.size()));
+			}
+			//Block larger than the reader allows
+			{
+				MemoryStreamReader reader(compressed.data(), compressed.size());
+				DecompressingStreamReader decompressor(&reader, 4096);
+				Assert::IsFalse(decompressor.read(result.data(), 1));
+			}
+			//Random damage never reads out of bounds, and is caught or gives data of the right size
+			for (int i = 0; i < 1000; ++i) {
+				auto damaged = compressed;
+				damaged[4 + rand() % (damaged.size() - 4)] ^= static_cast<uint8_t>(1 + rand() % 255);
+				MemoryStreamReader reader(damaged.data(), damaged.size());
+				DecompressingStreamReader decompressor(&reader, 5000);
+				decompressor.read(result.data(), result.size());
+			}
+			//Offset before the start of the block
+			const uint8_t badOffset[] = { 8, 4, 0x10, 'a', 0x02, 0x00 };
+			std::vector<uint8_t> block(8);
+			Assert::IsFalse(Compression::decompressBlock(badOffset + 2, 4, block.data(), block.size()));
+		}
+	};
+}
@@ -0,0 +1,212 @@
+#include "stdafx.h"
+#include "CppUnitTest.h"
+
+#include <ctime>
+#include <limits>
+#include <vector>
+#include "AntilatencySerialization/Fields.h"
+#include "AntilatencySerialization/Structures.h"
+#include "AntilatencySerialization/BinarySerialization.h"
+#include "AntilatencySerialization/DeltaSerialization.h"
+#include "AntilatencySerialization/GrowableMemoryStream.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+using namespace Antilatency::Serialization;
+
+namespace SerializationTest
+{
+	namespace DeltaSerializationTestTypes {
+		SERIALIZATION_MAKE_FIELD_NAME(X);
+		SERIALIZATION_MAKE_FIELD_NAME(Y);
+		SERIALIZATION_MAKE_FIELD_NAME(Frame);
+		SERIALIZATION_MAKE_FIELD_NAME(Position);
+		SERIALIZATION_MAKE_FIELD_NAME(Speed);
+		SERIALIZATION_MAKE_FIELD_NAME(Counter);
+		SERIALIZATION_MAKE_FIELD_NAME(Name);
+		SERIALIZATION_MAKE_FIELD_NAME(Samples);
+		SERIALIZATION_MAKE_FIELD_NAME(Points);
+		SERIALIZATION_MAKE_FIELD_NAME(Target);
+
+		using Point = Structure<Int32Field<X>, Int32Field<Y>>;
+
+		using State = Structure<
+			SingleField<uint32_t, Frame>,
+			SingleField<Point, Position>,
+			SingleField<float, Speed>,
+			SingleField<Varint<int64_t>, Counter>,
+			StringField<Name>,
+			VectorField<int16_t, Samples>,
+			VectorField<Point, Points>,
+			OptioinalField<SingleField<Point, Target>>
+		>;
+
+		struct Row : Structure<Int32Field<X>, Int32Field<Y>> {};
+
+		class VersionedPoint : public VersionedStructure<2, VersionedPoint, Int32Field<X>, Int32Field<Y>> {
+		public:
+			template<typename Deserializer>
+			bool convertFromPreviousVersion(VersionType, Deserializer&) {
+				return false;
+			}
+		};
+
+		using Scene = Structure<
+			VectorField<Row, Points>,
+			SingleField<VersionedPoint, Target>
+		>;
+	}
+
+	using namespace DeltaSerializationTestTypes;
+
+	TEST_CLASS(DeltaSerializationTest)
+	{
+		TEST_CLASS_INITIALIZE(Init) {
+			srand(static_cast<unsigned>(time(nullptr)));
+		}
+
+		static Point makePoint() {
+			Point point;
+			point.get<X>().setValue(rand() - RAND_MAX / 2);
+			point.get<Y>().setValue(rand() - RAND_MAX / 2);
+			return point;
+		}
+
+		static void mutate(State& state, int changes) {
+			for (int i = 0; i < changes; ++i) {
+				switch (rand() % 9) {
+				case 0: state.get<Frame>().getValue()++; break;
+				case 1: state.get<Position>().setValue(makePoint()); break;
+				case 2: state.get<Speed>().setValue(static_cast<float>(rand())); break;
+				case 3: state.get<Counter>().setValue(Varint<int64_t>(state.get<Counter>().getValue() - rand())); break;
+				case 4: state.get<Name>().setValue(BaseStringType(rand() % 10, 'n')); break;
+				case 5: state.get<Samples>().getValue().resize(rand() % 40, static_cast<int16_t>(rand())); break;
+				case 6:
+					if (!state.get<Samples>().getValue().empty()) {
+						state.get<Samples>().getValue()[rand() % state.get<Samples>().getValue().size()] = static_cast<int16_t>(rand());
+					}
+					break;
+				case 7: state.get<Points>().getValue().resize(rand() % 20, makePoint()); break;
+				case 8:
+					if (rand() % 2) {
+						state.get<Target>().setValue(makePoint());
+					}
+					else {
+						state.get<Target>() = OptioinalField<SingleField<Point, Target>>();
+					}
+					break;
+				}
+			}
+		}
+
+		static std::vector<uint8_t> serialize(const State& state) {
+			GrowableMemoryStreamWriter writer;
+			BinarySerializer serializer(&writer);
+			Assert::IsTrue(serializer.serialize(state));
+			return std::vector<uint8_t>(writer.data(), writer.data() + writer.size());
+		}
+
+		static std::vector<uint8_t> delta(const State& state, const State& previous) {
+			GrowableMemoryStreamWriter writer;
+			DeltaSerializer serializer(&writer);
+			Assert::IsTrue(serializer.serialize(state, previous));
+			return std::vector<uint8_t>(writer.data(), writer.data() + writer.size());
+		}
+
+		static void apply(State& state, const std::vector<uint8_t>& delta) {
+			MemoryStreamReader reader(delta.data(), delta.size());
+			DeltaDeserializer deserializer(&reader);
+			Assert::IsTrue(deserializer.deserialize(state));
+			Assert::AreEqual(delta.size(), reader.getPosition());
+		}
+
+	public:
+		TEST_METHOD(ReconstructFrames) {
+			State sender;
+			State receiver;
+			for (int frame = 0; frame < 500; ++frame) {
+				State next = sender;
+				mutate(next, rand() % 4);
+				apply(receiver, delta(next, sender));
+				sender = next;
+				Assert::IsTrue(serialize(sender) == serialize(receiver));
+			}
+		}
+
+		TEST_METHOD(UnchangedIsBitmapOnly) {
+			State state;
+			mutate(state, 20);
+			Assert::AreEqual(static_cast<size_t>(1), delta(state, state).size());
+
+			State next = state;
+			next.get<Frame>().getValue()++;
+			//Bitmap and a one byte difference
+			Assert::AreEqual(static_cast<size_t>(2), delta(next, state).size());
+		}
+
+		TEST_METHOD(VectorElementDelta) {
+			State state;
+			state.get<Samples>().getValue().assign(64, 1000);
+			State next = state;
+			next.get<Samples>().getValue()[10] = 1001;
+			//Bitmap, size, 8 group masks and one difference
+			Assert::AreEqual(static_cast<size_t>(1 + 1 + 8 + 1), delta(next, state).size());
+			apply(state, delta(next, state));
+			Assert::IsTrue(serialize(state) == serialize(next));
+		}
+
+		TEST_METHOD(DerivedStructures) {
+			Scene scene;
+			scene.get<Points>().getValue().resize(20);
+			for (auto& row : scene.get<Points>().getValue()) {
+				row.get<X>().setValue(rand());
+			}
+			Scene next = scene;
+			next.get<Points>().getValue()[3].get<Y>().setValue(1);
+			next.get<Points>().getValue().push_back(Row());
+			next.get<Target>().getValue().get<X>().setValue(-1);
+
+			GrowableMemoryStreamWriter writer;
+			DeltaSerializer serializer(&writer);
+			Assert::IsTrue(serializer.serialize(next, scene));
+			MemoryStreamReader reader(writer.data(), writer.size());
+			DeltaDeserializer deserializer(&reader);
+			Assert::IsTrue(deserializer.deserialize(scene));
+			Assert::AreEqual(writer.size(), reader.getPosition());
+
+			Assert::AreEqual(next.get<Points>().getValue().size(), scene.get<Points>().getValue().size());
+			for (size_t i = 0; i < scene.get<Points>().getValue().size(); ++i) {
+				Assert::AreEqual(next.get<Points>().getValue()[i].get<X>().getValue(), scene.get<Points>().getValue()[i].get<X>().getValue());
+				Assert::AreEqual(next.get<Points>().getValue()[i].get<Y>().getValue(), scene.get<Points>().getValue()[i].get<Y>().getValue());
+			}
+			Assert::AreEqual(-1, scene.get<Target>().getValue().get<X>().getValue());
+		}
+
+		TEST_METHOD(OversizedVector) {
+			//Samples changed, with far more items than the data holds
+			for (auto size : { UINT64_MAX, UINT64_MAX / 2 }) {
+				GrowableMemoryStreamWriter writer;
+				BinarySerializer serializer(&writer);
+				Assert::IsTrue(serializer.serialize(static_cast<uint8_t>(1 << 5)));
+				Assert::IsTrue(serializer.serialize(Varint64(size)));
+				Assert::IsTrue(serializer.serialize(static_cast<int16_t>(1)));
+				MemoryStreamReader reader(writer.data(), writer.size());
+				DeltaDeserializer deserializer(&reader);
+				State state;
+				Assert::IsFalse(deserializer.deserialize(state));
+			}
+		}
+
+		TEST_METHOD(IntegerWrapAround) {
+			State state;
+			state.get<Position>().getValue().get<X>().setValue(std::numeric_limits<int32_t>::max());
+			state.get<Frame>().setValue(0);
+			State next = state;
+			next.get<Position>().getValue().get<X>().setValue(std::numeric_limits<int32_t>::min());
+			next.get<Frame>().setValue(std::numeric_limits<uint32_t>::max());
+			apply(state, delta(next, state));
+			Assert::AreEqual(std::numeric_limits<int32_t>::min(), state.get<Position>().getValue().get<X>().getValue());
+			Assert::AreEqual(std::numeric_limits<uint32_t>::max(), state.get<Frame>().getValue());
+		}
+	};
+}
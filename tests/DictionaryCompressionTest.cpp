@@ -0,0 +1,256 @@
+#include "stdafx.h"
+#include "CppUnitTest.h"
+
+#include <ctime>
+#include <string>
+#include <vector>
+#include "AntilatencySerialization/Fields.h"
+#include "AntilatencySerialization/Structures.h"
+#include "AntilatencySerialization/BinarySerialization.h"
+#include "AntilatencySerialization/DictionaryCompression.h"
+#include "AntilatencySerialization/GrowableMemoryStream.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+using namespace Antilatency::Serialization;
+
+namespace SerializationTest
+{
+	namespace DictionaryCompressionTestTypes {
+		SERIALIZATION_MAKE_FIELD_NAME(Device);
+		SERIALIZATION_MAKE_FIELD_NAME(Sequence);
+		SERIALIZATION_MAKE_FIELD_NAME(Status);
+		SERIALIZATION_MAKE_FIELD_NAME(X);
+		SERIALIZATION_MAKE_FIELD_NAME(Y);
+		SERIALIZATION_MAKE_FIELD_NAME(Z);
+		SERIALIZATION_MAKE_FIELD_NAME(Markers);
+
+		using Telemetry = Structure<
+			StringField<Device>,
+			SingleField<uint32_t, Sequence>,
+			SingleField<uint8_t, Status>,
+			SingleField<float, X>,
+			SingleField<float, Y>,
+			SingleField<float, Z>,
+			VectorField<uint16_t, Markers>
+		>;
+	}
+
+	using namespace DictionaryCompressionTestTypes;
+
+	TEST_CLASS(DictionaryCompressionTest)
+	{
+		TEST_CLASS_INITIALIZE(Init) {
+			srand(static_cast<unsigned>(time(nullptr)));
+		}
+
+		static Telemetry makeMessage(uint32_t sequence) {
+			static const char* devices[] = { "tracker-alpha-0017", "tracker-alpha-0018", "bracer-left-0003" };
+			Telemetry message;
+			message.get<Device>().setValue(devices[rand() % 3]);
+			message.get<Sequence>().setValue(sequence);
+			message.get<Status>().setValue(rand() % 8 == 0 ? 1 : 0);
+			message.get<X>().setValue(1.5f);
+			message.get<Y>().setValue(static_cast<float>(rand() % 4) * 0.25f);
+			message.get<Z>().setValue(static_cast<float>(rand()) / RAND_MAX);
+			for (uint16_t marker = 100; marker < 108; ++marker) {
+				message.get<Markers>().getValue().push_back(rand() % 10 == 0 ? marker + 1000 : marker);
+			}
+			return message;
+		}
+
+		static std::vector<uint8_t> train(size_t capacity) {
+			DictionaryTrainer trainer;
+			for (uint32_t i = 0; i < 300; ++i) {
+				Assert::IsTrue(trainer.addMessage(makeMessage(i * 7)));
+			}
+			Assert::AreEqual(static_cast<size_t>(300), trainer.getSampleCount());
+			std::vector<uint8_t> dictionary(capacity);
+			dictionary.resize(trainer.train(dictionary.data(), dictionary.size()));
+			return dictionary;
+		}
+
+		static size_t plainSize(const Telemetry& message) {
+			return getSerializedSize(message);
+		}
+
+		//Every message is flushed as its own packet
+		static std::vector<uint8_t> compress(const std::vector<Telemetry>& messages, const CompressionDictionary& dictionary, DictionaryMode mode) {
+			GrowableMemoryStreamWriter writer;
+			DictionaryCompressingStreamWriter compressor(&writer, &dictionary, mode);
+			BinarySerializer serializer(&compressor);
+			for (auto& message : messages) {
+				Assert::IsTrue(serializer.serialize(message));
+				Assert::IsTrue(compressor.flush());
+			}
+			return std::vector<uint8_t>(writer.data(), writer.data() + writer.size());
+		}
+
+		static void checkEqual(const Telemetry& expected, const Telemetry& actual) {
+			Assert::IsTrue(expected.get<Device>().getValue() == actual.get<Device>().getValue());
+			Assert::AreEqual(expected.get<Sequence>().getValue(), actual.get<Sequence>().getValue());
+			Assert::AreEqual(expected.get<Status>().getValue(), actual.get<Status>().getValue());
+			Assert::AreEqual(expected.get<Z>().getValue(), actual.get<Z>().getValue());
+			Assert::IsTrue(expected.get<Markers>().getValue() == actual.get<Markers>().getValue());
+		}
+
+		static void decompress(const std::vector<uint8_t>& data, const std::vector<Telemetry>& messages, const CompressionDictionary& dictionary, DictionaryMode mode) {
+			MemoryStreamReader reader(data.data(), data.size());
+			DictionaryDecompressingStreamReader decompressor(&reader, &dictionary, mode);
+			BinaryDeserializer deserializer(&decompressor);
+			for (auto& message : messages) {
+				Telemetry dest;
+				Assert::IsTrue(deserializer.deserialize(dest));
+				checkEqual(message, dest);
+			}
+			Assert::AreEqual(data.size(), reader.getPosition());
+			Assert::AreEqual(static_cast<size_t>(0), decompressor.getBufferedSize());
+		}
+
+	public:
+		TEST_METHOD(Train) {
+			auto dictionary = train(1024);
+			Assert::IsTrue(dictionary.size() > 0 && dictionary.size() <= 1024);
+			std::string text(dictionary.begin(), dictionary.end());
+			Assert::IsTrue(text.find("tracker-alpha-001") != std::string::npos);
+
+			DictionaryTrainer empty;
+			uint8_t buffer[16];
+			Assert::AreEqual(static_cast<size_t>(0), empty.train(buffer, sizeof(buffer)));
+		}
+
+		TEST_METHOD(StaticRoundTrip) {
+			auto trained = train(2048);
+			CompressionDictionary dictionary(7, trained.data(), trained.size());
+			std::vector<Telemetry> messages;
+			size_t plain = 0;
+			for (uint32_t i = 0; i < 500; ++i) {
+				messages.push_back(makeMessage(i));
+				plain += plainSize(messages.back());
+			}
+			auto compressed = compress(messages, dictionary, DictionaryMode::Static);
+			Assert::IsTrue(compressed.size() < plain * 6 / 10);
+			decompress(compressed, messages, dictionary, DictionaryMode::Static);
+
+			//Without a dictionary the packets are too small to shrink much
+			CompressionDictionary none;
+			Assert::IsTrue(compress(messages, none, DictionaryMode::Static).size() * 6 / 10 > compressed.size());
+		}
+
+		TEST_METHOD(StaticPacketsAreIndependent) {
+			auto trained = train(2048);
+			CompressionDictionary dictionary(7, trained.data(), trained.size());
+			std::vector<std::vector<uint8_t>> packets;
+			std::vector<Telemetry> messages;
+			for (uint32_t i = 0; i < 20; ++i) {
+				messages.push_back(makeMessage(i));
+				packets.push_back(compress({ messages.back() }, dictionary, DictionaryMode::Static));
+			}
+			for (size_t i = packets.size(); i-- > 0;) {
+				decompress(packets[i], { messages[i] }, dictionary, DictionaryMode::Static);
+			}
+		}
+
+		TEST_METHOD(SlidingRoundTrip) {
+			auto trained = train(2048);
+			CompressionDictionary dictionary(7, trained.data(), trained.size());
+			std::vector<Telemetry> messages;
+			size_t plain = 0;
+			//Several times the history, so it slides
+			for (uint32_t i = 0; i < 3000; ++i) {
+				messages.push_back(makeMessage(i));
+				plain += plainSize(messages.back());
+			}
+			auto compressed = compress(messages, dictionary, DictionaryMode::Sliding);
+			Assert::IsTrue(compressed.size() < plain * 6 / 10);
+			decompress(compressed, messages, dictionary, DictionaryMode::Sliding);
+
+			//History alone is enough once the stream is running
+			CompressionDictionary none;
+			compressed = compress(messages, none, DictionaryMode::Sliding);
+			Assert::IsTrue(compressed.size() < plain * 6 / 10);
+			decompress(compressed, messages, none, DictionaryMode::Sliding);
+		}
+
+		TEST_METHOD(LargeWrites) {
+			std::vector<uint8_t> data(20000);
+			for (size_t i = 0; i < data.size(); ++i) {
+				data[i] = static_cast<uint8_t>(i / 100);
+			}
+			CompressionDictionary none;
+			for (auto mode : { DictionaryMode::Static, DictionaryMode::Sliding }) {
+				GrowableMemoryStreamWriter writer;
+				DictionaryCompressingStreamWriter compressor(&writer, &none, mode, 1000);
+				Assert::IsTrue(compressor.write(data.data(), data.size()));
+				Assert::IsTrue(compressor.flush());
+
+				MemoryStreamReader reader(writer.data(), writer.size());
+				DictionaryDecompressingStreamReader decompressor(&reader, &none, mode, 1000);
+				std::vector<uint8_t> result(data.size());
+				Assert::AreEqual(static_cast<size_t>(1000), decompressor.readSome(result.data(), result.size()));
+				Assert::IsTrue(decompressor.read(result.data() + 1000, result.size() - 1000));
+				Assert::IsTrue(data == result);
+			}
+		}
+
+		TEST_METHOD(DictionaryIds) {
+			auto trained = train(1024);
+			CompressionDictionary first(1, trained.data(), trained.size());
+			CompressionDictionary second(2, trained.data() + 100, trained.size() - 100);
+			CompressionDictionary unknown(3, trained.data(), trained.size());
+			const CompressionDictionary* known[] = { &first, &second };
+
+			std::vector<Telemetry> messages = { makeMessage(1) };
+			auto fromFirst = compress(messages, first, DictionaryMode::Static);
+			auto fromSecond = compress(messages, second, DictionaryMode::Static);
+			auto both = fromSecond;
+			both.insert(both.end(), fromFirst.begin(), fromFirst.end());
+			{
+				MemoryStreamReader reader(both.data(), both.size());
+				DictionaryDecompressingStreamReader decompressor(&reader, known, 2);
+				BinaryDeserializer deserializer(&decompressor);
+				Telemetry dest;
+				Assert::IsTrue(deserializer.deserialize(dest));
+				checkEqual(messages[0], dest);
+				Assert::IsTrue(deserializer.deserialize(dest));
+				checkEqual(messages[0], dest);
+			}
+
+			auto fromUnknown = compress(messages, unknown, DictionaryMode::Static);
+			MemoryStreamReader reader(fromUnknown.data(), fromUnknown.size());
+			DictionaryDecompressingStreamReader decompressor(&reader, known, 2);
+			BinaryDeserializer deserializer(&decompressor);
+			Telemetry dest;
+			Assert::IsFalse(deserializer.deserialize(dest));
+
+			//A sliding history can not change its dictionary
+			MemoryStreamReader slidingReader(both.data(), both.size());
+			DictionaryDecompressingStreamReader slidingDecompressor(&slidingReader, known, 2, DictionaryMode::Sliding);
+			BinaryDeserializer slidingDeserializer(&slidingDecompressor);
+			Assert::IsTrue(slidingDeserializer.deserialize(dest));
+			Assert::IsFalse(slidingDeserializer.deserialize(dest));
+		}
+
+		TEST_METHOD(RejectsCorruptData) {
+			auto trained = train(2048);
+			CompressionDictionary dictionary(7, trained.data(), trained.size());
+			std::vector<Telemetry> messages;
+			for (uint32_t i = 0; i < 50; ++i) {
+				messages.push_back(makeMessage(i));
+			}
+			for (auto mode : { DictionaryMode::Static, DictionaryMode::Sliding }) {
+				auto compressed = compress(messages, dictionary, mode);
+				//Random damage never reads out of bounds
+				for (int i = 0; i < 300; ++i) {
+					auto damaged = compressed;
+					damaged[rand() % damaged.size()] ^= static_cast<uint8_t>(1 + rand() % 255);
+					MemoryStreamReader reader(damaged.data(), damaged.size());
+					DictionaryDecompressingStreamReader decompressor(&reader, &dictionary, mode);
+					BinaryDeserializer deserializer(&decompressor);
+					Telemetry dest;
+					for (size_t j = 0; j < messages.size() && deserializer.deserialize(dest); ++j) {}
+				}
+			}
+		}
+	};
+}
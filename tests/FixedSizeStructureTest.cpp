@@ -0,0 +1,139 @@
+#include "stdafx.h"
+#include "CppUnitTest.h"
+
+#include <ctime>
+#include <vector>
+#include "AntilatencySerialization/Fields.h"
+#include "AntilatencySerialization/Structures.h"
+#include "AntilatencySerialization/BinarySerialization.h"
+#include "AntilatencySerialization/UserStream.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+using namespace Antilatency::Serialization;
+
+namespace SerializationTest
+{
+	SERIALIZATION_MAKE_FIELD_NAME(PositionX);
+	SERIALIZATION_MAKE_FIELD_NAME(PositionY);
+	SERIALIZATION_MAKE_FIELD_NAME(Direction);
+	SERIALIZATION_MAKE_FIELD_NAME(Weight);
+	SERIALIZATION_MAKE_FIELD_NAME(Bar);
+	SERIALIZATION_MAKE_FIELD_NAME(Bars);
+
+	using FixedBar = Structure<Int32Field<PositionX>, Int32Field<PositionY>, Int32Field<Direction>>;
+	using FixedNested = Structure<SingleField<uint8_t, Weight>, SingleField<FixedBar, Bar>>;
+	using VarintBar = Structure<Int32Field<PositionX>, SingleField<Varint32, Direction>>;
+	using BoolBar = Structure<Int32Field<PositionX>, SingleField<bool, Direction>>;
+
+	static_assert(detail::FixedSize<FixedBar>::value == 12, "Structure of int32 fields must be fixed");
+	static_assert(detail::FixedSize<FixedNested>::value == 13, "Nested fixed structure must be fixed");
+	static_assert(detail::FixedSize<VarintBar>::value == 0, "Varint field is not fixed");
+	static_assert(detail::FixedSize<BoolBar>::value == 0, "Bool field is not fixed");
+
+	//Derived type is not matched by the fixed path and is serialized field by field
+	class PerFieldBar : public FixedNested {};
+
+	TEST_CLASS(FixedSizeStructureTest)
+	{
+		TEST_CLASS_INITIALIZE(Init) {
+			srand(static_cast<unsigned>(time(nullptr)));
+		}
+
+		static FixedNested makeRandom() {
+			FixedNested value;
+			value.get<Weight>().setValue(static_cast<uint8_t>(rand()));
+			value.get<Bar>().getValue().get<PositionX>().setValue(rand());
+			value.get<Bar>().getValue().get<PositionY>().setValue(-rand());
+			value.get<Bar>().getValue().get<Direction>().setValue(static_cast<int32_t>(static_cast<uint32_t>(rand()) << 8));
+			return value;
+		}
+
+		static bool isEqual(const FixedNested& a, const FixedNested& b) {
+			auto& barA = a.get<Bar>().getValue();
+			auto& barB = b.get<Bar>().getValue();
+			return a.get<Weight>().getValue() == b.get<Weight>().getValue() &&
+				barA.get<PositionX>().getValue() == barB.get<PositionX>().getValue() &&
+				barA.get<PositionY>().getValue() == barB.get<PositionY>().getValue() &&
+				barA.get<Direction>().getValue() == barB.get<Direction>().getValue();
+		}
+
+		template<typename T>
+		static std::vector<uint8_t> serialize(const T& value) {
+			MemorySizeCounterStream counterStream;
+			BinarySerializer counter(&counterStream);
+			Assert::IsTrue(counter.serialize(value));
+			std::vector<uint8_t> result(counterStream.getActualSize());
+			MemoryStreamWriter writer(result.data(), result.size());
+			BinarySerializer serializer(&writer);
+			Assert::IsTrue(serializer.serialize(value));
+			return result;
+		}
+
+	public:
+		TEST_METHOD(SameBytesAsPerField) {
+			auto value = makeRandom();
+			PerFieldBar perField;
+			static_cast<FixedNested&>(perField) = value;
+			auto packed = serialize(value);
+			Assert::AreEqual(static_cast<size_t>(13), packed.size());
+			Assert::IsTrue(packed == serialize(perField));
+
+			std::vector<FixedNested> vector{ value, makeRandom() };
+			std::vector<PerFieldBar> perFieldVector(2);
+			static_cast<FixedNested&>(perFieldVector[0]) = vector[0];
+			static_cast<FixedNested&>(perFieldVector[1]) = vector[1];
+			Assert::IsTrue(serialize(vector) == serialize(perFieldVector));
+		}
+
+		TEST_METHOD(VectorRoundTrip) {
+			for (size_t size = 0; size < 300; size += 1 + size / 4) {
+				std::vector<FixedNested> source;
+				for (size_t i = 0; i < size; ++i) {
+					source.push_back(makeRandom());
+				}
+				auto buffer = serialize(source);
+
+				std::vector<FixedNested> memoryDest;
+				MemoryStreamReader memoryReader(buffer.data(), buffer.size());
+				BinaryDeserializer memoryDeserializer(&memoryReader);
+				Assert::IsTrue(memoryDeserializer.deserialize(memoryDest));
+
+				std::vector<FixedNested> userDest;
+				MemoryStreamReader innerReader(buffer.data(), buffer.size());
+				UserStreamReader userReader([&innerReader](uint8_t* data, size_t size) {
+					return innerReader.read(data, size);
+				});
+				BinaryDeserializer userDeserializer(&userReader);
+				Assert::IsTrue(userDeserializer.deserialize(userDest));
+
+				Assert::AreEqual(size, memoryDest.size());
+				Assert::AreEqual(size, userDest.size());
+				for (size_t i = 0; i < size; ++i) {
+					Assert::IsTrue(isEqual(source[i], memoryDest[i]));
+					Assert::IsTrue(isEqual(source[i], userDest[i]));
+				}
+			}
+		}
+
+		TEST_METHOD(Truncated) {
+			std::vector<FixedNested> source(10, makeRandom());
+			auto buffer = serialize(source);
+
+			std::vector<FixedNested> dest;
+			MemoryStreamReader reader(buffer.data(), buffer.size() - 1);
+			BinaryDeserializer deserializer(&reader);
+			Assert::IsFalse(deserializer.deserialize(dest));
+
+			FixedNested single;
+			MemoryStreamReader singleReader(buffer.data() + 1, 12);
+			BinaryDeserializer singleDeserializer(&singleReader);
+			Assert::IsFalse(singleDeserializer.deserialize(single));
+
+			std::vector<uint8_t> small(buffer.size() - 1);
+			MemoryStreamWriter writer(small.data(), small.size());
+			BinarySerializer serializer(&writer);
+			Assert::IsFalse(serializer.serialize(source));
+		}
+	};
+}
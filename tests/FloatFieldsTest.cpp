@@ -0,0 +1,267 @@
+#include "stdafx.h"
+#include "CppUnitTest.h"
+
+#include <ctime>
+#include <cmath>
+#include <vector>
+#include "AntilatencySerialization/Fields.h"
+#include "AntilatencySerialization/Structures.h"
+#include "AntilatencySerialization/BinarySerialization.h"
+#include "AntilatencySerialization/BitPackedSerialization.h"
+#include "AntilatencySerialization/FloatFields.h"
+#include "AntilatencySerialization/SizeCalculator.h"
+#include "AntilatencySerialization/GrowableMemoryStream.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+using namespace Antilatency::Serialization;
+
+namespace SerializationTest
+{
+	namespace FloatFieldsTestTypes {
+		SERIALIZATION_MAKE_FIELD_NAME(Time);
+		SERIALIZATION_MAKE_FIELD_NAME(Height);
+		SERIALIZATION_MAKE_FIELD_NAME(X);
+		SERIALIZATION_MAKE_FIELD_NAME(Rotation);
+		SERIALIZATION_MAKE_FIELD_NAME(Samples);
+		SERIALIZATION_MAKE_FIELD_NAME(Positions);
+		SERIALIZATION_MAKE_FIELD_NAME(Rotations);
+
+		SERIALIZATION_MAKE_FLOAT_RANGE(RoomRange, -5.0f, 5.0f);
+
+		using Pose = Structure<
+			SingleField<double, Time>,
+			Float16Field<Height>,
+			QuantizedFloatField<RoomRange, 16, X>,
+			QuaternionField<Rotation>
+		>;
+
+		using Track = Structure<
+			Float16VectorField<Samples>,
+			QuantizedFloatVectorField<RoomRange, 12, Positions>,
+			QuaternionVectorField<Rotations>
+		>;
+	}
+
+	using namespace FloatFieldsTestTypes;
+
+	TEST_CLASS(FloatFieldsTest)
+	{
+		TEST_CLASS_INITIALIZE(Init) {
+			srand(static_cast<unsigned>(time(nullptr)));
+		}
+
+		template<typename T>
+		static std::vector<uint8_t> serialize(const T& value) {
+			GrowableMemoryStreamWriter writer;
+			BinarySerializer serializer(&writer);
+			Assert::IsTrue(serializer.serialize(value));
+			return std::vector<uint8_t>(writer.data(), writer.data() + writer.size());
+		}
+
+		template<typename T>
+		static void deserialize(const std::vector<uint8_t>& data, T& value) {
+			MemoryStreamReader reader(data.data(), data.size());
+			BinaryDeserializer deserializer(&reader);
+			Assert::IsTrue(deserializer.deserialize(value));
+			Assert::AreEqual(data.size(), reader.getPosition());
+		}
+
+		static float randomFloat(float min, float max) {
+			return min + (max - min) * static_cast<float>(rand()) / static_cast<float>(RAND_MAX);
+		}
+
+		static Quaternion randomRotation() {
+			Quaternion q;
+			q.x = randomFloat(-1.0f, 1.0f);
+			q.y = randomFloat(-1.0f, 1.0f);
+			q.z = randomFloat(-1.0f, 1.0f);
+			q.w = randomFloat(-1.0f, 1.0f);
+			float length = std::sqrt(q.x * q.x + q.y * q.y + q.z * q.z + q.w * q.w);
+			q.x /= length;
+			q.y /= length;
+			q.z /= length;
+			q.w /= length;
+			return q;
+		}
+
+		static float dot(const Quaternion& a, const Quaternion& b) {
+			return a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w;
+		}
+
+	public:
+		TEST_METHOD(Double) {
+			BaseVectorType<double> values = { 0.1, -1e300, 3.141592653589793 };
+			auto buffer = serialize(values);
+			Assert::AreEqual(1 + 3 * sizeof(double), buffer.size());
+			BaseVectorType<double> dest;
+			deserialize(buffer, dest);
+			Assert::IsTrue(values == dest);
+			static_assert(maxSerializedSize<double>() == sizeof(double), "Wrong maximum size");
+		}
+
+		TEST_METHOD(HalfKnownValues) {
+			Assert::AreEqual(static_cast<uint16_t>(0x3C00), detail::floatToHalf(1.0f));
+			Assert::AreEqual(static_cast<uint16_t>(0xC000), detail::floatToHalf(-2.0f));
+			Assert::AreEqual(static_cast<uint16_t>(0x7BFF), detail::floatToHalf(65504.0f));
+			Assert::AreEqual(static_cast<uint16_t>(0x7C00), detail::floatToHalf(65520.0f));
+			Assert::AreEqual(static_cast<uint16_t>(0x2E66), detail::floatToHalf(0.1f));
+			Assert::AreEqual(static_cast<uint16_t>(0x0001), detail::floatToHalf(std::ldexp(1.0f, -24)));
+			Assert::AreEqual(static_cast<uint16_t>(0x0000), detail::floatToHalf(std::ldexp(1.0f, -25)));
+			Assert::AreEqual(static_cast<uint16_t>(0xFC00), detail::floatToHalf(-INFINITY));
+			Assert::IsTrue(std::isnan(detail::halfToFloat(detail::floatToHalf(NAN))));
+		}
+
+		TEST_METHOD(HalfExhaustive) {
+			for (uint32_t i = 0; i < 0x10000; ++i) {
+				auto half = static_cast<uint16_t>(i);
+				if ((half & 0x7C00) == 0x7C00 && (half & 0x3FF) != 0) {
+					continue;
+				}
+				Assert::AreEqual(half, detail::floatToHalf(detail::halfToFloat(half)));
+			}
+		}
+
+		TEST_METHOD(HalfBulkMatchesScalar) {
+			std::vector<float> values(1003);
+			for (auto& value : values) {
+				uint32_t bits = (static_cast<uint32_t>(rand()) << 16) ^ static_cast<uint32_t>(rand());
+				memcpy(&value, &bits, sizeof(value));
+			}
+			values[0] = 1.0f;
+			values[1] = 65519.0f;
+			std::vector<uint16_t> halfs(values.size());
+			detail::floatToHalf(values.data(), halfs.data(), values.size());
+			for (size_t i = 0; i < values.size(); ++i) {
+				Assert::AreEqual(detail::floatToHalf(values[i]), halfs[i]);
+			}
+			std::vector<float> floats(values.size());
+			detail::halfToFloat(halfs.data(), floats.data(), halfs.size());
+			for (size_t i = 0; i < halfs.size(); ++i) {
+				auto expected = detail::halfToFloat(halfs[i]);
+				Assert::IsTrue(memcmp(&expected, &floats[i], sizeof(float)) == 0);
+			}
+		}
+
+		TEST_METHOD(Quantized) {
+			using Codec = QuantizedFloatCodec<RoomRange, 12>;
+			const float maxError = 10.0f / 4095.0f / 2.0f * 1.001f;
+			for (int i = 0; i < 1000; ++i) {
+				float value = randomFloat(-5.0f, 5.0f);
+				Assert::IsTrue(std::fabs(Codec::decode(Codec::encode(value)) - value) <= maxError);
+			}
+			Assert::AreEqual(-5.0f, Codec::decode(Codec::encode(-100.0f)));
+			Assert::AreEqual(5.0f, Codec::decode(Codec::encode(100.0f)));
+			Assert::AreEqual(static_cast<uint16_t>(0), Codec::encode(NAN));
+		}
+
+		TEST_METHOD(QuantizedWidest) {
+			using Codec = QuantizedFloatCodec<RoomRange, 24>;
+			Assert::AreEqual(0u, Codec::encode(-5.0f));
+			Assert::AreEqual(0xFFFFFFu, Codec::encode(5.0f));
+
+			QuantizedFloatField<RoomRange, 24, X> field;
+			for (float value : { -5.0f, 5.0f }) {
+				field.setValue(value);
+				auto buffer = serialize(field);
+				QuantizedFloatField<RoomRange, 24, X> dest;
+				deserialize(buffer, dest);
+				Assert::AreEqual(value, dest.getValue());
+
+				GrowableMemoryStreamWriter writer;
+				BitPackedSerializer serializer(&writer);
+				Assert::IsTrue(serializer.serialize(field));
+				Assert::IsTrue(serializer.flush());
+				Assert::AreEqual(static_cast<size_t>(3), writer.size());
+				MemoryStreamReader reader(writer.data(), writer.size());
+				BitPackedDeserializer deserializer(&reader);
+				Assert::IsTrue(deserializer.deserialize(dest));
+				Assert::AreEqual(value, dest.getValue());
+			}
+		}
+
+		TEST_METHOD(Quaternions) {
+			using Codec = SmallestThreeCodec<10>;
+			static_assert(Codec::BitCount == 32, "Wrong width");
+			for (int i = 0; i < 1000; ++i) {
+				auto q = randomRotation();
+				auto decoded = Codec::decode(Codec::encode(q));
+				Assert::IsTrue(std::fabs(dot(q, decoded)) > 0.9999f);
+			}
+		}
+
+		TEST_METHOD(StructureRoundTrip) {
+			static_assert(detail::FixedSize<Pose>::value == 8 + 2 + 2 + 4, "Pose should take the fixed-size path");
+			static_assert(maxSerializedSize<Pose>() == 16, "Wrong maximum size");
+			Pose pose;
+			pose.get<Time>().setValue(12345.678);
+			pose.get<Height>().setValue(1.75f);
+			pose.get<X>().setValue(-2.5f);
+			pose.get<Rotation>().setValue(randomRotation());
+			auto buffer = serialize(pose);
+			Assert::AreEqual(static_cast<size_t>(16), buffer.size());
+
+			Pose dest;
+			deserialize(buffer, dest);
+			Assert::AreEqual(12345.678, dest.get<Time>().getValue());
+			Assert::AreEqual(1.75f, dest.get<Height>().getValue());
+			Assert::IsTrue(std::fabs(dest.get<X>().getValue() + 2.5f) < 1e-3f);
+			Assert::IsTrue(std::fabs(dot(pose.get<Rotation>().getValue(), dest.get<Rotation>().getValue())) > 0.9999f);
+		}
+
+		TEST_METHOD(VectorRoundTrip) {
+			Track track;
+			for (int i = 0; i < 37; ++i) {
+				track.get<Samples>().getValue().push_back(randomFloat(-100.0f, 100.0f));
+				track.get<Positions>().getValue().push_back(randomFloat(-5.0f, 5.0f));
+				track.get<Rotations>().getValue().push_back(randomRotation());
+			}
+			auto buffer = serialize(track);
+			Assert::AreEqual(static_cast<size_t>(3 + 37 * (2 + 2 + 4)), buffer.size());
+			Assert::AreEqual(buffer.size(), getSerializedSize(track));
+
+			Track dest;
+			deserialize(buffer, dest);
+			for (int i = 0; i < 37; ++i) {
+				auto sample = track.get<Samples>().getValue()[i];
+				Assert::IsTrue(std::fabs(dest.get<Samples>().getValue()[i] - sample) <= std::fabs(sample) / 1024.0f);
+				Assert::IsTrue(std::fabs(dest.get<Positions>().getValue()[i] - track.get<Positions>().getValue()[i]) < 2e-3f);
+				Assert::IsTrue(std::fabs(dot(dest.get<Rotations>().getValue()[i], track.get<Rotations>().getValue()[i])) > 0.9999f);
+			}
+
+			MemoryStreamReader reader(buffer.data(), buffer.size());
+			BinaryDeserializer deserializer(&reader);
+			Assert::IsTrue(deserializer.skip<Track>());
+			Assert::AreEqual(buffer.size(), reader.getPosition());
+		}
+
+		TEST_METHOD(BitPacked) {
+			Track track;
+			for (int i = 0; i < 8; ++i) {
+				track.get<Positions>().getValue().push_back(randomFloat(-5.0f, 5.0f));
+			}
+			GrowableMemoryStreamWriter writer;
+			BitPackedSerializer serializer(&writer);
+			Assert::IsTrue(serializer.serialize(track));
+			Assert::IsTrue(serializer.flush());
+			//Three 8 bit counts and 8 values of 12 bits
+			Assert::AreEqual(static_cast<size_t>(3 + 12), writer.size());
+
+			Track dest;
+			MemoryStreamReader reader(writer.data(), writer.size());
+			BitPackedDeserializer deserializer(&reader);
+			Assert::IsTrue(deserializer.deserialize(dest));
+			for (int i = 0; i < 8; ++i) {
+				Assert::IsTrue(std::fabs(dest.get<Positions>().getValue()[i] - track.get<Positions>().getValue()[i]) < 2e-3f);
+			}
+		}
+
+		TEST_METHOD(RejectsOutOfRangeWire) {
+			QuantizedFloatField<RoomRange, 12, X> field;
+			uint16_t wire = 4096;
+			MemoryStreamReader reader(reinterpret_cast<const uint8_t*>(&wire), sizeof(wire));
+			BinaryDeserializer deserializer(&reader);
+			Assert::IsFalse(deserializer.deserialize(field));
+		}
+	};
+}
@@ -0,0 +1,228 @@
+#include "stdafx.h"
+#include "CppUnitTest.h"
+
+#include <ctime>
+#include <vector>
+#include "AntilatencySerialization/Fields.h"
+#include "AntilatencySerialization/Structures.h"
+#include "AntilatencySerialization/BinarySerialization.h"
+#include "AntilatencySerialization/FrameStream.h"
+#include "AntilatencySerialization/UserStream.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+using namespace Antilatency::Serialization;
+
+namespace SerializationTest
+{
+	namespace FrameStreamTestTypes {
+		SERIALIZATION_MAKE_FIELD_NAME(Id);
+		SERIALIZATION_MAKE_FIELD_NAME(Values);
+
+		using Message = Structure<
+			SingleField<uint32_t, Id>,
+			VectorField<uint16_t, Values>
+		>;
+	}
+
+	using namespace FrameStreamTestTypes;
+
+	TEST_CLASS(FrameStreamTest)
+	{
+		TEST_CLASS_INITIALIZE(Init) {
+			srand(static_cast<unsigned>(time(nullptr)));
+		}
+
+		static Message makeMessage(uint32_t id, size_t maxValues = 60) {
+			Message message;
+			message.get<Id>().setValue(id);
+			auto count = rand() % (maxValues + 1);
+			for (size_t i = 0; i < count; ++i) {
+				message.get<Values>().getValue().push_back(static_cast<uint16_t>(rand()));
+			}
+			return message;
+		}
+
+		static std::vector<uint8_t> write(const std::vector<Message>& messages, bool useChecksum, size_t* writeCount = nullptr) {
+			std::vector<uint8_t> data;
+			size_t count = 0;
+			UserStreamWriter userWriter([&data, &count](const uint8_t* buffer, size_t size) {
+				data.insert(data.end(), buffer, buffer + size);
+				++count;
+				return true;
+			});
+			FrameWriter frameWriter(&userWriter, 1024, useChecksum);
+			BinarySerializer serializer(&frameWriter);
+			for (auto& message : messages) {
+				Assert::IsTrue(serializer.serialize(message));
+				Assert::IsTrue(frameWriter.endFrame());
+			}
+			Assert::IsTrue(frameWriter.flush());
+			Assert::AreEqual(static_cast<size_t>(0), frameWriter.getBufferedSize());
+			if (writeCount != nullptr) {
+				*writeCount = count;
+			}
+			return data;
+		}
+
+		//Ids of the messages found in data
+		static std::vector<uint32_t> read(const std::vector<uint8_t>& data, bool useChecksum) {
+			MemoryStreamReader reader(data.data(), data.size());
+			FrameReader frameReader(&reader, 1024, useChecksum);
+			BinaryDeserializer deserializer(&frameReader);
+			std::vector<uint32_t> ids;
+			while (frameReader.nextFrame()) {
+				Message message;
+				if (deserializer.deserialize(message) && frameReader.getRemainingSize() == 0) {
+					ids.push_back(message.get<Id>().getValue());
+				}
+			}
+			return ids;
+		}
+
+	public:
+		TEST_METHOD(RoundTrip) {
+			for (bool useChecksum : { true, false }) {
+				std::vector<Message> messages;
+				for (uint32_t i = 0; i < 200; ++i) {
+					messages.push_back(makeMessage(i));
+				}
+				size_t writeCount;
+				auto data = write(messages, useChecksum, &writeCount);
+				//Frames are batched up to the buffer size
+				Assert::IsTrue(writeCount <= data.size() / (1024 - 2 * 128) + 1);
+
+				MemoryStreamReader reader(data.data(), data.size());
+				FrameReader frameReader(&reader, 1024, useChecksum);
+				BinaryDeserializer deserializer(&frameReader);
+				for (auto& message : messages) {
+					Assert::IsTrue(frameReader.nextFrame());
+					Message dest;
+					Assert::IsTrue(deserializer.deserialize(dest));
+					Assert::AreEqual(static_cast<size_t>(0), frameReader.getRemainingSize());
+					Assert::AreEqual(message.get<Id>().getValue(), dest.get<Id>().getValue());
+					Assert::IsTrue(message.get<Values>().getValue() == dest.get<Values>().getValue());
+				}
+				Assert::IsFalse(frameReader.nextFrame());
+				Assert::AreEqual(static_cast<uint64_t>(0), frameReader.getDroppedSize());
+			}
+		}
+
+		TEST_METHOD(UnreadPayloadIsSkipped) {
+			std::vector<Message> messages = { makeMessage(1), makeMessage(2) };
+			auto data = write(messages, true);
+			MemoryStreamReader reader(data.data(), data.size());
+			FrameReader frameReader(&reader, 1024);
+			Assert::IsTrue(frameReader.nextFrame());
+			uint8_t byte;
+			Assert::IsTrue(frameReader.read(&byte, 1));
+			Assert::IsTrue(frameReader.nextFrame());
+			BinaryDeserializer deserializer(&frameReader);
+			Message dest;
+			Assert::IsTrue(deserializer.deserialize(dest));
+			Assert::AreEqual(2u, dest.get<Id>().getValue());
+			//Reads stop at the end of the frame
+			Assert::IsFalse(frameReader.read(&byte, 1));
+		}
+
+		TEST_METHOD(ResyncAfterDamage) {
+			std::vector<Message> messages;
+			for (uint32_t i = 0; i < 100; ++i) {
+				messages.push_back(makeMessage(i));
+			}
+			auto data = write(messages, true);
+			for (int attempt = 0; attempt < 100; ++attempt) {
+				auto damaged = data;
+				auto position = rand() % damaged.size();
+				switch (attempt % 3) {
+				case 0:
+					damaged[position] ^= static_cast<uint8_t>(1 + rand() % 255);
+					break;
+				case 1: {
+					//Frames take at least 12 bytes, so up to two of them
+					size_t size = 1 + rand() % 10;
+					damaged.erase(damaged.begin() + position, damaged.begin() + (position + size < damaged.size() ? position + size : damaged.size()));
+					break;
+				}
+				default:
+					for (int i = 0; i < 30; ++i) {
+						damaged.insert(damaged.begin() + position, static_cast<uint8_t>(rand()));
+					}
+					break;
+				}
+				auto ids = read(damaged, true);
+				//At most the damaged frames are lost, the rest arrive in order
+				Assert::IsTrue(ids.size() >= messages.size() - 2);
+				for (size_t i = 1; i < ids.size(); ++i) {
+					Assert::IsTrue(ids[i - 1] < ids[i]);
+				}
+			}
+		}
+
+		TEST_METHOD(PartialArrival) {
+			std::vector<Message> messages;
+			for (uint32_t i = 0; i < 50; ++i) {
+				messages.push_back(makeMessage(i));
+			}
+			auto data = write(messages, true);
+
+			//Non-blocking source: hands out what has arrived so far
+			size_t arrived = 0;
+			size_t position = 0;
+			UserStreamReader userReader([](uint8_t*, size_t) {
+				return false;
+			}, [&](uint8_t* buffer, size_t maxSize) {
+				auto size = arrived - position < maxSize ? arrived - position : maxSize;
+				memcpy(buffer, data.data() + position, size);
+				position += size;
+				return size;
+			});
+			FrameReader frameReader(&userReader, 1024);
+			BinaryDeserializer deserializer(&frameReader);
+			size_t received = 0;
+			while (arrived < data.size()) {
+				arrived += 1 + rand() % 40;
+				if (arrived > data.size()) {
+					arrived = data.size();
+				}
+				while (frameReader.nextFrame()) {
+					Message dest;
+					Assert::IsTrue(deserializer.deserialize(dest));
+					Assert::AreEqual(messages[received].get<Id>().getValue(), dest.get<Id>().getValue());
+					++received;
+				}
+			}
+			Assert::AreEqual(messages.size(), received);
+			Assert::AreEqual(static_cast<uint64_t>(0), frameReader.getDroppedSize());
+		}
+
+		TEST_METHOD(Overflow) {
+			std::vector<uint8_t> data;
+			UserStreamWriter userWriter([&data](const uint8_t* buffer, size_t size) {
+				data.insert(data.end(), buffer, buffer + size);
+				return true;
+			});
+			FrameWriter frameWriter(&userWriter, 64);
+			std::vector<uint8_t> payload(64 - Framing::MaxOverhead);
+			//Largest frame fits even behind other frames
+			Assert::IsTrue(frameWriter.write(payload.data(), 10));
+			Assert::IsTrue(frameWriter.endFrame());
+			Assert::IsTrue(frameWriter.write(payload.data(), payload.size()));
+			Assert::IsTrue(frameWriter.endFrame());
+			//One byte more does not, the frame is dropped
+			Assert::IsFalse(frameWriter.write(payload.data(), payload.size() + 1));
+			Assert::IsFalse(frameWriter.endFrame());
+			Assert::IsTrue(frameWriter.write(payload.data(), 3));
+			Assert::IsTrue(frameWriter.endFrame());
+			Assert::IsTrue(frameWriter.flush());
+
+			MemoryStreamReader reader(data.data(), data.size());
+			FrameReader frameReader(&reader, payload.size());
+			for (size_t size : { static_cast<size_t>(10), payload.size(), static_cast<size_t>(3) }) {
+				Assert::IsTrue(frameReader.nextFrame());
+				Assert::AreEqual(size, frameReader.getRemainingSize());
+			}
+			Assert::IsFalse(frameReader.nextFrame());
+		}
+	};
+}
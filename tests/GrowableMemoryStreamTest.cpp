@@ -0,0 +1,80 @@
+#include "stdafx.h"
+#include "CppUnitTest.h"
+#include <array>
+
+#include <ctime>
+#include <vector>
+#include "AntilatencySerialization/BinarySerialization.h"
+#include "AntilatencySerialization/GrowableMemoryStream.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+using namespace Antilatency::Serialization;
+
+namespace SerializationTest
+{
+	TEST_CLASS(GrowableMemoryStreamTest)
+	{
+		TEST_CLASS_INITIALIZE(Init) {
+			srand(static_cast<unsigned>(time(nullptr)));
+		}
+
+	public:
+		static std::vector<int32_t> makeValues(size_t count) {
+			std::vector<int32_t> values;
+			for (size_t i = 0; i < count; ++i) {
+				values.push_back(rand());
+			}
+			return values;
+		}
+
+		static std::vector<uint8_t> serializeFixed(const std::vector<int32_t>& values) {
+			MemorySizeCounterStream counterStream;
+			BinarySerializer counter(&counterStream);
+			counter.serialize(values);
+			std::vector<uint8_t> result(counterStream.getActualSize());
+			MemoryStreamWriter writer(result.data(), result.size());
+			BinarySerializer serializer(&writer);
+			serializer.serialize(values);
+			return result;
+		}
+
+		TEST_METHOD(SinglePass) {
+			auto values = makeValues(rand() % 1000);
+			GrowableMemoryStreamWriter writer;
+			BasicBinarySerializer<GrowableMemoryStreamWriter> serializer(&writer);
+			Assert::IsTrue(serializer.serialize(values));
+
+			auto expected = serializeFixed(values);
+			Assert::AreEqual(expected.size(), writer.size());
+			Assert::IsTrue(std::equal(expected.begin(), expected.end(), writer.data()));
+		}
+
+		TEST_METHOD(ResetKeepsCapacity) {
+			GrowableMemoryStreamWriter writer;
+			BinarySerializer serializer(&writer);
+			Assert::IsTrue(serializer.serialize(makeValues(500)));
+			auto capacity = writer.capacity();
+			writer.reset();
+			Assert::AreEqual(static_cast<size_t>(0), writer.size());
+			Assert::AreEqual(capacity, writer.capacity());
+
+			auto values = makeValues(100);
+			Assert::IsTrue(serializer.serialize(values));
+			Assert::AreEqual(capacity, writer.capacity());
+
+			auto buffer = writer.release();
+			Assert::AreEqual(static_cast<size_t>(0), writer.size());
+			Assert::IsTrue(serializeFixed(values) == buffer);
+		}
+
+		TEST_METHOD(BorrowedBuffer) {
+			std::vector<uint8_t> buffer;
+			GrowableMemoryStreamWriter writer(&buffer);
+			BinarySerializer serializer(&writer);
+			auto values = makeValues(10);
+			Assert::IsTrue(serializer.serialize(values));
+			Assert::IsTrue(serializeFixed(values) == buffer);
+		}
+	};
+}
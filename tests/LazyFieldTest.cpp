@@ -0,0 +1,212 @@
+#include "stdafx.h"
+#include "CppUnitTest.h"
+
+#include <ctime>
+#include <vector>
+#include "AntilatencySerialization/Fields.h"
+#include "AntilatencySerialization/Structures.h"
+#include "AntilatencySerialization/BinarySerialization.h"
+#include "AntilatencySerialization/LazyField.h"
+#include "AntilatencySerialization/UserStream.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+using namespace Antilatency::Serialization;
+
+namespace SerializationTest
+{
+	namespace LazyFieldTestTypes {
+		SERIALIZATION_MAKE_FIELD_NAME(Id);
+		SERIALIZATION_MAKE_FIELD_NAME(Name);
+		SERIALIZATION_MAKE_FIELD_NAME(Points);
+		SERIALIZATION_MAKE_FIELD_NAME(Samples);
+		SERIALIZATION_MAKE_FIELD_NAME(Packed);
+		SERIALIZATION_MAKE_FIELD_NAME(Comment);
+		SERIALIZATION_MAKE_FIELD_NAME(X);
+		SERIALIZATION_MAKE_FIELD_NAME(Y);
+
+		using Point = Structure<SingleField<float, X>, SingleField<float, Y>>;
+
+		template<typename T>
+		using RecordBase = VersionedStructure<2, T,
+			SingleField<Varint<int32_t>, Id>,
+			StringField<Name>,
+			VectorField<Point, Points>,
+			VectorField<Varint32, Samples>,
+			PackedIntegerVectorField<uint32_t, Packed>,
+			OptioinalField<StringField<Comment>>
+		>;
+
+		class Record : public RecordBase<Record> {
+		public:
+			template<typename Deserializer>
+			bool convertFromPreviousVersion(VersionType version, Deserializer& deserializer) {
+				//Version 1 had only Id
+				if (version != VersionType(1)) {
+					return false;
+				}
+				Varint<int32_t> id;
+				if (!deserializer.deserialize(id)) {
+					return false;
+				}
+				get<Id>().setValue(id);
+				return true;
+			}
+		};
+
+		using LazyRecord = Structure<
+			SingleField<Varint<int32_t>, Id>,
+			LazyField<StringField<Name>>,
+			LazyField<VectorField<Point, Points>>,
+			LazyField<VectorField<Varint32, Samples>>,
+			LazyField<PackedIntegerVectorField<uint32_t, Packed>>,
+			OptioinalField<StringField<Comment>>
+		>;
+	}
+
+	using namespace LazyFieldTestTypes;
+
+	TEST_CLASS(LazyFieldTest)
+	{
+		TEST_CLASS_INITIALIZE(Init) {
+			srand(static_cast<unsigned>(time(nullptr)));
+		}
+
+		static constexpr uint32_t Sentinel = 0xA5A5A5A5;
+
+		static Record makeRecord() {
+			Record record;
+			record.get<Id>().setValue(Varint<int32_t>(-rand()));
+			record.get<Name>().setValue(BaseStringType(rand() % 50, 'n'));
+			record.get<Points>().getValue().resize(rand() % 20);
+			for (int i = rand() % 100; i > 0; --i) {
+				record.get<Samples>().getValue().push_back(Varint32(static_cast<uint32_t>(rand())));
+				record.get<Packed>().getValue().push_back(static_cast<uint32_t>(rand()) << (rand() % 16));
+			}
+			if (rand() % 2) {
+				record.get<Comment>().setValue("comment");
+			}
+			return record;
+		}
+
+		template<typename T>
+		static std::vector<uint8_t> serialize(const T& value) {
+			MemorySizeCounterStream counterStream;
+			BinarySerializer counter(&counterStream);
+			Assert::IsTrue(counter.serialize(value));
+			Assert::IsTrue(counter.serialize(Sentinel));
+			std::vector<uint8_t> result(counterStream.getActualSize());
+			MemoryStreamWriter writer(result.data(), result.size());
+			BinarySerializer serializer(&writer);
+			Assert::IsTrue(serializer.serialize(value));
+			Assert::IsTrue(serializer.serialize(Sentinel));
+			return result;
+		}
+
+		template<typename T>
+		static void testSkip(const std::vector<uint8_t>& buffer) {
+			MemoryStreamReader memoryReader(buffer.data(), buffer.size());
+			BinaryDeserializer memoryDeserializer(&memoryReader);
+			uint32_t sentinel = 0;
+			Assert::IsTrue(memoryDeserializer.skip<T>());
+			Assert::IsTrue(memoryDeserializer.deserialize(sentinel));
+			Assert::AreEqual(Sentinel, sentinel);
+
+			MemoryStreamReader innerReader(buffer.data(), buffer.size());
+			UserStreamReader userReader([&innerReader](uint8_t* data, size_t size) {
+				return innerReader.read(data, size);
+			});
+			BinaryDeserializer userDeserializer(&userReader);
+			sentinel = 0;
+			Assert::IsTrue(userDeserializer.skip<T>());
+			Assert::IsTrue(userDeserializer.deserialize(sentinel));
+			Assert::AreEqual(Sentinel, sentinel);
+
+			MemoryStreamReader truncatedReader(buffer.data(), buffer.size() - sizeof(Sentinel) - 1);
+			BinaryDeserializer truncatedDeserializer(&truncatedReader);
+			Assert::IsFalse(truncatedDeserializer.skip<T>());
+		}
+
+	public:
+		TEST_METHOD(Skip) {
+			for (int i = 0; i < 50; ++i) {
+				auto record = makeRecord();
+				testSkip<Record>(serialize(record));
+				testSkip<BaseVectorType<Point>>(serialize(record.get<Points>().getValue()));
+				testSkip<BaseVectorType<Varint32>>(serialize(record.get<Samples>().getValue()));
+				testSkip<PackedIntegerVector<uint32_t>>(serialize(record.get<Packed>().getValue()));
+				testSkip<BaseStringType>(serialize(record.get<Name>().getValue()));
+			}
+		}
+
+		TEST_METHOD(SkipPreviousVersion) {
+			std::vector<uint8_t> buffer;
+			{
+				MemorySizeCounterStream counterStream;
+				BinarySerializer counter(&counterStream);
+				counter.serialize(Varint64(1));
+				counter.serialize(Varint<int32_t>(-5));
+				counter.serialize(Sentinel);
+				buffer.resize(counterStream.getActualSize());
+				MemoryStreamWriter writer(buffer.data(), buffer.size());
+				BinarySerializer serializer(&writer);
+				serializer.serialize(Varint64(1));
+				serializer.serialize(Varint<int32_t>(-5));
+				serializer.serialize(Sentinel);
+			}
+			testSkip<Record>(buffer);
+		}
+
+		TEST_METHOD(DecodeOnAccess) {
+			auto record = makeRecord();
+			auto buffer = serialize(static_cast<const RecordBase<Record>::Structure&>(record));
+
+			MemoryStreamReader reader(buffer.data(), buffer.size());
+			BinaryDeserializer deserializer(&reader);
+			LazyRecord lazy;
+			Assert::IsTrue(deserializer.deserialize(lazy));
+			Assert::IsFalse(lazy.get<Points>().isDecoded());
+			Assert::IsTrue(lazy.get<Id>().getValue() == record.get<Id>().getValue());
+
+			Assert::AreEqual(record.get<Points>().getValue().size(), lazy.get<Points>().getValue().size());
+			Assert::IsTrue(lazy.get<Points>().isDecoded());
+			Assert::IsTrue(record.get<Samples>().getValue() == lazy.get<Samples>().getValue());
+			Assert::IsFalse(lazy.get<Packed>().isDecoded());
+
+			Assert::IsTrue(buffer == serialize(lazy));
+		}
+
+		TEST_METHOD(CopiedFromStream) {
+			auto record = makeRecord();
+			auto buffer = serialize(static_cast<const RecordBase<Record>::Structure&>(record));
+
+			LazyRecord lazy;
+			{
+				std::vector<uint8_t> temporary(buffer);
+				MemoryStreamReader innerReader(temporary.data(), temporary.size());
+				UserStreamReader userReader([&innerReader](uint8_t* data, size_t size) {
+					return innerReader.read(data, size);
+				});
+				BinaryDeserializer deserializer(&userReader);
+				Assert::IsTrue(deserializer.deserialize(lazy));
+			}
+			LazyRecord copy = lazy;
+			Assert::IsTrue(record.get<Name>().getValue() == copy.get<Name>().getValue());
+			Assert::IsTrue(record.get<Packed>().getValue() == copy.get<Packed>().getValue());
+			Assert::IsTrue(buffer == serialize(copy));
+		}
+
+		TEST_METHOD(BrokenBytes) {
+			auto record = makeRecord();
+			record.get<Points>().getValue().resize(3);
+			auto buffer = serialize(record.get<Points>());
+			buffer[0] = 100;
+
+			MemoryStreamReader reader(buffer.data(), buffer.size());
+			BinaryDeserializer deserializer(&reader);
+			LazyField<VectorField<Point, Points>> lazy;
+			Assert::IsFalse(deserializer.deserialize(lazy));
+			Assert::IsFalse(lazy.decode());
+		}
+	};
+}
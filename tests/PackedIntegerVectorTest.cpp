@@ -0,0 +1,129 @@
+#include "stdafx.h"
+#include "CppUnitTest.h"
+#include <array>
+
+#include <ctime>
+#include <limits>
+#include <vector>
+#include "AntilatencySerialization/BinarySerialization.h"
+#include "AntilatencySerialization/PackedIntegerVector.h"
+#include "AntilatencySerialization/UserStream.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+using namespace Antilatency::Serialization;
+
+namespace SerializationTest
+{
+	TEST_CLASS(PackedIntegerVectorTest)
+	{
+		TEST_CLASS_INITIALIZE(Init) {
+			srand(static_cast<unsigned>(time(nullptr)));
+		}
+
+	public:
+		static uint32_t randomValue() {
+			return ((static_cast<uint32_t>(rand()) << 16) ^ static_cast<uint32_t>(rand())) >> (rand() % 32);
+		}
+
+		template<typename T>
+		static std::vector<uint8_t> serialize(const T& value) {
+			MemorySizeCounterStream counterStream;
+			BinarySerializer counter(&counterStream);
+			Assert::IsTrue(counter.serialize(value));
+			std::vector<uint8_t> result(counterStream.getActualSize());
+			MemoryStreamWriter writer(result.data(), result.size());
+			BinarySerializer serializer(&writer);
+			Assert::IsTrue(serializer.serialize(value));
+			return result;
+		}
+
+		template<typename T>
+		static void testValue(const PackedIntegerVector<T>& value) {
+			auto buffer = serialize(value);
+
+			//Writers without memory get the same bytes, a chunk at a time
+			std::vector<uint8_t> userBuffer;
+			size_t maxWriteSize = 0;
+			UserStreamWriter userWriter([&userBuffer, &maxWriteSize](const uint8_t* data, size_t size) {
+				userBuffer.insert(userBuffer.end(), data, data + size);
+				maxWriteSize = size > maxWriteSize ? size : maxWriteSize;
+				return true;
+			});
+			BinarySerializer userSerializer(&userWriter);
+			Assert::IsTrue(userSerializer.serialize(value));
+			Assert::IsTrue(buffer == userBuffer);
+			Assert::IsTrue(maxWriteSize <= StreamVByte::getMaxDataSize(StreamVByte::ChunkSize));
+
+			MemoryStreamReader reader(buffer.data(), buffer.size());
+			BinaryDeserializer deserializer(&reader);
+			PackedIntegerVector<T> dest;
+			Assert::IsTrue(deserializer.deserialize(dest));
+			Assert::IsTrue(value == dest);
+
+			MemoryStreamReader memoryReader(buffer.data(), buffer.size());
+			UserStreamReader userReader([&memoryReader](uint8_t* data, size_t size) {
+				return memoryReader.read(data, size);
+			});
+			BinaryDeserializer userDeserializer(&userReader);
+			PackedIntegerVector<T> userDest;
+			Assert::IsTrue(userDeserializer.deserialize(userDest));
+			Assert::IsTrue(value == userDest);
+		}
+
+		TEST_METHOD(Sizes) {
+			for (size_t count = 0; count < 600; count += 1 + count / 10) {
+				PackedIntegerVector<uint32_t> value;
+				for (size_t i = 0; i < count; ++i) {
+					value.push_back(randomValue());
+				}
+				testValue(value);
+			}
+		}
+
+		TEST_METHOD(Signed) {
+			PackedIntegerVector<int32_t> value;
+			value.push_back(std::numeric_limits<int32_t>::min());
+			value.push_back(std::numeric_limits<int32_t>::max());
+			for (size_t i = 0; i < 1000; ++i) {
+				value.push_back(static_cast<int32_t>(randomValue() - randomValue()));
+			}
+			testValue(value);
+		}
+
+		TEST_METHOD(ScalarIdentical) {
+			std::vector<uint32_t> values;
+			for (size_t i = 0; i < 1001; ++i) {
+				values.push_back(randomValue());
+			}
+			std::vector<uint8_t> control(StreamVByte::getControlSize(values.size()));
+			std::vector<uint8_t> data(StreamVByte::getMaxDataSize(values.size()) + StreamVByte::EncodeSlack);
+			std::vector<uint8_t> scalarControl(control.size());
+			std::vector<uint8_t> scalarData(data.size());
+
+			auto dataSize = StreamVByte::encode(values.data(), values.size(), control.data(), data.data());
+			auto scalarDataSize = StreamVByte::encodeScalar(values.data(), values.size(), scalarControl.data(), scalarData.data());
+			Assert::AreEqual(scalarDataSize, dataSize);
+			Assert::IsTrue(control == scalarControl);
+			Assert::IsTrue(std::equal(data.begin(), data.begin() + dataSize, scalarData.begin()));
+
+			std::vector<uint32_t> decoded(values.size());
+			Assert::AreEqual(dataSize, StreamVByte::decode(control.data(), data.data(), dataSize, values.size(), decoded.data()));
+			Assert::IsTrue(values == decoded);
+			Assert::AreEqual(dataSize, StreamVByte::decodeScalar(control.data(), data.data(), dataSize, values.size(), decoded.data()));
+			Assert::IsTrue(values == decoded);
+		}
+
+		TEST_METHOD(Truncated) {
+			PackedIntegerVector<uint32_t> value;
+			for (size_t i = 0; i < 100; ++i) {
+				value.push_back(randomValue());
+			}
+			auto buffer = serialize(value);
+			MemoryStreamReader reader(buffer.data(), buffer.size() - 1);
+			BinaryDeserializer deserializer(&reader);
+			PackedIntegerVector<uint32_t> dest;
+			Assert::IsFalse(deserializer.deserialize(dest));
+		}
+	};
+}
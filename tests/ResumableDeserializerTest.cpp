@@ -0,0 +1,217 @@
+#include "stdafx.h"
+#include "CppUnitTest.h"
+
+#include <ctime>
+#include <vector>
+#include "AntilatencySerialization/Fields.h"
+#include "AntilatencySerialization/Structures.h"
+#include "AntilatencySerialization/BinarySerialization.h"
+#include "AntilatencySerialization/GrowableMemoryStream.h"
+#include "AntilatencySerialization/ResumableDeserializer.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+using namespace Antilatency::Serialization;
+
+namespace SerializationTest
+{
+	namespace ResumableDeserializerTestTypes {
+		SERIALIZATION_MAKE_FIELD_NAME(Id);
+		SERIALIZATION_MAKE_FIELD_NAME(Name);
+		SERIALIZATION_MAKE_FIELD_NAME(Points);
+		SERIALIZATION_MAKE_FIELD_NAME(Samples);
+		SERIALIZATION_MAKE_FIELD_NAME(Tags);
+		SERIALIZATION_MAKE_FIELD_NAME(Packed);
+		SERIALIZATION_MAKE_FIELD_NAME(Comment);
+		SERIALIZATION_MAKE_FIELD_NAME(Weight);
+		SERIALIZATION_MAKE_FIELD_NAME(X);
+		SERIALIZATION_MAKE_FIELD_NAME(Y);
+
+		using Point = Structure<SingleField<float, X>, SingleField<float, Y>>;
+
+		using Tag = Structure<
+			StringField<Name>,
+			OptioinalField<SingleField<Varint32, Weight>>
+		>;
+
+		class Record : public VersionedStructure<2, Record,
+			SingleField<Varint<int32_t>, Id>,
+			StringField<Name>,
+			VectorField<Point, Points>,
+			VectorField<Varint32, Samples>,
+			VectorField<Tag, Tags>,
+			PackedIntegerVectorField<uint32_t, Packed>,
+			OptioinalField<StringField<Comment>>
+		> {
+		public:
+			template<typename Deserializer>
+			bool convertFromPreviousVersion(VersionType version, Deserializer& deserializer) {
+				//Version 1 had only Id
+				if (version != VersionType(1)) {
+					return false;
+				}
+				Varint<int32_t> id;
+				if (!deserializer.deserialize(id)) {
+					return false;
+				}
+				get<Id>().setValue(id);
+				return true;
+			}
+		};
+	}
+
+	using namespace ResumableDeserializerTestTypes;
+
+	TEST_CLASS(ResumableDeserializerTest)
+	{
+		TEST_CLASS_INITIALIZE(Init) {
+			srand(static_cast<unsigned>(time(nullptr)));
+		}
+
+		static Record makeRecord() {
+			Record record;
+			record.get<Id>().setValue(Varint<int32_t>(rand() - RAND_MAX / 2));
+			record.get<Name>().setValue(BaseStringType(rand() % 200, 'n'));
+			record.get<Points>().getValue().resize(rand() % 20);
+			for (int i = rand() % 50; i > 0; --i) {
+				//Up to five bytes each, so varints are split between feeds
+				record.get<Samples>().getValue().push_back(Varint32(static_cast<uint32_t>(rand()) << (rand() % 16)));
+				record.get<Packed>().getValue().push_back(static_cast<uint32_t>(rand()) << (rand() % 16));
+			}
+			for (int i = rand() % 5; i > 0; --i) {
+				Tag tag;
+				tag.get<Name>().setValue("tag");
+				if (rand() % 2) {
+					tag.get<Weight>().setValue(Varint32(static_cast<uint32_t>(rand())));
+				}
+				record.get<Tags>().getValue().push_back(tag);
+			}
+			if (rand() % 2) {
+				record.get<Comment>().setValue("comment");
+			}
+			return record;
+		}
+
+		static void assertEqual(const Record& expected, const Record& actual) {
+			Assert::AreEqual(expected.get<Id>().getValue().getValue(), actual.get<Id>().getValue().getValue());
+			Assert::IsTrue(expected.get<Name>().getValue() == actual.get<Name>().getValue());
+			Assert::AreEqual(expected.get<Points>().getValue().size(), actual.get<Points>().getValue().size());
+			Assert::IsTrue(expected.get<Samples>().getValue() == actual.get<Samples>().getValue());
+			Assert::IsTrue(expected.get<Packed>().getValue() == actual.get<Packed>().getValue());
+			auto& expectedTags = expected.get<Tags>().getValue();
+			auto& actualTags = actual.get<Tags>().getValue();
+			Assert::AreEqual(expectedTags.size(), actualTags.size());
+			for (size_t i = 0; i < expectedTags.size(); ++i) {
+				Assert::AreEqual(expectedTags[i].get<Weight>().isExists(), actualTags[i].get<Weight>().isExists());
+				if (expectedTags[i].get<Weight>().isExists()) {
+					Assert::AreEqual(expectedTags[i].get<Weight>().getValue().getValue(), actualTags[i].get<Weight>().getValue().getValue());
+				}
+			}
+			Assert::AreEqual(expected.get<Comment>().isExists(), actual.get<Comment>().isExists());
+		}
+
+		static std::vector<uint8_t> serialize(const std::vector<Record>& records) {
+			GrowableMemoryStreamWriter writer;
+			BinarySerializer serializer(&writer);
+			for (auto& record : records) {
+				Assert::IsTrue(serializer.serialize(record));
+			}
+			return std::vector<uint8_t>(writer.data(), writer.data() + writer.size());
+		}
+
+	public:
+		TEST_METHOD(ByteByByte) {
+			for (int i = 0; i < 20; ++i) {
+				auto record = makeRecord();
+				auto data = serialize({ record });
+				ResumableDeserializer<Record> deserializer;
+				for (size_t j = 0; j + 1 < data.size(); ++j) {
+					Assert::IsTrue(deserializer.feed(&data[j], 1) == FeedResult::NeedMoreData);
+					Assert::AreEqual(static_cast<size_t>(1), deserializer.getUsedSize());
+				}
+				Assert::IsTrue(deserializer.feed(&data.back(), 1) == FeedResult::Done);
+				Assert::AreEqual(data.size(), deserializer.getBufferedSize());
+				assertEqual(record, deserializer.getValue());
+				//Stays done until reset
+				Assert::IsTrue(deserializer.feed(data.data(), data.size()) == FeedResult::Done);
+				Assert::AreEqual(static_cast<size_t>(0), deserializer.getUsedSize());
+			}
+		}
+
+		TEST_METHOD(RandomChunks) {
+			std::vector<Record> records;
+			for (int i = 0; i < 100; ++i) {
+				records.push_back(makeRecord());
+			}
+			auto data = serialize(records);
+			ResumableDeserializer<Record> deserializer;
+			size_t received = 0;
+			size_t position = 0;
+			while (position < data.size()) {
+				size_t size = 1 + rand() % 300;
+				if (size > data.size() - position) {
+					size = data.size() - position;
+				}
+				//Chunks can hold the end of one message and the start of the next
+				while (size != 0) {
+					auto result = deserializer.feed(data.data() + position, size);
+					Assert::IsTrue(result != FeedResult::Error);
+					position += deserializer.getUsedSize();
+					size -= deserializer.getUsedSize();
+					if (result == FeedResult::Done) {
+						assertEqual(records[received++], deserializer.getValue());
+						deserializer.reset();
+					}
+				}
+			}
+			Assert::AreEqual(records.size(), received);
+			Assert::AreEqual(static_cast<size_t>(0), deserializer.getBufferedSize());
+		}
+
+		TEST_METHOD(PreviousVersion) {
+			GrowableMemoryStreamWriter writer;
+			BinarySerializer serializer(&writer);
+			Assert::IsTrue(serializer.serialize(Varint64(1)));
+			Assert::IsTrue(serializer.serialize(Varint<int32_t>(-100000)));
+			Assert::IsTrue(serializer.serialize(Varint64(3)));
+			ResumableDeserializer<Record> deserializer;
+			auto data = writer.data();
+			for (size_t i = 0; i + 1 < writer.size() - 1; ++i) {
+				Assert::IsTrue(deserializer.feed(data + i, 1) == FeedResult::NeedMoreData);
+			}
+			Assert::IsTrue(deserializer.feed(data + writer.size() - 2, 2) == FeedResult::Done);
+			Assert::AreEqual(static_cast<size_t>(1), deserializer.getUsedSize());
+			Assert::AreEqual(-100000, deserializer.getValue().get<Id>().getValue().getValue());
+
+			//Version 3 is unknown
+			deserializer.reset();
+			Assert::IsTrue(deserializer.feed(data + writer.size() - 1, 1) == FeedResult::Error);
+		}
+
+		TEST_METHOD(Errors) {
+			auto data = serialize({ makeRecord() });
+			{
+				//Varint32 of six bytes
+				ResumableDeserializer<Varint32> deserializer;
+				const uint8_t varint[] = { 0x80, 0x80, 0x80, 0x80, 0x80, 0x01 };
+				Assert::IsTrue(deserializer.feed(varint, 4) == FeedResult::NeedMoreData);
+				Assert::IsTrue(deserializer.feed(varint + 4, 2) == FeedResult::Error);
+			}
+			{
+				//More items than can fit
+				ResumableDeserializer<BaseVectorType<Varint32>> deserializer(100);
+				const uint8_t count[] = { 0xE8, 0x07 };
+				Assert::IsTrue(deserializer.feed(count, sizeof(count)) == FeedResult::Error);
+			}
+			{
+				ResumableDeserializer<Record> deserializer(data.size() - 1);
+				Assert::IsTrue(deserializer.feed(data.data(), data.size()) == FeedResult::Error);
+				Assert::AreEqual(data.size() - 1, deserializer.getUsedSize());
+			}
+			{
+				ResumableDeserializer<Record> deserializer(data.size());
+				Assert::IsTrue(deserializer.feed(data.data(), data.size()) == FeedResult::Done);
+			}
+		}
+	};
+}
@@ -0,0 +1,107 @@
+#include "stdafx.h"
+#include "CppUnitTest.h"
+
+#include <ctime>
+#include <limits>
+#include "AntilatencySerialization/Fields.h"
+#include "AntilatencySerialization/Structures.h"
+#include "AntilatencySerialization/BinarySerialization.h"
+#include "AntilatencySerialization/SizeCalculator.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+using namespace Antilatency::Serialization;
+
+namespace SerializationTest
+{
+	SERIALIZATION_MAKE_FIELD_NAME(X);
+	SERIALIZATION_MAKE_FIELD_NAME(Y);
+	SERIALIZATION_MAKE_FIELD_NAME(Id);
+	SERIALIZATION_MAKE_FIELD_NAME(Flag);
+	SERIALIZATION_MAKE_FIELD_NAME(Point);
+	SERIALIZATION_MAKE_FIELD_NAME(Text);
+	SERIALIZATION_MAKE_FIELD_NAME(Points);
+	SERIALIZATION_MAKE_FIELD_NAME(Samples);
+	SERIALIZATION_MAKE_FIELD_NAME(Packed);
+
+	using SizePoint = Structure<SingleField<float, X>, SingleField<float, Y>>;
+
+	class SizePacket : public VersionedStructure<300, SizePacket,
+		SingleField<Varint<int32_t>, Id>,
+		OptioinalField<SingleField<bool, Flag>>,
+		SingleField<SizePoint, Point>
+	> {
+	public:
+		template<typename Deserializer>
+		bool convertFromPreviousVersion(VersionType, Deserializer&) {
+			return false;
+		}
+	};
+
+	static_assert(maxSerializedSize<SizePoint>() == 8, "Wrong size of fixed structure");
+	static_assert(maxSerializedSize<SizePacket>() == 2 + 5 + 2 + 8, "Wrong size of versioned structure");
+
+	TEST_CLASS(SizeCalculatorTest)
+	{
+		TEST_CLASS_INITIALIZE(Init) {
+			srand(static_cast<unsigned>(time(nullptr)));
+		}
+
+		using Mixed = Structure<
+			SingleField<Varint<int64_t>, Id>,
+			StringField<Text>,
+			VectorField<SizePoint, Points>,
+			VectorField<Varint32, Samples>,
+			PackedIntegerVectorField<int32_t, Packed>
+		>;
+
+		template<typename T>
+		static size_t countSize(const T& value) {
+			MemorySizeCounterStream counterStream;
+			BinarySerializer serializer(&counterStream);
+			Assert::IsTrue(serializer.serialize(value));
+			return counterStream.getActualSize();
+		}
+
+	public:
+		TEST_METHOD(MatchesCounterStream) {
+			for (int iteration = 0; iteration < 100; ++iteration) {
+				Mixed value;
+				value.get<Id>().setValue(Varint<int64_t>(static_cast<int64_t>(rand()) - RAND_MAX / 2));
+				value.get<Text>().setValue(BaseStringType(rand() % 300, 'a'));
+				value.get<Points>().getValue().resize(rand() % 50);
+				for (int i = rand() % 100; i > 0; --i) {
+					value.get<Samples>().getValue().push_back(Varint32(static_cast<uint32_t>(rand()) << (rand() % 16)));
+					value.get<Packed>().getValue().push_back(rand() - RAND_MAX / 2);
+				}
+				Assert::AreEqual(countSize(value), getSerializedSize(value));
+			}
+		}
+
+		TEST_METHOD(FixedStructureBound) {
+			SizePacket packet;
+			packet.get<Id>().setValue(Varint<int32_t>(std::numeric_limits<int32_t>::min()));
+			packet.get<Flag>().setValue(true);
+			Assert::AreEqual(maxSerializedSize<SizePacket>(), getSerializedSize(packet));
+			Assert::AreEqual(countSize(packet), getSerializedSize(packet));
+
+			uint8_t buffer[maxSerializedSize<SizePacket>()];
+			MemoryStreamWriter writer(buffer, sizeof(buffer));
+			BinarySerializer serializer(&writer);
+			Assert::IsTrue(serializer.serialize(packet));
+		}
+
+		TEST_METHOD(SignedVarintSize) {
+			Assert::AreEqual(static_cast<size_t>(1), Varint<int32_t>(-1).getActualSize());
+			Assert::AreEqual(static_cast<size_t>(1), Varint<int32_t>(-64).getActualSize());
+			Assert::AreEqual(static_cast<size_t>(2), Varint<int32_t>(-65).getActualSize());
+			Assert::AreEqual(static_cast<size_t>(5), Varint<int32_t>(std::numeric_limits<int32_t>::min()).getActualSize());
+			Assert::AreEqual(static_cast<size_t>(10), Varint<int64_t>(std::numeric_limits<int64_t>::min()).getActualSize());
+			for (int i = 0; i < 1000; ++i) {
+				Varint<int32_t> value(rand() - RAND_MAX / 2);
+				Assert::AreEqual(countSize(value), value.getActualSize());
+				Assert::AreEqual(Varint<int32_t>::getEncodedSize(value.getValue()), value.getActualSize());
+			}
+		}
+	};
+}
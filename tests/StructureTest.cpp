@@ -0,0 +1,143 @@
+#include "stdafx.h"
+#include "CppUnitTest.h"
+
+#include <ctime>
+#include <vector>
+#include "AntilatencySerialization/Fields.h"
+#include "AntilatencySerialization/Structures.h"
+#include "AntilatencySerialization/BinarySerialization.h"
+#include "AntilatencySerialization/SizeCalculator.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+using namespace Antilatency::Serialization;
+
+namespace SerializationTest
+{
+	SERIALIZATION_MAKE_FIELD_NAME(Width);
+	SERIALIZATION_MAKE_FIELD_NAME(Count);
+	SERIALIZATION_MAKE_FIELD_NAME(Title);
+	SERIALIZATION_MAKE_FIELD_NAME(Extra);
+
+#define STRUCTURE_TEST_NAMES_8(prefix) \
+	SERIALIZATION_MAKE_FIELD_NAME(prefix##0); SERIALIZATION_MAKE_FIELD_NAME(prefix##1); \
+	SERIALIZATION_MAKE_FIELD_NAME(prefix##2); SERIALIZATION_MAKE_FIELD_NAME(prefix##3); \
+	SERIALIZATION_MAKE_FIELD_NAME(prefix##4); SERIALIZATION_MAKE_FIELD_NAME(prefix##5); \
+	SERIALIZATION_MAKE_FIELD_NAME(prefix##6); SERIALIZATION_MAKE_FIELD_NAME(prefix##7)
+
+#define STRUCTURE_TEST_FIELDS_8(prefix) \
+	Int32Field<prefix##0>, SingleField<Varint32, prefix##1>, Int32Field<prefix##2>, Int32Field<prefix##3>, \
+	Int32Field<prefix##4>, SingleField<Varint32, prefix##5>, Int32Field<prefix##6>, Int32Field<prefix##7>
+
+	STRUCTURE_TEST_NAMES_8(A); STRUCTURE_TEST_NAMES_8(B); STRUCTURE_TEST_NAMES_8(C); STRUCTURE_TEST_NAMES_8(D);
+	STRUCTURE_TEST_NAMES_8(E); STRUCTURE_TEST_NAMES_8(F); STRUCTURE_TEST_NAMES_8(G); STRUCTURE_TEST_NAMES_8(H);
+	STRUCTURE_TEST_NAMES_8(I); STRUCTURE_TEST_NAMES_8(J); STRUCTURE_TEST_NAMES_8(K); STRUCTURE_TEST_NAMES_8(L);
+	STRUCTURE_TEST_NAMES_8(M);
+
+	using WideStructure = Structure<
+		STRUCTURE_TEST_FIELDS_8(A), STRUCTURE_TEST_FIELDS_8(B), STRUCTURE_TEST_FIELDS_8(C), STRUCTURE_TEST_FIELDS_8(D),
+		STRUCTURE_TEST_FIELDS_8(E), STRUCTURE_TEST_FIELDS_8(F), STRUCTURE_TEST_FIELDS_8(G), STRUCTURE_TEST_FIELDS_8(H),
+		STRUCTURE_TEST_FIELDS_8(I), STRUCTURE_TEST_FIELDS_8(J), STRUCTURE_TEST_FIELDS_8(K), STRUCTURE_TEST_FIELDS_8(L),
+		STRUCTURE_TEST_FIELDS_8(M)
+	>;
+
+	using OptionalStructure = Structure<
+		OptioinalField<Int32Field<B0>>, OptioinalField<Int32Field<B1>>, OptioinalField<Int32Field<B2>>, OptioinalField<Int32Field<B3>>,
+		Int32Field<A0>,
+		OptioinalField<Int32Field<B4>>, OptioinalField<Int32Field<B5>>, OptioinalField<Int32Field<B6>>, OptioinalField<Int32Field<B7>>,
+		OptioinalField<Int32Field<C0>>
+	>;
+
+	using SmallStructure = Structure<Int32Field<Width>, SingleField<Varint32, Count>, StringField<Title>, OptioinalField<Int32Field<Extra>>>;
+
+	TEST_CLASS(StructureTest)
+	{
+		TEST_CLASS_INITIALIZE(Init) {
+			srand(static_cast<unsigned>(time(nullptr)));
+		}
+
+		template<typename T>
+		static std::vector<uint8_t> serialize(const T& value) {
+			MemorySizeCounterStream counterStream;
+			BinarySerializer counter(&counterStream);
+			Assert::IsTrue(counter.serialize(value));
+			std::vector<uint8_t> result(counterStream.getActualSize());
+			MemoryStreamWriter writer(result.data(), result.size());
+			BinarySerializer serializer(&writer);
+			Assert::IsTrue(serializer.serialize(value));
+			return result;
+		}
+
+	public:
+		TEST_METHOD(FieldAccess) {
+			static_assert(SmallStructure::FieldCount == 4, "Wrong field count");
+			SmallStructure value;
+			value.get<Width>().setValue(7);
+			value.get<Title>().setValue("title");
+			Assert::AreEqual(7, value.getField<0>().getValue());
+			Assert::IsTrue(&value.get<Title>() == &value.getField<2>());
+			const SmallStructure& constValue = value;
+			Assert::IsTrue(&constValue.get<Count>() == &constValue.getField<1>());
+			Assert::IsFalse(constValue.get<Extra>().isExists());
+		}
+
+		TEST_METHOD(FieldOrder) {
+			SmallStructure value;
+			value.get<Width>().setValue(0x04030201);
+			value.get<Count>().setValue(Varint32(5));
+			value.get<Title>().setValue("ab");
+			value.get<Extra>().setValue(-1);
+			const uint8_t expected[] = { 1, 1, 2, 3, 4, 5, 2, 'a', 'b', 0xFF, 0xFF, 0xFF, 0xFF };
+			Assert::IsTrue(serialize(value) == std::vector<uint8_t>(expected, expected + sizeof(expected)));
+		}
+
+		TEST_METHOD(WideRoundTrip) {
+			static_assert(WideStructure::FieldCount == 104, "Wrong field count");
+			WideStructure value;
+			value.get<A0>().setValue(rand());
+			value.get<F5>().setValue(Varint32(static_cast<uint32_t>(rand())));
+			value.get<M7>().setValue(-rand());
+			auto buffer = serialize(value);
+
+			WideStructure dest;
+			MemoryStreamReader reader(buffer.data(), buffer.size());
+			BinaryDeserializer deserializer(&reader);
+			Assert::IsTrue(deserializer.deserialize(dest));
+			Assert::AreEqual(value.get<A0>().getValue(), dest.get<A0>().getValue());
+			Assert::IsTrue(value.get<F5>().getValue() == dest.get<F5>().getValue());
+			Assert::AreEqual(value.get<M7>().getValue(), dest.get<M7>().getValue());
+
+			MemoryStreamReader truncatedReader(buffer.data(), buffer.size() - 1);
+			BinaryDeserializer truncatedDeserializer(&truncatedReader);
+			Assert::IsFalse(truncatedDeserializer.deserialize(dest));
+		}
+
+		TEST_METHOD(OptionalBitmap) {
+			static_assert(maxSerializedSize<OptionalStructure>() == 2 + 10 * sizeof(int32_t), "Wrong maximum size");
+			OptionalStructure value;
+			value.get<A0>().setValue(1);
+			value.get<B1>().setValue(2);
+			value.get<C0>().setValue(3);
+			auto buffer = serialize(value);
+			const uint8_t expected[] = { 0x02, 0x01, 2, 0, 0, 0, 1, 0, 0, 0, 3, 0, 0, 0 };
+			Assert::IsTrue(buffer == std::vector<uint8_t>(expected, expected + sizeof(expected)));
+			Assert::AreEqual(buffer.size(), getSerializedSize(value));
+
+			OptionalStructure dest;
+			dest.get<B5>().setValue(5);
+			MemoryStreamReader reader(buffer.data(), buffer.size());
+			BinaryDeserializer deserializer(&reader);
+			Assert::IsTrue(deserializer.deserialize(dest));
+			Assert::IsFalse(dest.get<B0>().isExists());
+			Assert::IsFalse(dest.get<B5>().isExists());
+			Assert::AreEqual(2, dest.get<B1>().getValue());
+			Assert::AreEqual(1, dest.get<A0>().getValue());
+			Assert::AreEqual(3, dest.get<C0>().getValue());
+
+			MemoryStreamReader skipReader(buffer.data(), buffer.size());
+			BinaryDeserializer skipDeserializer(&skipReader);
+			Assert::IsTrue(skipDeserializer.skip<OptionalStructure>());
+			Assert::AreEqual(buffer.size(), skipReader.getPosition());
+		}
+	};
+}
@@ -0,0 +1,134 @@
+#include "stdafx.h"
+#include "CppUnitTest.h"
+
+#include <ctime>
+#include <vector>
+#include "AntilatencySerialization/Fields.h"
+#include "AntilatencySerialization/Structures.h"
+#include "AntilatencySerialization/BinarySerialization.h"
+#include "AntilatencySerialization/TrackedField.h"
+#include "AntilatencySerialization/DeltaSerialization.h"
+#include "AntilatencySerialization/GrowableMemoryStream.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+using namespace Antilatency::Serialization;
+
+namespace SerializationTest
+{
+	namespace TrackedFieldTestTypes {
+		SERIALIZATION_MAKE_FIELD_NAME(Frame);
+		SERIALIZATION_MAKE_FIELD_NAME(Speed);
+		SERIALIZATION_MAKE_FIELD_NAME(Name);
+		SERIALIZATION_MAKE_FIELD_NAME(Samples);
+
+		using State = Structure<
+			Int32Field<Frame>,
+			TrackedSingleField<float, Speed>,
+			TrackedField<StringField<Name>>,
+			TrackedVectorField<uint16_t, Samples>
+		>;
+	}
+
+	using namespace TrackedFieldTestTypes;
+
+	TEST_CLASS(TrackedFieldTest)
+	{
+		TEST_CLASS_INITIALIZE(Init) {
+			srand(static_cast<unsigned>(time(nullptr)));
+		}
+
+		static std::vector<uint8_t> serializeDirty(State& state) {
+			GrowableMemoryStreamWriter writer;
+			DirtyFieldSerializer serializer(&writer);
+			Assert::IsTrue(serializer.serialize(state));
+			return std::vector<uint8_t>(writer.data(), writer.data() + writer.size());
+		}
+
+		static std::vector<uint8_t> serialize(const State& state) {
+			GrowableMemoryStreamWriter writer;
+			BinarySerializer serializer(&writer);
+			Assert::IsTrue(serializer.serialize(state));
+			return std::vector<uint8_t>(writer.data(), writer.data() + writer.size());
+		}
+
+		static void apply(State& state, const std::vector<uint8_t>& data) {
+			MemoryStreamReader reader(data.data(), data.size());
+			DirtyFieldDeserializer deserializer(&reader);
+			Assert::IsTrue(deserializer.deserialize(state));
+			Assert::AreEqual(data.size(), reader.getPosition());
+		}
+
+	public:
+		TEST_METHOD(DirtyMask) {
+			State state;
+			Assert::AreEqual(static_cast<size_t>(4), getDirtyMask(state).count());
+			clearDirty(state);
+			auto mask = getDirtyMask(state);
+			Assert::IsTrue(mask.test(0));
+			Assert::AreEqual(static_cast<size_t>(1), mask.count());
+
+			state.get<Name>().setValue("name");
+			const State& constState = state;
+			Assert::AreEqual(static_cast<size_t>(0), constState.get<Samples>().getValue().size());
+			mask = getDirtyMask(state);
+			Assert::IsTrue(mask.test(2));
+			Assert::IsFalse(mask.test(3));
+
+			state.get<Samples>().getValue().push_back(1);
+			Assert::IsTrue(getDirtyMask(state).test(3));
+		}
+
+		TEST_METHOD(OnlyDirtyFieldsWritten) {
+			State sender;
+			sender.get<Samples>().getValue().assign(5000, 7);
+			State receiver;
+			apply(receiver, serializeDirty(sender));
+			Assert::IsTrue(serialize(sender) == serialize(receiver));
+			Assert::IsFalse(getDirtyMask(sender).test(3));
+
+			for (int tick = 0; tick < 100; ++tick) {
+				sender.get<Frame>().setValue(tick);
+				if (rand() % 2) {
+					sender.get<Speed>().setValue(static_cast<float>(rand()));
+				}
+				if (rand() % 10 == 0) {
+					sender.get<Samples>().getValue()[rand() % 5000] = static_cast<uint16_t>(rand());
+				}
+				auto samplesDirty = getDirtyMask(sender).test(3);
+				auto data = serializeDirty(sender);
+				Assert::IsTrue(samplesDirty ? data.size() > 10000 : data.size() < 100);
+				apply(receiver, data);
+				Assert::IsTrue(serialize(sender) == serialize(receiver));
+			}
+
+			sender.get<Frame>().setValue(1);
+			//Count, then index and value of the untracked Frame
+			Assert::AreEqual(static_cast<size_t>(1 + 1 + 4), serializeDirty(sender).size());
+		}
+
+		TEST_METHOD(RejectBrokenIndex) {
+			const uint8_t data[] = { 1, 9, 0 };
+			MemoryStreamReader reader(data, sizeof(data));
+			DirtyFieldDeserializer deserializer(&reader);
+			State state;
+			Assert::IsFalse(deserializer.deserialize(state));
+		}
+
+		TEST_METHOD(DeltaMarksDirty) {
+			State previous;
+			State next = previous;
+			next.get<Speed>().setValue(2.0f);
+			GrowableMemoryStreamWriter writer;
+			DeltaSerializer serializer(&writer);
+			Assert::IsTrue(serializer.serialize(next, previous));
+
+			clearDirty(previous);
+			MemoryStreamReader reader(writer.data(), writer.size());
+			DeltaDeserializer deserializer(&reader);
+			Assert::IsTrue(deserializer.deserialize(previous));
+			Assert::IsTrue(getDirtyMask(previous).test(1));
+			Assert::IsFalse(getDirtyMask(previous).test(2));
+		}
+	};
+}
@@ -9,6 +9,7 @@ using namespace Microsoft::VisualStudio::CppUnitTestFramework;
 
 #include "AntilatencySerialization/Varint.h"
 #include "AntilatencySerialization/BinarySerialization.h"
+#include "AntilatencySerialization/UserStream.h"
 
 using namespace Antilatency::Serialization;
 
@@ -111,6 +112,77 @@ namespace SerializationTest
 			testMin<uint64_t>();
 		}
 
+		template<typename VarintType>
+		static void testStreamValue(typename VarintType::Type value) {
+			uint8_t buffer[32];
+			MemoryStreamWriter writer(buffer, sizeof(buffer));
+			BinarySerializer serializer(&writer);
+			VarintType source{ value };
+			Assert::IsTrue(serializer.serialize(source));
+
+			MemoryStreamReader memoryReader(buffer, sizeof(buffer));
+			UserStreamReader reader([&memoryReader](uint8_t* data, size_t size) {
+				return memoryReader.read(data, size);
+			});
+			BinaryDeserializer deserializer(&reader);
+			VarintType dest;
+			Assert::IsTrue(deserializer.deserialize(dest));
+			if (dest.getValue() != value) {
+				Assert::Fail();
+			}
+		}
+
+		TEST_METHOD(NotMemoryStream) {
+			for (size_t i = 0; i < 1000; ++i) {
+				testStreamValue<Varint32>(std::rand());
+				testStreamValue<Varint64>((static_cast<uint64_t>(std::rand()) << 32) | std::rand());
+				testStreamValue<Varint<int32_t>>(std::rand() - RAND_MAX / 2);
+			}
+			testStreamValue<Varint64>(std::numeric_limits<uint64_t>::max());
+		}
+
+		TEST_METHOD(ExactSizeBuffer) {
+			for (size_t shift = 0; shift < 64; ++shift) {
+				uint64_t value = static_cast<uint64_t>(1) << shift;
+				uint8_t buffer[Varint64::maxSize];
+				MemoryStreamWriter writer(buffer, sizeof(buffer));
+				BinarySerializer serializer(&writer);
+				Assert::IsTrue(serializer.serialize(Varint64(value)));
+
+				auto size = Varint64(value).getActualSize();
+				MemoryStreamReader reader(buffer, size);
+				BinaryDeserializer deserializer(&reader);
+				Varint64 dest;
+				Assert::IsTrue(deserializer.deserialize(dest));
+				if (dest.getValue() != value) {
+					Assert::Fail();
+				}
+
+				MemoryStreamReader truncatedReader(buffer, size - 1);
+				BinaryDeserializer truncatedDeserializer(&truncatedReader);
+				Assert::IsFalse(truncatedDeserializer.deserialize(dest));
+			}
+		}
+
+		TEST_METHOD(Overlong) {
+			uint8_t buffer[16];
+			memset(buffer, 0x80, sizeof(buffer));
+			buffer[sizeof(buffer) - 1] = 0;
+
+			MemoryStreamReader reader(buffer, sizeof(buffer));
+			BinaryDeserializer deserializer(&reader);
+			Varint32 dest32;
+			Assert::IsFalse(deserializer.deserialize(dest32));
+
+			MemoryStreamReader memoryReader(buffer, sizeof(buffer));
+			UserStreamReader userReader([&memoryReader](uint8_t* data, size_t size) {
+				return memoryReader.read(data, size);
+			});
+			BinaryDeserializer userDeserializer(&userReader);
+			Varint64 dest64;
+			Assert::IsFalse(userDeserializer.deserialize(dest64));
+		}
+
 		TEST_METHOD(MaxValuesSize) {
 			Varint32 val32{ std::numeric_limits<uint32_t>::max() };
 			Varint64 val64{ std::numeric_limits<uint64_t>::max() };
@@ -65,6 +65,27 @@ namespace SerializationTest
 			testValue(var);
 		}
 
+		TEST_METHOD(Float) {
+			std::vector<float> var;
+			for (int i = 0; i < rand() % 1000; ++i) {
+				var.push_back(static_cast<float>(rand()) / 7.0f);
+			}
+			testValue(var);
+		}
+
+		TEST_METHOD(TruncatedNative) {
+			std::vector<int16_t> var = { 1, 2, 3, 4 };
+			uint8_t buffer[32];
+			MemoryStreamWriter writer(buffer, sizeof(buffer));
+			BinarySerializer serializer(&writer);
+			Assert::IsTrue(serializer.serialize(var));
+
+			MemoryStreamReader reader(buffer, 1 + sizeof(int16_t) * var.size() - 1);
+			BinaryDeserializer deserializer(&reader);
+			std::vector<int16_t> dest;
+			Assert::IsFalse(deserializer.deserialize(dest));
+		}
+
 		TEST_METHOD(Inc) {
 			std::vector<int> var;
 			for(int i = 0; i < rand() % 1000; ++i) {
@@ -88,5 +109,31 @@ namespace SerializationTest
 			auto size = serializer.serialize(var);
 			testValue(var);
 		}
+
+		TEST_METHOD(StaticDispatch) {
+			std::vector<std::vector<int32_t>> var = { {1, 2, 3}, {}, {rand(), rand()} };
+
+			MemorySizeCounterStream counterStream;
+			BasicBinarySerializer<MemorySizeCounterStream> counter(&counterStream);
+			Assert::IsTrue(counter.serialize(var));
+
+			std::vector<uint8_t> staticBuffer(counterStream.getActualSize());
+			MemoryStreamWriter staticWriter(staticBuffer.data(), staticBuffer.size());
+			BasicBinarySerializer<MemoryStreamWriter> staticSerializer(&staticWriter);
+			Assert::IsTrue(staticSerializer.serialize(var));
+
+			std::vector<uint8_t> virtualBuffer(counterStream.getActualSize());
+			MemoryStreamWriter virtualWriter(virtualBuffer.data(), virtualBuffer.size());
+			BinarySerializer virtualSerializer(&virtualWriter);
+			Assert::IsTrue(virtualSerializer.serialize(var));
+
+			Assert::IsTrue(staticBuffer == virtualBuffer);
+
+			MemoryStreamReader reader(staticBuffer.data(), staticBuffer.size());
+			BasicBinaryDeserializer<MemoryStreamReader> deserializer(&reader);
+			std::vector<std::vector<int32_t>> dest;
+			Assert::IsTrue(deserializer.deserialize(dest));
+			Assert::IsTrue(var == dest);
+		}
 	};
 }
\ No newline at end of file
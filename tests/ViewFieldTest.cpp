@@ -0,0 +1,126 @@
+#include "stdafx.h"
+#include "CppUnitTest.h"
+#include <array>
+
+#include <ctime>
+#include <vector>
+#include "AntilatencySerialization/Fields.h"
+#include "AntilatencySerialization/Structures.h"
+#include "AntilatencySerialization/BinarySerialization.h"
+#include "AntilatencySerialization/UserStream.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+using namespace Antilatency::Serialization;
+
+namespace SerializationTest
+{
+	TEST_CLASS(ViewFieldTest)
+	{
+		TEST_CLASS_INITIALIZE(Init) {
+			srand(static_cast<unsigned>(time(nullptr)));
+		}
+
+		SERIALIZATION_MAKE_FIELD_NAME(Text);
+		SERIALIZATION_MAKE_FIELD_NAME(Samples);
+
+		using OwningStructure = Structure<StringField<Text>, VectorField<uint8_t, Samples>>;
+		using ViewStructure = Structure<StringViewField<Text>, SpanField<uint8_t, Samples>>;
+
+		static std::vector<uint8_t> serialize(const OwningStructure& value) {
+			MemorySizeCounterStream counterStream;
+			BinarySerializer counter(&counterStream);
+			counter.serialize(value);
+			std::vector<uint8_t> result(counterStream.getActualSize());
+			MemoryStreamWriter writer(result.data(), result.size());
+			BinarySerializer serializer(&writer);
+			serializer.serialize(value);
+			return result;
+		}
+
+		static OwningStructure makeSource() {
+			OwningStructure source;
+			//Any text length, the samples are viewed at whatever offset it leaves
+			source.get<Text>().setValue(std::string(rand() % 20, 't'));
+			for (int i = 0; i < rand() % 100; ++i) {
+				source.get<Samples>().getValue().push_back(static_cast<uint8_t>(rand()));
+			}
+			return source;
+		}
+
+	public:
+		TEST_METHOD(ReadView) {
+			auto source = makeSource();
+			auto buffer = serialize(source);
+
+			MemoryStreamReader reader(buffer.data(), buffer.size());
+			BinaryDeserializer deserializer(&reader);
+			ViewStructure view;
+			Assert::IsTrue(deserializer.deserialize(view));
+
+			auto& text = view.get<Text>().getValue();
+			Assert::IsTrue(source.get<Text>().getValue() == std::string(text.data(), text.size()));
+			Assert::IsTrue(text.data() >= reinterpret_cast<const char*>(buffer.data()));
+			Assert::IsTrue(text.end() <= reinterpret_cast<const char*>(buffer.data() + buffer.size()));
+
+			auto& samples = view.get<Samples>().getValue();
+			auto& sourceSamples = source.get<Samples>().getValue();
+			Assert::AreEqual(sourceSamples.size(), samples.size());
+			Assert::IsTrue(std::equal(samples.begin(), samples.end(), sourceSamples.begin()));
+		}
+
+		TEST_METHOD(AnyOffset) {
+			auto source = makeSource();
+			source.get<Samples>().getValue().push_back(1);
+			for (size_t length = 0; length < 8; ++length) {
+				source.get<Text>().setValue(std::string(length, 't'));
+				auto buffer = serialize(source);
+
+				MemoryStreamReader reader(buffer.data(), buffer.size());
+				BinaryDeserializer deserializer(&reader);
+				ViewStructure view;
+				Assert::IsTrue(deserializer.deserialize(view));
+				auto& samples = view.get<Samples>().getValue();
+				Assert::AreEqual(source.get<Samples>().getValue().size(), samples.size());
+				Assert::IsTrue(std::equal(samples.begin(), samples.end(), source.get<Samples>().getValue().begin()));
+			}
+		}
+
+		TEST_METHOD(WriteView) {
+			auto source = makeSource();
+			auto& sourceText = source.get<Text>().getValue();
+			auto& sourceSamples = source.get<Samples>().getValue();
+			ViewStructure view;
+			view.get<Text>().setValue(StringView(sourceText.data(), sourceText.size()));
+			view.get<Samples>().setValue(Span<uint8_t>(sourceSamples.data(), sourceSamples.size()));
+
+			std::vector<uint8_t> buffer(serialize(source).size());
+			MemoryStreamWriter writer(buffer.data(), buffer.size());
+			BinarySerializer serializer(&writer);
+			Assert::IsTrue(serializer.serialize(view));
+			Assert::IsTrue(serialize(source) == buffer);
+		}
+
+		TEST_METHOD(Truncated) {
+			auto source = makeSource();
+			source.get<Samples>().getValue().push_back(1);
+			auto buffer = serialize(source);
+
+			MemoryStreamReader reader(buffer.data(), buffer.size() - 1);
+			BinaryDeserializer deserializer(&reader);
+			ViewStructure view;
+			Assert::IsFalse(deserializer.deserialize(view));
+		}
+
+		TEST_METHOD(NotMemoryStream) {
+			auto buffer = serialize(makeSource());
+			MemoryStreamReader memoryReader(buffer.data(), buffer.size());
+			UserStreamReader userReader([&memoryReader](uint8_t* data, size_t size) {
+				return memoryReader.read(data, size);
+			});
+			BinaryDeserializer deserializer(&userReader);
+			ViewStructure view;
+			Assert::IsFalse(deserializer.deserialize(view));
+		}
+	};
+}